@@ -0,0 +1,1509 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2016 Michael Catanzaro <michael.catanzaro@mst.edu>
+ * Copyright (c) 2016 Jacob Fischer <jtf3m8@mst.edu>
+ * Copyright (c) 2016 Christian Storer <cs9yb@mst.edu>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "polynomial.h"
+
+#include "aes-sbox.h"
+#include "batch-inverse.h"
+#include "crc.h"
+#include "field-matrix.h"
+#include "field-polynomial.h"
+#include "field-vector.h"
+#include "gf.h"
+#include "irreducible.h"
+#include "parallel.h"
+#include "reed-solomon.h"
+#include "region.h"
+#include "shamir.h"
+#include "thread-pool.h"
+#include "wide-polynomial.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+using namespace multinv;
+
+// Micro-benchmarks for libmultinv. Run with no arguments to run everything,
+// or pass one or more substrings to run only the benchmarks whose names
+// contain them, e.g. `bench-multinv /inverse/euclid`. --json=FILE saves the
+// results, and --baseline=FILE compares them against results saved earlier;
+// `make bench` does both.
+
+// One irreducible polynomial for each characteristic we support.
+static const uint16_t irreducible_polynomials[] = {
+    0, 0b11, 0b111, 0b1011, 0b10011, 0b100101, 0b1000011, 0b10000011, 0b100011011
+};
+
+// Results get XORed in here so the compiler can't optimize the work away.
+static volatile uint8_t sink;
+
+// The time stamp counter, where there is one. It ticks at a constant rate
+// that's usually close to the CPU's nominal clock, so these are reference
+// cycles rather than core cycles, but they're what everybody else reports.
+static inline uint64_t timestamp() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+struct Result {
+    std::string name;
+    int characteristic;
+    double ns_per_op;
+    double cycles_per_op;
+    double bytes_per_second;
+    // The median absolute deviation of the samples, relative to the median.
+    double spread;
+};
+
+// Everything measured so far, for --json and --baseline.
+static std::vector<Result> results;
+
+// Substrings from the command line. Only benchmarks whose names contain one
+// of them are measured; with none, everything is.
+static std::vector<const char*> filters;
+
+// When not empty, exactly the benchmarks to measure, filters or not. For
+// taking a second look at suspected regressions.
+static std::set<std::pair<std::string, int>> remeasure;
+
+static bool selected(const char* name, int characteristic) {
+    if (!remeasure.empty())
+        return remeasure.count(std::make_pair(std::string{name}, characteristic)) > 0;
+    if (filters.empty())
+        return true;
+    for (const char* filter : filters) {
+        if (std::strstr(name, filter))
+            return true;
+    }
+    return false;
+}
+
+static double median(std::vector<double> values) {
+    std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+    return values[values.size() / 2];
+}
+
+// Warms up for 10 ms, then times several samples of pass() of at least 15 ms
+// each, and reports the median time and cycles taken by each of the
+// ops_per_pass operations performed by one pass. The median shrugs off the
+// odd sample that got interrupted; the spread says how much the rest
+// disagreed. If each op processes bytes_per_op bytes, throughput is reported
+// too.
+template <typename Pass>
+static void measure(const char* name, int characteristic, unsigned int ops_per_pass, Pass&& pass,
+                    unsigned int bytes_per_op = 0) {
+    using Clock = std::chrono::steady_clock;
+
+    if (!selected(name, characteristic))
+        return;
+
+    // Warm up caches, branch predictors and the clock speed. Operations so
+    // slow that one pass blows through the warm-up get fewer samples.
+    auto start = Clock::now();
+    unsigned int samples = 7;
+    pass();
+    if (Clock::now() - start > std::chrono::milliseconds(50))
+        samples = 3;
+    while (Clock::now() - start < std::chrono::milliseconds(10))
+        pass();
+
+    // Batches of passes between looks at the clock, starting small so that
+    // slow operations don't run for ages.
+    std::vector<double> ns(samples);
+    std::vector<double> cycles(samples);
+    unsigned long batch = 1;
+    for (unsigned int sample = 0; sample < samples; ++sample) {
+        unsigned long passes = 0;
+        uint64_t start_cycles = timestamp();
+        start = Clock::now();
+        std::chrono::nanoseconds elapsed;
+        do {
+            for (unsigned long i = 0; i < batch; ++i)
+                pass();
+            passes += batch;
+            batch = std::min(batch * 2, 16ul);
+            elapsed = Clock::now() - start;
+        } while (elapsed < std::chrono::milliseconds(15));
+
+        double ops = static_cast<double>(passes) * ops_per_pass;
+        ns[sample] = static_cast<double>(elapsed.count()) / ops;
+        cycles[sample] = static_cast<double>(timestamp() - start_cycles) / ops;
+    }
+
+    Result result;
+    result.name = name;
+    result.characteristic = characteristic;
+    result.ns_per_op = median(ns);
+    result.cycles_per_op = median(cycles);
+    result.bytes_per_second = bytes_per_op ? bytes_per_op * 1e9 / result.ns_per_op : 0;
+    std::vector<double> deviations;
+    for (double sample : ns)
+        deviations.push_back(std::fabs(sample - result.ns_per_op));
+    result.spread = median(deviations) / result.ns_per_op;
+    results.push_back(result);
+
+    std::printf("%-32s GF(2^%d) %12.1f ns/op %12.1f cycles/op +/-%4.1f%%",
+                name, characteristic, result.ns_per_op, result.cycles_per_op, 100 * result.spread);
+    if (bytes_per_op)
+        std::printf(" %10.2f GB/s", result.bytes_per_second / 1e9);
+    std::printf("\n");
+    std::fflush(stdout);
+}
+
+static void multiply_bitwise() {
+    for (int n = 1; n <= 8; ++n) {
+        uint16_t ip = irreducible_polynomials[n];
+        unsigned int elements = 1u << n;
+        measure("/multiply/bitwise", n, elements * elements, [=] {
+            uint8_t result = 0;
+            for (unsigned int a = 0; a < elements; ++a) {
+                for (unsigned int b = 0; b < elements; ++b)
+                    result ^= multinv::multiply_bitwise(a, b, ip, n);
+            }
+            sink ^= result;
+        });
+    }
+}
+
+static void multiply_constant_time() {
+    for (int n = 1; n <= 8; ++n) {
+        uint16_t ip = irreducible_polynomials[n];
+        unsigned int elements = 1u << n;
+        measure("/multiply/constant-time", n, elements * elements, [=] {
+            uint8_t result = 0;
+            for (unsigned int a = 0; a < elements; ++a) {
+                for (unsigned int b = 0; b < elements; ++b)
+                    result ^= multinv::multiply_constant_time(a, b, ip, n);
+            }
+            sink ^= result;
+        });
+    }
+}
+
+static void multiply_polynomial() {
+    for (int n = 1; n <= 8; ++n) {
+        uint16_t ip = irreducible_polynomials[n];
+        unsigned int elements = 1u << n;
+        measure("/multiply/polynomial", n, elements * elements, [=] {
+            uint8_t result = 0;
+            for (unsigned int a = 0; a < elements; ++a) {
+                Polynomial p{static_cast<uint8_t>(a), ip, n};
+                for (unsigned int b = 0; b < elements; ++b)
+                    result ^= (p * Polynomial{static_cast<uint8_t>(b), ip, n}).value();
+            }
+            sink ^= result;
+        });
+    }
+}
+
+// Dot products, reducing after every multiplication the way operator*= does,
+// and with operator*: summing unreduced products and reducing once at the end.
+static void multiply_fused() {
+    const size_t len = 64;
+    for (int n : { 3, 8 }) {
+        uint16_t ip = irreducible_polynomials[n];
+        std::vector<Polynomial> a, b;
+        for (size_t i = 0; i < len; ++i) {
+            a.emplace_back(static_cast<uint8_t>((i * 167 + 13) & ((1u << n) - 1)), ip, n);
+            b.emplace_back(static_cast<uint8_t>((i * 29 + 101) & ((1u << n) - 1)), ip, n);
+        }
+
+        measure("/multiply/fused/eager", n, len, [&] {
+            Polynomial sum{0, ip, n};
+            for (size_t i = 0; i < len; ++i) {
+                Polynomial product = a[i];
+                product *= b[i];
+                sum += product;
+            }
+            sink ^= sum.value();
+        });
+        measure("/multiply/fused/lazy", n, len, [&] {
+            UnreducedPolynomial sum{0, ip, n};
+            for (size_t i = 0; i < len; ++i)
+                sum += a[i] * b[i];
+            sink ^= sum.reduce().value();
+        });
+        measure("/multiply/fused/expression", n, len, [&] {
+            uint8_t result = 0;
+            for (size_t i = 0; i + 3 <= len; i += 3) {
+                Polynomial sum = a[i] * b[i] + a[i + 1] * b[i + 1] + a[i + 2] * b[i + 2];
+                result ^= sum.value();
+            }
+            sink ^= result;
+        });
+    }
+}
+
+// The AES field, the slow way and the compile-time way. Start from a value
+// the compiler can't see so it can't precompute the whole loop.
+static void multiply_aes_polynomial() {
+    uint8_t start = sink;
+    measure("/multiply/aes/polynomial", 8, 256 * 256, [=] {
+        uint8_t result = 0;
+        for (unsigned int a = 0; a < 256; ++a) {
+            Polynomial p{static_cast<uint8_t>(a + start)};
+            for (unsigned int b = 0; b < 256; ++b)
+                result ^= (p * Polynomial{static_cast<uint8_t>(b)}).value();
+        }
+        sink ^= result;
+    });
+}
+
+static void multiply_aes_gf() {
+    uint8_t start = sink;
+    measure("/multiply/aes/gf", 8, 256 * 256, [=] {
+        uint8_t result = 0;
+        for (unsigned int a = 0; a < 256; ++a) {
+            GF256 x{static_cast<uint8_t>(a + start)};
+            for (unsigned int b = 0; b < 256; ++b)
+                result ^= (x * GF256{static_cast<uint8_t>(b)}).value();
+        }
+        sink ^= result;
+    });
+}
+
+static void inverse_aes_gf() {
+    uint8_t start = sink;
+    measure("/inverse/aes/gf", 8, 255, [=] {
+        uint8_t result = 0;
+        for (unsigned int a = 1; a < 256; ++a) {
+            uint8_t value = static_cast<uint8_t>(a + start);
+            result ^= multiplicative_inverse(GF256{value ? value : uint8_t{1}}).value();
+        }
+        sink ^= result;
+    });
+}
+
+static const struct {
+    RegionKernel kernel;
+    const char* name;
+} region_kernels[] = {
+    { RegionKernel::Scalar, "scalar" },
+    { RegionKernel::SSSE3, "ssse3" },
+    { RegionKernel::AVX2, "avx2" },
+    { RegionKernel::GFNI, "gfni" },
+};
+
+// Runs a region operation over a 64 KiB buffer with every supported kernel,
+// naming each one path/kernel.
+template <typename Operation>
+static void bench_region(const char* path, int characteristic, Operation&& op) {
+    const unsigned int len = 64 * 1024;
+    std::vector<uint8_t> src(len);
+    std::vector<uint8_t> dst(len);
+    for (unsigned int i = 0; i < len; ++i)
+        src[i] = static_cast<uint8_t>((i * 167 + 13) & ((1u << characteristic) - 1));
+
+    RegionKernel original = region_kernel();
+    for (const auto& kernel : region_kernels) {
+        if (!set_region_kernel(kernel.kernel))
+            continue;
+
+        char name[64];
+        std::snprintf(name, sizeof(name), "%s/%s", path, kernel.name);
+        measure(name, characteristic, 1, [&] {
+            op(dst.data(), src.data(), len);
+            sink ^= dst[len - 1];
+        }, len);
+    }
+    set_region_kernel(original);
+}
+
+static void region_multiply() {
+    for (int n : { 4, 8 }) {
+        uint16_t ip = irreducible_polynomials[n];
+        bench_region("/region/multiply", n, [=](uint8_t* dst, const uint8_t* src, size_t len) {
+            gf_mul_region(dst, src, 0x7, len, ip, n);
+        });
+    }
+}
+
+static void region_multiply_add() {
+    for (int n : { 4, 8 }) {
+        uint16_t ip = irreducible_polynomials[n];
+        bench_region("/region/multiply-add", n, [=](uint8_t* dst, const uint8_t* src, size_t len) {
+            gf_mul_add_region(dst, src, 0x7, len, ip, n);
+        });
+        // Plain addition, which is what most of an identity-like matrix is.
+        bench_region("/region/multiply-add/one", n, [=](uint8_t* dst, const uint8_t* src, size_t len) {
+            gf_mul_add_region(dst, src, 0x1, len, ip, n);
+        });
+    }
+}
+
+static void region_inverse() {
+    for (int n : { 4, 8 }) {
+        uint16_t ip = irreducible_polynomials[n];
+        bench_region("/region/inverse", n, [=](uint8_t* dst, const uint8_t* src, size_t len) {
+            gf_inverse_region(dst, src, len, ip, n);
+        });
+    }
+}
+
+// What the region functions replace: one Polynomial multiplication per byte.
+static void region_multiply_polynomial() {
+    const unsigned int len = 64 * 1024;
+    std::vector<uint8_t> src(len);
+    std::vector<uint8_t> dst(len);
+    for (unsigned int i = 0; i < len; ++i)
+        src[i] = static_cast<uint8_t>(i * 167 + 13);
+
+    Polynomial constant{0x7};
+    measure("/region/multiply/polynomial", 8, 1, [&] {
+        for (unsigned int i = 0; i < len; ++i)
+            dst[i] = (Polynomial{src[i]} * constant).value();
+        sink ^= dst[len - 1];
+    }, len);
+}
+
+// The bitsliced (or GFNI) S-box against the usual 256-byte table, which is
+// fast but indexes memory with secret data.
+static void aes_sbox() {
+    bench_region("/aes-sbox/sub-bytes", 8, aes_sub_bytes);
+    bench_region("/aes-sbox/inv-sub-bytes", 8, aes_inv_sub_bytes);
+
+    uint8_t table[256];
+    for (unsigned int i = 0; i < 256; ++i)
+        table[i] = static_cast<uint8_t>(i);
+    aes_sub_bytes(table, table, 256);
+
+    const unsigned int len = 64 * 1024;
+    std::vector<uint8_t> src(len);
+    std::vector<uint8_t> dst(len);
+    for (unsigned int i = 0; i < len; ++i)
+        src[i] = static_cast<uint8_t>(i * 167 + 13);
+
+    measure("/aes-sbox/sub-bytes/table", 8, 1, [&] {
+        for (unsigned int i = 0; i < len; ++i)
+            dst[i] = table[src[i]];
+        sink ^= dst[len - 1];
+    }, len);
+}
+
+static const struct {
+    ClmulKernel kernel;
+    const char* name;
+} clmul_kernels[] = {
+    { ClmulKernel::Portable, "portable" },
+    { ClmulKernel::PCLMULQDQ, "pclmulqdq" },
+};
+
+// Multiplies and inverts a chain of elements, so each op depends on the last
+// and we measure latency rather than letting the CPU overlap everything.
+template <typename Word>
+static void bench_wide() {
+    using P = WidePolynomial<Word>;
+    const int n = P::characteristic();
+
+    ClmulKernel original = clmul_kernel();
+    for (const auto& kernel : clmul_kernels) {
+        if (!set_clmul_kernel(kernel.kernel))
+            continue;
+
+        char name[64];
+        std::snprintf(name, sizeof(name), "/wide/multiply/%s", kernel.name);
+        P x{static_cast<Word>(0x1234567 + sink)};
+        measure(name, n, 1000, [&] {
+            P y = x;
+            for (int i = 0; i < 1000; ++i)
+                y *= x;
+            sink ^= static_cast<uint8_t>(y.value());
+        }, sizeof(Word));
+
+        std::snprintf(name, sizeof(name), "/wide/inverse/%s", kernel.name);
+        measure(name, n, 100, [&] {
+            P y = x;
+            for (int i = 0; i < 100; ++i)
+                y = multiplicative_inverse(y + P{1});
+            sink ^= static_cast<uint8_t>(y.value());
+        }, sizeof(Word));
+    }
+    set_clmul_kernel(original);
+}
+
+static void wide() {
+    bench_wide<uint16_t>();
+    bench_wide<uint32_t>();
+    bench_wide<uint64_t>();
+    bench_wide<uint128_t>();
+}
+
+static const struct {
+    CrcKernel kernel;
+    const char* name;
+} crc_kernels[] = {
+    { CrcKernel::Bytewise, "bytewise" },
+    { CrcKernel::Slicing8, "slicing8" },
+    { CrcKernel::Slicing16, "slicing16" },
+    { CrcKernel::PCLMULQDQ, "pclmulqdq" },
+};
+
+// Throughput of each kernel over 64 KiB, which is what matters for long
+// streams, and over 256 bytes, where the setup and the tail do. The
+// "characteristic" column is the width of the generator.
+static void crc() {
+    std::vector<uint8_t> data(64 * 1024);
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = static_cast<uint8_t>(i * 167 + 13);
+
+    const CrcParameters generators[] = {
+        { 8, 0x07, 0, false, false, 0 },
+        { 16, 0x1021, 0, true, true, 0 },
+        crc32_iso_hdlc,
+        crc32_bzip2,
+        crc64_xz,
+    };
+
+    CrcKernel original = crc_kernel();
+    for (const CrcParameters& parameters : generators) {
+        Crc crc(parameters);
+        const char* reflected = parameters.reflect_input ? "" : "/unreflected";
+
+        for (const auto& kernel : crc_kernels) {
+            if (!set_crc_kernel(kernel.kernel))
+                continue;
+
+            for (size_t len : { data.size(), size_t{256} }) {
+                char name[64];
+                std::snprintf(name, sizeof(name), "/crc/%s/%zu%s", kernel.name, len, reflected);
+                measure(name, parameters.width, 1, [&] {
+                    sink ^= static_cast<uint8_t>(crc.compute(data.data(), len));
+                }, len);
+            }
+        }
+
+        char name[64];
+        std::snprintf(name, sizeof(name), "/crc/combine%s", reflected);
+        measure(name, parameters.width, 1, [&] {
+            sink ^= static_cast<uint8_t>(crc.combine(sink, 0x1234, data.size() + sink));
+        });
+    }
+    set_crc_kernel(original);
+}
+
+// Montgomery's trick against inverting the same 4096 elements one at a time.
+template <typename Element>
+static void bench_batch_inverse(const std::vector<Element>& in, int characteristic) {
+    std::vector<Element> out(in);
+
+    measure("/batch-inverse/loop", characteristic, in.size(), [&] {
+        for (size_t i = 0; i < in.size(); ++i)
+            out[i] = multiplicative_inverse(in[i]);
+        sink ^= static_cast<uint8_t>(out[0].value());
+    });
+    measure("/batch-inverse/montgomery", characteristic, in.size(), [&] {
+        multiplicative_inverse_batch(in.data(), out.data(), in.size());
+        sink ^= static_cast<uint8_t>(out[0].value());
+    });
+}
+
+template <typename Word>
+static void bench_wide_batch_inverse() {
+    std::vector<WidePolynomial<Word>> in;
+    for (unsigned int i = 0; i < 4096; ++i)
+        in.emplace_back(static_cast<Word>(i * 0x9e3779b97f4a7c15ull + 1));
+    bench_batch_inverse(in, WidePolynomial<Word>::characteristic());
+}
+
+static void batch_inverse() {
+    std::vector<Polynomial> in;
+    for (unsigned int i = 0; i < 4096; ++i)
+        in.emplace_back(static_cast<uint8_t>(i % 255 + 1));
+    bench_batch_inverse(in, 8);
+
+    std::vector<uint8_t> bytes(in.size());
+    for (size_t i = 0; i < in.size(); ++i)
+        bytes[i] = in[i].value();
+    measure("/batch-inverse/bytes", 8, bytes.size(), [&] {
+        multiplicative_inverse_batch(bytes.data(), bytes.data(), bytes.size());
+        sink ^= bytes[0];
+    });
+
+    bench_wide_batch_inverse<uint16_t>();
+    bench_wide_batch_inverse<uint32_t>();
+    bench_wide_batch_inverse<uint64_t>();
+    bench_wide_batch_inverse<uint128_t>();
+}
+
+// How the parallel bulk operations scale from one thread to one per CPU.
+static void parallel_scaling() {
+    const unsigned int len = 64 * 1024 * 1024;
+    std::vector<uint8_t> src(len);
+    std::vector<uint8_t> dst(len);
+    for (unsigned int i = 0; i < len; ++i)
+        src[i] = static_cast<uint8_t>(i * 167 + 13);
+
+    const unsigned int count = 1 << 20;
+    std::vector<Polynomial64> elements;
+    for (unsigned int i = 0; i < count; ++i)
+        elements.emplace_back(i * 0x9e3779b97f4a7c15ull + 1);
+    std::vector<Polynomial64> inverses(elements);
+
+    const unsigned int size = 4096;
+
+    std::vector<unsigned int> thread_counts;
+    unsigned int cpus = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned int threads = 1; threads < cpus; threads *= 2)
+        thread_counts.push_back(threads);
+    thread_counts.push_back(cpus);
+
+    for (unsigned int threads : thread_counts) {
+        ThreadPool pool{threads};
+        char name[64];
+
+        std::snprintf(name, sizeof(name), "/parallel/multiply/%u-threads", threads);
+        measure(name, 8, 1, [&] {
+            parallel_mul_region(pool, dst.data(), src.data(), 0x53, len);
+            sink ^= dst[0];
+        }, len);
+
+        std::snprintf(name, sizeof(name), "/parallel/multiply-add/%u-threads", threads);
+        measure(name, 8, 1, [&] {
+            parallel_mul_add_region(pool, dst.data(), src.data(), 0x53, len);
+            sink ^= dst[0];
+        }, len);
+
+        std::snprintf(name, sizeof(name), "/parallel/batch-inverse/%u-threads", threads);
+        measure(name, 64, count, [&] {
+            parallel_inverse_batch(pool, elements.data(), inverses.data(), count);
+            sink ^= static_cast<uint8_t>(inverses[0].value());
+        }, sizeof(uint64_t));
+
+        std::snprintf(name, sizeof(name), "/parallel/matrix-vector/%u-threads", threads);
+        measure(name, 8, 1, [&] {
+            parallel_matrix_vector(pool, src.data(), size, size, src.data() + size * size, dst.data());
+            sink ^= dst[0];
+        }, size * size);
+    }
+}
+
+static void bench_inverse(const char* name, InverseStrategy strategy) {
+    for (int n = 1; n <= 8; ++n) {
+        uint16_t ip = irreducible_polynomials[n];
+        unsigned int elements = (1u << n) - 1;
+        measure(name, n, elements, [=] {
+            uint8_t result = 0;
+            for (unsigned int i = 1; i <= elements; ++i)
+                result ^= multiplicative_inverse(Polynomial{static_cast<uint8_t>(i), ip, n}, strategy).value();
+            sink ^= result;
+        });
+    }
+}
+
+static void inverse_table() {
+    bench_inverse("/inverse/table", InverseStrategy::Table);
+}
+
+static void inverse_brute_force() {
+    bench_inverse("/inverse/brute-force", InverseStrategy::BruteForce);
+}
+
+static void inverse_extended_euclid() {
+    bench_inverse("/inverse/extended-euclid", InverseStrategy::ExtendedEuclid);
+}
+
+static void inverse_itoh_tsujii() {
+    bench_inverse("/inverse/itoh-tsujii", InverseStrategy::ItohTsujii);
+}
+
+static void inverse_constant_time() {
+    bench_inverse("/inverse/constant-time", InverseStrategy::ConstantTime);
+}
+
+// Each of division, pow, square and sqrt against the obvious way of doing it
+// with the operations we had before.
+template <typename Operation>
+static void bench_binary(const char* name, Operation&& op) {
+    for (int n = 1; n <= 8; ++n) {
+        uint16_t ip = irreducible_polynomials[n];
+        unsigned int elements = 1u << n;
+        measure(name, n, elements * (elements - 1), [=] {
+            uint8_t result = 0;
+            for (unsigned int a = 0; a < elements; ++a) {
+                Polynomial p{static_cast<uint8_t>(a), ip, n};
+                for (unsigned int b = 1; b < elements; ++b)
+                    result ^= op(p, Polynomial{static_cast<uint8_t>(b), ip, n}).value();
+            }
+            sink ^= result;
+        });
+    }
+}
+
+template <typename Operation>
+static void bench_unary(const char* name, Operation&& op) {
+    for (int n = 1; n <= 8; ++n) {
+        uint16_t ip = irreducible_polynomials[n];
+        unsigned int elements = 1u << n;
+        measure(name, n, elements, [=] {
+            uint8_t result = 0;
+            for (unsigned int a = 0; a < elements; ++a)
+                result ^= op(Polynomial{static_cast<uint8_t>(a), ip, n}).value();
+            sink ^= result;
+        });
+    }
+}
+
+static void divide() {
+    bench_binary("/divide/polynomial", [](const Polynomial& p, const Polynomial& q) {
+        return p / q;
+    });
+    bench_binary("/divide/inverse-then-multiply", [](const Polynomial& p, const Polynomial& q) {
+        return p * multiplicative_inverse(q, InverseStrategy::BruteForce);
+    });
+}
+
+static void power() {
+    bench_binary("/pow/polynomial", [](const Polynomial& p, const Polynomial& q) {
+        return pow(p, q.value());
+    });
+    bench_binary("/pow/repeated-multiply", [](const Polynomial& p, const Polynomial& q) {
+        Polynomial result{1, p.irreducible_polynomial(), p.characteristic()};
+        for (unsigned int i = 0; i < q.value(); ++i)
+            result *= p;
+        return result;
+    });
+}
+
+static void bench_square() {
+    bench_unary("/square/polynomial", [](const Polynomial& p) {
+        return square(p);
+    });
+    bench_unary("/square/multiply", [](const Polynomial& p) {
+        return p * p;
+    });
+}
+
+static void square_root() {
+    bench_unary("/sqrt/polynomial", [](const Polynomial& p) {
+        return sqrt(p);
+    });
+    bench_unary("/sqrt/repeated-squaring", [](const Polynomial& p) {
+        Polynomial result = p;
+        for (int i = 1; i < p.characteristic(); ++i)
+            result *= result;
+        return result;
+    });
+}
+
+// Multiplies two polynomials with len coefficients each over GF(2^8), with
+// each algorithm, for len doubling from 8 until each one gets too slow to
+// bother with. Shows where the crossovers are.
+static void field_polynomial_multiply() {
+    static const struct {
+        const char* name;
+        MultiplicationAlgorithm algorithm;
+        size_t max_len;
+    } algorithms[] = {
+        { "schoolbook", MultiplicationAlgorithm::Schoolbook, 1 << 15 },
+        { "karatsuba", MultiplicationAlgorithm::Karatsuba, 1 << 17 },
+        { "additive-fft", MultiplicationAlgorithm::AdditiveFFT, 1 << 17 },
+        { "automatic", MultiplicationAlgorithm::Automatic, 1 << 17 },
+    };
+
+    std::vector<uint8_t> coefficients(1 << 17);
+    for (size_t i = 0; i < coefficients.size(); ++i)
+        coefficients[i] = static_cast<uint8_t>(i * 167 + 13);
+
+    for (size_t len = 8; len <= 1 << 17; len *= 2) {
+        FieldPolynomial a(std::vector<uint8_t>(coefficients.begin(), coefficients.begin() + len));
+        FieldPolynomial b(std::vector<uint8_t>(coefficients.rbegin(), coefficients.rbegin() + len));
+        for (const auto& algorithm : algorithms) {
+            if (len > algorithm.max_len)
+                continue;
+            char name[64];
+            std::snprintf(name, sizeof(name), "/field-polynomial/multiply/%s/%zu", algorithm.name, len);
+            measure(name, 8, 1, [&] {
+                sink ^= multiply(a, b, algorithm.algorithm).coefficient(len);
+            });
+        }
+    }
+}
+
+// Pseudorandom, so almost certainly invertible.
+static FieldMatrix bench_matrix(size_t size, uint64_t seed) {
+    std::vector<uint8_t> elements(size * size);
+    for (uint8_t& element : elements) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        element = static_cast<uint8_t>(seed);
+    }
+    return FieldMatrix(size, size, std::move(elements));
+}
+
+// Square matrices, single-threaded and on every CPU, plus the obvious triple
+// loop over Polynomials while it's still bearable.
+static void field_matrix() {
+    ThreadPool& pool = ThreadPool::shared();
+
+    for (size_t size = 64; size <= 4096; size *= 2) {
+        FieldMatrix a = bench_matrix(size, 13);
+        FieldMatrix b = bench_matrix(size, 101);
+        char name[64];
+
+        if (size <= 256) {
+            std::snprintf(name, sizeof(name), "/field-matrix/multiply/polynomial/%zu", size);
+            FieldMatrix product(size, size);
+            measure(name, 8, 1, [&] {
+                for (size_t i = 0; i < size; ++i) {
+                    for (size_t j = 0; j < size; ++j) {
+                        Polynomial sum{0};
+                        for (size_t k = 0; k < size; ++k)
+                            sum += Polynomial{a.at(i, k)} * Polynomial{b.at(k, j)};
+                        product.set(i, j, sum.value());
+                    }
+                }
+                sink ^= product.at(0, 0);
+            });
+        }
+
+        std::snprintf(name, sizeof(name), "/field-matrix/multiply/%zu", size);
+        measure(name, 8, 1, [&] {
+            sink ^= multiply(a, b).at(0, 0);
+        });
+        std::snprintf(name, sizeof(name), "/field-matrix/multiply/threads/%zu", size);
+        measure(name, 8, 1, [&] {
+            sink ^= multiply(a, b, &pool).at(0, 0);
+        });
+
+        std::snprintf(name, sizeof(name), "/field-matrix/invert/%zu", size);
+        measure(name, 8, 1, [&] {
+            FieldMatrix inverse = a;
+            invert(inverse);
+            sink ^= inverse.at(0, 0);
+        });
+        std::snprintf(name, sizeof(name), "/field-matrix/invert/threads/%zu", size);
+        measure(name, 8, 1, [&] {
+            FieldMatrix inverse = a;
+            invert(inverse, &pool);
+            sink ^= inverse.at(0, 0);
+        });
+    }
+}
+
+// Throughput is data bytes in (encode) or data bytes recovered from (decode)
+// per second. Decoding loses the first m data shards, the worst case.
+static void field_vector() {
+    const size_t len = 64 * 1024;
+    for (int n : { 3, 8 }) {
+        uint16_t ip = irreducible_polynomials[n];
+        std::vector<uint8_t> elements(len);
+        for (size_t i = 0; i < len; ++i)
+            elements[i] = static_cast<uint8_t>((i * 167 + 13) & ((1u << n) - 1));
+
+        for (FieldVectorLayout layout : { FieldVectorLayout::Bytes, FieldVectorLayout::Packed }) {
+            const char* layout_name = layout == FieldVectorLayout::Bytes ? "bytes" : "packed";
+            FieldVector x(elements, ip, n, layout);
+            FieldVector v = x;
+            char name[64];
+
+            std::snprintf(name, sizeof(name), "/field-vector/get/%s", layout_name);
+            measure(name, n, len, [&] {
+                unsigned sum = 0;
+                for (uint8_t e : x)
+                    sum += e;
+                sink ^= sum;
+            });
+            std::snprintf(name, sizeof(name), "/field-vector/add/%s", layout_name);
+            measure(name, n, len, [&] {
+                v += x;
+                sink ^= v.data()[0];
+            });
+            std::snprintf(name, sizeof(name), "/field-vector/multiply/%s", layout_name);
+            measure(name, n, len, [&] {
+                v.multiply(0x5);
+                sink ^= v.data()[0];
+            });
+            std::snprintf(name, sizeof(name), "/field-vector/multiply-add/%s", layout_name);
+            measure(name, n, len, [&] {
+                v.multiply_add(0x5, x);
+                sink ^= v.data()[0];
+            });
+            std::snprintf(name, sizeof(name), "/field-vector/invert/%s", layout_name);
+            measure(name, n, len, [&] {
+                v.invert();
+                sink ^= v.data()[0];
+            });
+        }
+    }
+}
+
+static void reed_solomon() {
+    static const size_t codes[][2] = { { 4, 2 }, { 6, 3 }, { 10, 4 }, { 16, 4 }, { 32, 8 } };
+    static const size_t stripe_sizes[] = { 4096, 64 * 1024, 1024 * 1024 };
+
+    for (const auto& code : codes) {
+        size_t k = code[0];
+        size_t m = code[1];
+        ReedSolomon rs(k, m);
+
+        for (size_t stripe_size : stripe_sizes) {
+            std::vector<std::vector<uint8_t>> shards(k + m, std::vector<uint8_t>(stripe_size));
+            for (size_t i = 0; i < k; ++i) {
+                for (size_t j = 0; j < stripe_size; ++j)
+                    shards[i][j] = static_cast<uint8_t>(i * 31 + j * 7);
+            }
+            std::vector<uint8_t*> pointers;
+            for (auto& shard : shards)
+                pointers.push_back(shard.data());
+            std::vector<const uint8_t*> data(pointers.begin(), pointers.begin() + k);
+
+            char name[64];
+            std::snprintf(name, sizeof(name), "/reed-solomon/encode/%zu+%zu/%zuk", k, m, stripe_size / 1024);
+            measure(name, 8, 1, [&] {
+                rs.encode(data.data(), pointers.data() + k, stripe_size);
+            }, k * stripe_size);
+
+            std::unique_ptr<bool[]> present(new bool[k + m]);
+            for (size_t i = 0; i < k + m; ++i)
+                present[i] = i >= m;
+            std::snprintf(name, sizeof(name), "/reed-solomon/decode/%zu+%zu/%zuk", k, m, stripe_size / 1024);
+            measure(name, 8, 1, [&] {
+                rs.decode(pointers.data(), present.get(), stripe_size);
+            }, k * stripe_size);
+        }
+    }
+}
+
+// Not random at all, but it keeps split's numbers about the field arithmetic
+// rather than the kernel's random number generator.
+static void bench_random(uint8_t* buffer, size_t len) {
+    static thread_local uint64_t state = 0x9e3779b97f4a7c15;
+    for (size_t i = 0; i < len; i += 8) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        std::memcpy(buffer + i, &state, std::min<size_t>(8, len - i));
+    }
+}
+
+static void shamir() {
+    static const size_t schemes[][2] = { { 2, 3 }, { 3, 5 }, { 5, 8 }, { 10, 16 } };
+    static const size_t secret_sizes[] = { 4096, 64 * 1024, 1024 * 1024 };
+
+    for (const auto& scheme : schemes) {
+        size_t k = scheme[0];
+        size_t n = scheme[1];
+        ShamirSplitter splitter(k, n);
+        std::vector<uint8_t> xs(splitter.xs().begin(), splitter.xs().begin() + k);
+
+        for (size_t secret_size : secret_sizes) {
+            std::vector<uint8_t> secret(secret_size);
+            for (size_t j = 0; j < secret_size; ++j)
+                secret[j] = static_cast<uint8_t>(j * 7 + 3);
+            std::vector<std::vector<uint8_t>> shares(n, std::vector<uint8_t>(secret_size));
+            std::vector<uint8_t*> pointers;
+            for (auto& share : shares)
+                pointers.push_back(share.data());
+            std::vector<const uint8_t*> sources(pointers.begin(), pointers.begin() + k);
+            std::vector<uint8_t> recovered(secret_size);
+
+            char name[64];
+            std::snprintf(name, sizeof(name), "/shamir/split/%zu-of-%zu/%zuk", k, n, secret_size / 1024);
+            measure(name, 8, 1, [&] {
+                splitter.split(secret.data(), pointers.data(), secret_size, bench_random);
+                sink ^= shares[0][0];
+            }, secret_size);
+
+            // Including working out the Lagrange coefficients, since they
+            // depend on which shares turn up.
+            std::snprintf(name, sizeof(name), "/shamir/combine/%zu-of-%zu/%zuk", k, n, secret_size / 1024);
+            measure(name, 8, 1, [&] {
+                ShamirCombiner combiner(xs);
+                combiner.combine(sources.data(), recovered.data(), secret_size);
+                sink ^= recovered[0];
+            }, secret_size);
+
+            // Lagrange interpolation a byte at a time with Polynomial, the
+            // obvious way, for comparison.
+            if (secret_size == 4096) {
+                std::snprintf(name, sizeof(name), "/shamir/combine/polynomial/%zu-of-%zu/%zuk", k, n, secret_size / 1024);
+                measure(name, 8, 1, [&] {
+                    for (size_t b = 0; b < secret_size; ++b) {
+                        Polynomial sum{0};
+                        for (size_t i = 0; i < k; ++i) {
+                            Polynomial term{shares[i][b]};
+                            for (size_t j = 0; j < k; ++j) {
+                                if (j != i)
+                                    term *= Polynomial{xs[j]} * multiplicative_inverse(Polynomial{static_cast<uint8_t>(xs[i] ^ xs[j])});
+                            }
+                            sum += term;
+                        }
+                        recovered[b] = sum.value();
+                    }
+                    sink ^= recovered[0];
+                }, secret_size);
+            }
+        }
+    }
+}
+
+// Every basic operation in every field we support, one element at a time and
+// a buffer at a time, with a few irreducible polynomials per characteristic so
+// nothing is only fast for the polynomials we happen to test with. Names end
+// in the polynomial.
+static void field() {
+    const unsigned int len = 64 * 1024;
+    std::vector<uint8_t> src(len);
+    std::vector<uint8_t> dst(len);
+
+    for (int n = 1; n <= 8; ++n) {
+        std::vector<uint16_t> polynomials = { irreducible_polynomials[n] };
+        for (uint64_t polynomial : enumerate_irreducible_polynomials(n, 3)) {
+            uint16_t ip = static_cast<uint16_t>((1u << n) | polynomial);
+            if (std::find(polynomials.begin(), polynomials.end(), ip) == polynomials.end())
+                polynomials.push_back(ip);
+        }
+
+        const unsigned int elements = 1u << n;
+        const uint8_t constant = static_cast<uint8_t>((elements - 1) & 0x7);
+        for (unsigned int i = 0; i < len; ++i)
+            src[i] = static_cast<uint8_t>((i * 167 + 13) & (elements - 1));
+
+        for (uint16_t ip : polynomials) {
+            char name[64];
+
+            // In debug builds, this is mostly checking that ip is irreducible.
+            std::snprintf(name, sizeof(name), "/field/construct/%#x", ip);
+            measure(name, n, elements, [=] {
+                uint8_t result = 0;
+                for (unsigned int a = 0; a < elements; ++a)
+                    result ^= Polynomial{static_cast<uint8_t>(a), ip, n}.value();
+                sink ^= result;
+            });
+
+            std::snprintf(name, sizeof(name), "/field/add/%#x", ip);
+            measure(name, n, elements * elements, [=] {
+                uint8_t result = 0;
+                for (unsigned int a = 0; a < elements; ++a) {
+                    Polynomial p{static_cast<uint8_t>(a), ip, n};
+                    for (unsigned int b = 0; b < elements; ++b)
+                        result ^= (p + Polynomial{static_cast<uint8_t>(b), ip, n}).value();
+                }
+                sink ^= result;
+            });
+
+            std::snprintf(name, sizeof(name), "/field/multiply/%#x", ip);
+            measure(name, n, elements * elements, [=] {
+                uint8_t result = 0;
+                for (unsigned int a = 0; a < elements; ++a) {
+                    Polynomial p{static_cast<uint8_t>(a), ip, n};
+                    for (unsigned int b = 0; b < elements; ++b)
+                        result ^= (p * Polynomial{static_cast<uint8_t>(b), ip, n}).value();
+                }
+                sink ^= result;
+            });
+
+            std::snprintf(name, sizeof(name), "/field/inverse/%#x", ip);
+            measure(name, n, elements - 1, [=] {
+                uint8_t result = 0;
+                for (unsigned int a = 1; a < elements; ++a)
+                    result ^= multiplicative_inverse(Polynomial{static_cast<uint8_t>(a), ip, n}).value();
+                sink ^= result;
+            });
+
+            // Adding a buffer is multiplying it by one and adding.
+            std::snprintf(name, sizeof(name), "/field/region/add/%#x", ip);
+            measure(name, n, 1, [&] {
+                gf_mul_add_region(dst.data(), src.data(), 1, len, ip, n);
+                sink ^= dst[len - 1];
+            }, len);
+
+            std::snprintf(name, sizeof(name), "/field/region/multiply/%#x", ip);
+            measure(name, n, 1, [&] {
+                gf_mul_region(dst.data(), src.data(), constant, len, ip, n);
+                sink ^= dst[len - 1];
+            }, len);
+
+            std::snprintf(name, sizeof(name), "/field/region/inverse/%#x", ip);
+            measure(name, n, 1, [&] {
+                gf_inverse_region(dst.data(), src.data(), len, ip, n);
+                sink ^= dst[len - 1];
+            }, len);
+        }
+    }
+}
+
+// Testing random candidates, which is what searching mostly does: most of
+// them have a small factor, which Ben-Or finds early and Rabin doesn't.
+static void irreducible() {
+    const unsigned int count = 1024;
+    std::vector<uint64_t> candidates(count);
+    uint64_t state = 0x9e3779b97f4a7c15ull;
+    for (uint64_t& candidate : candidates) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        candidate = state;
+    }
+
+    for (int degree : { 8, 16, 32, 64 }) {
+        uint64_t mask = degree == 64 ? ~uint64_t{0} : (uint64_t{1} << degree) - 1;
+        char name[64];
+
+        std::snprintf(name, sizeof(name), "/irreducible/ben-or/%d", degree);
+        measure(name, degree, count, [&] {
+            for (uint64_t candidate : candidates)
+                sink ^= is_irreducible(candidate & mask, degree, IrreducibilityTest::BenOr);
+        });
+
+        std::snprintf(name, sizeof(name), "/irreducible/rabin/%d", degree);
+        measure(name, degree, count, [&] {
+            for (uint64_t candidate : candidates)
+                sink ^= is_irreducible(candidate & mask, degree, IrreducibilityTest::Rabin);
+        });
+    }
+
+    // Per polynomial found.
+    const size_t wanted = 256;
+    unsigned int cpus = std::max(1u, std::thread::hardware_concurrency());
+    ThreadPool pool{cpus};
+    for (int degree : { 32, 64 }) {
+        char name[64];
+
+        std::snprintf(name, sizeof(name), "/irreducible/search/%d/1-thread", degree);
+        measure(name, degree, wanted, [&] {
+            sink ^= static_cast<uint8_t>(enumerate_irreducible_polynomials(degree, wanted).back());
+        });
+
+        std::snprintf(name, sizeof(name), "/irreducible/search/%d/%u-threads", degree, cpus);
+        measure(name, degree, wanted, [&] {
+            sink ^= static_cast<uint8_t>(enumerate_irreducible_polynomials(degree, wanted, &pool).back());
+        });
+
+        std::snprintf(name, sizeof(name), "/irreducible/primitive-search/%d", degree);
+        measure(name, degree, wanted, [&] {
+            sink ^= static_cast<uint8_t>(enumerate_primitive_polynomials(degree, wanted, &pool).back());
+        });
+    }
+}
+
+// Logarithms and orders the obvious way, one multiplication at a time,
+// against the factored group order: Pohlig-Hellman and baby-step giant-step
+// for logarithms, and dividing out primes for orders. The exhaustive search
+// takes 2^n / 2 multiplications on average, so it stops at GF(2^20).
+static void discrete_log() {
+    for (int degree : { 8, 16, 20, 32, 49, 64 }) {
+        const FieldDescriptor* field = FieldDescriptor::get(find_irreducible_polynomial(degree), degree);
+        const uint64_t generator = field->generator();
+        const unsigned int count = degree > 32 ? 4 : 16;
+        std::vector<uint64_t> elements(count);
+        uint64_t state = 0x9e3779b97f4a7c15ull;
+        for (uint64_t& element : elements) {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            element = (state & field->order()) | 1;
+        }
+        char name[64];
+
+        if (degree <= 20) {
+            std::snprintf(name, sizeof(name), "/discrete-log/exhaustive/%d", degree);
+            measure(name, degree, count, [&] {
+                for (uint64_t element : elements) {
+                    uint64_t log = 0;
+                    for (uint64_t power = 1; power != element; ++log)
+                        power = field->multiply(power, generator);
+                    sink ^= static_cast<uint8_t>(log);
+                }
+            });
+
+            std::snprintf(name, sizeof(name), "/discrete-log/order/exhaustive/%d", degree);
+            measure(name, degree, count, [&] {
+                for (uint64_t element : elements) {
+                    uint64_t order = 1;
+                    for (uint64_t power = element; power != 1; ++order)
+                        power = field->multiply(power, element);
+                    sink ^= static_cast<uint8_t>(order);
+                }
+            });
+        }
+
+        std::snprintf(name, sizeof(name), "/discrete-log/pohlig-hellman/%d", degree);
+        measure(name, degree, count, [&] {
+            for (uint64_t element : elements)
+                sink ^= static_cast<uint8_t>(field->discrete_log(element));
+        });
+
+        std::snprintf(name, sizeof(name), "/discrete-log/order/factored/%d", degree);
+        measure(name, degree, count, [&] {
+            for (uint64_t element : elements)
+                sink ^= static_cast<uint8_t>(field->element_order(element));
+        });
+    }
+
+    // Where there are log tables, none of this is necessary.
+    std::vector<Polynomial> elements;
+    for (unsigned int i = 1; i < 256; ++i)
+        elements.emplace_back(static_cast<uint8_t>(i));
+    const Polynomial generator{3};
+    measure("/discrete-log/tables/8", 8, elements.size(), [&] {
+        for (const Polynomial& element : elements) {
+            unsigned int log = 0;
+            discrete_log(element, generator, log);
+            sink ^= static_cast<uint8_t>(log);
+        }
+    });
+}
+
+// Every group of benchmarks, in the order they run.
+static void (*const benchmarks[])() = {
+    field,
+    multiply_bitwise,
+    multiply_constant_time,
+    multiply_polynomial,
+    multiply_fused,
+    multiply_aes_polynomial,
+    multiply_aes_gf,
+    divide,
+    power,
+    bench_square,
+    square_root,
+    field_polynomial_multiply,
+    field_matrix,
+    field_vector,
+    reed_solomon,
+    shamir,
+    region_multiply_polynomial,
+    region_multiply,
+    region_multiply_add,
+    region_inverse,
+    aes_sbox,
+    wide,
+    crc,
+    batch_inverse,
+    parallel_scaling,
+    inverse_table,
+    inverse_aes_gf,
+    inverse_brute_force,
+    inverse_extended_euclid,
+    inverse_itoh_tsujii,
+    inverse_constant_time,
+    irreducible,
+    discrete_log,
+};
+
+// One benchmark per line, so read_baseline() can read it back without a
+// real JSON parser.
+static bool write_json(const char* path) {
+    FILE* file = std::fopen(path, "w");
+    if (!file)
+        return false;
+
+    std::fprintf(file, "{\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& result = results[i];
+        std::fprintf(file, "    {\"name\": \"%s\", \"characteristic\": %d, \"ns_per_op\": %.3f, "
+                     "\"cycles_per_op\": %.3f, \"bytes_per_second\": %.0f, \"spread\": %.4f}%s\n",
+                     result.name.c_str(), result.characteristic, result.ns_per_op, result.cycles_per_op,
+                     result.bytes_per_second, result.spread, i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(file, "  ]\n}\n");
+    return std::fclose(file) == 0;
+}
+
+struct BaselineResult {
+    double ns_per_op;
+    double spread;
+};
+
+using Baseline = std::map<std::pair<std::string, int>, BaselineResult>;
+
+// ns/op and spread for each benchmark in a file written by write_json().
+static Baseline read_baseline(const char* path) {
+    Baseline baseline;
+    FILE* file = std::fopen(path, "r");
+    if (!file)
+        return baseline;
+
+    char line[512];
+    while (std::fgets(line, sizeof(line), file)) {
+        char name[256];
+        int characteristic;
+        BaselineResult result;
+        double cycles, bytes;
+        int fields = std::sscanf(line, " {\"name\": \"%255[^\"]\", \"characteristic\": %d, \"ns_per_op\": %lf, "
+                                 "\"cycles_per_op\": %lf, \"bytes_per_second\": %lf, \"spread\": %lf",
+                                 name, &characteristic, &result.ns_per_op, &cycles, &bytes, &result.spread);
+        if (fields < 3)
+            continue;
+        if (fields < 6)
+            result.spread = 0;
+        baseline[std::make_pair(std::string{name}, characteristic)] = result;
+    }
+    std::fclose(file);
+    return baseline;
+}
+
+// Percent change from the baseline, or zero unless it's more than the
+// threshold and more than the noise: twice the spreads of both measurements
+// put together. A bigger spread than that, and any difference is as likely
+// to be the machine as the code.
+static double significant_change(const Result& result, const BaselineResult& base, double threshold) {
+    double change = 100 * (result.ns_per_op - base.ns_per_op) / base.ns_per_op;
+    double noise = 2 * (result.spread * result.ns_per_op + base.spread * base.ns_per_op);
+    if (std::fabs(change) <= threshold || std::fabs(result.ns_per_op - base.ns_per_op) <= noise)
+        return 0;
+    return change;
+}
+
+// What's slower than the baseline by a significant_change().
+static std::set<std::pair<std::string, int>> suspected_regressions(const Baseline& baseline, double threshold) {
+    std::set<std::pair<std::string, int>> suspects;
+    for (const Result& result : results) {
+        auto key = std::make_pair(result.name, result.characteristic);
+        auto it = baseline.find(key);
+        if (it != baseline.end() && it->second.ns_per_op > 0 && significant_change(result, it->second, threshold) > 0)
+            suspects.insert(key);
+    }
+    return suspects;
+}
+
+// Even a steady benchmark can run a lot slower for a while when something
+// else wants the machine, and the spread within one benchmark can't see
+// that. So anything that looks like a regression gets measured again, up to
+// this many times, and only counts if it's still significantly slower every
+// time.
+static const unsigned int confirmation_rounds = 3;
+
+// Measures suspects again, keeping whichever measurement was faster, since
+// noise only ever adds time. How much the two disagree is a better guess at
+// the noise than either spread, so the spread becomes at least that.
+static void measure_again(const std::set<std::pair<std::string, int>>& suspects, unsigned int round) {
+    std::printf("\nMeasuring %zu possible regressions again (%u of %u)\n",
+                suspects.size(), round, confirmation_rounds);
+    std::vector<Result> first;
+    first.swap(results);
+    remeasure = suspects;
+    for (auto benchmark : benchmarks)
+        benchmark();
+    remeasure.clear();
+
+    for (Result& result : first) {
+        for (const Result& again : results) {
+            if (again.name != result.name || again.characteristic != result.characteristic)
+                continue;
+            double disagreement = std::fabs(again.ns_per_op - result.ns_per_op) / 2;
+            if (again.ns_per_op < result.ns_per_op)
+                result = again;
+            result.spread = std::max(result.spread, disagreement / result.ns_per_op);
+        }
+    }
+    results.swap(first);
+}
+
+// Several runs of the whole suite, as one. A run can catch the machine on a
+// good or bad few minutes, and a benchmark's spread can't tell, so each
+// takes its median run, and a spread of at least half the range of the runs.
+// Three runs can agree by luck, though, so no spread is less than the typical
+// benchmark's either. That makes for a baseline that knows how noisy the
+// machine is.
+static std::vector<Result> combine_rounds(const std::vector<std::vector<Result>>& rounds) {
+    std::vector<Result> combined;
+    std::vector<double> disagreements;
+    for (const Result& first : rounds[0]) {
+        std::vector<double> ns, cycles, spreads;
+        for (const std::vector<Result>& round : rounds) {
+            for (const Result& result : round) {
+                if (result.name != first.name || result.characteristic != first.characteristic)
+                    continue;
+                ns.push_back(result.ns_per_op);
+                cycles.push_back(result.cycles_per_op);
+                spreads.push_back(result.spread);
+            }
+        }
+
+        Result result = first;
+        result.ns_per_op = median(ns);
+        result.cycles_per_op = median(cycles);
+        if (result.bytes_per_second)
+            result.bytes_per_second = first.bytes_per_second * first.ns_per_op / result.ns_per_op;
+        result.spread = median(spreads);
+        if (result.ns_per_op > 0) {
+            auto range = std::minmax_element(ns.begin(), ns.end());
+            double disagreement = (*range.second - *range.first) / 2 / result.ns_per_op;
+            result.spread = std::max(result.spread, disagreement);
+            disagreements.push_back(disagreement);
+        }
+        combined.push_back(result);
+    }
+
+    if (!disagreements.empty()) {
+        double typical = median(disagreements);
+        for (Result& result : combined)
+            result.spread = std::max(result.spread, typical);
+    }
+    return combined;
+}
+
+// Lists everything significantly slower (or faster) than the baseline, and
+// returns the number of regressions. Benchmarks missing from either side are
+// skipped.
+static unsigned int compare(const Baseline& baseline, double threshold) {
+    unsigned int regressions = 0;
+    unsigned int compared = 0;
+    std::printf("\n");
+    for (const Result& result : results) {
+        auto it = baseline.find(std::make_pair(result.name, result.characteristic));
+        if (it == baseline.end() || it->second.ns_per_op <= 0)
+            continue;
+
+        ++compared;
+        double before = it->second.ns_per_op;
+        double change = significant_change(result, it->second, threshold);
+        if (change > 0) {
+            std::printf("REGRESSION %-32s GF(2^%d) %+7.1f%% (%.2f -> %.2f ns/op)\n",
+                        result.name.c_str(), result.characteristic, change, before, result.ns_per_op);
+            ++regressions;
+        } else if (change < 0) {
+            std::printf("improved   %-32s GF(2^%d) %+7.1f%% (%.2f -> %.2f ns/op)\n",
+                        result.name.c_str(), result.characteristic, change, before, result.ns_per_op);
+        }
+    }
+    std::printf("%u of %u benchmarks more than %.0f%% slower than the baseline\n",
+                regressions, compared, threshold);
+    return regressions;
+}
+
+static void usage() {
+    std::fprintf(stderr,
+                 "usage: bench-multinv [--json=FILE] [--baseline=FILE] [--threshold=PERCENT] [--rounds=N]\n"
+                 "                     [SUBSTRING...]\n"
+                 "  --json=FILE          write the results to FILE\n"
+                 "  --baseline=FILE      compare with results written by --json earlier, and\n"
+                 "                       fail if anything got slower, beyond the noise, and\n"
+                 "                       still is when measured again\n"
+                 "  --threshold=PERCENT  how much slower counts as a regression (default 10)\n"
+                 "  --rounds=N           run everything N times and take the median, for a\n"
+                 "                       baseline that knows how much runs vary (default 1)\n");
+}
+
+int main(int argc, char *argv[]) {
+    const char* json = nullptr;
+    const char* baseline_path = nullptr;
+    double threshold = 10;
+    unsigned long rounds = 1;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--json=", 7) == 0) {
+            json = argv[i] + 7;
+        } else if (std::strncmp(argv[i], "--baseline=", 11) == 0) {
+            baseline_path = argv[i] + 11;
+        } else if (std::strncmp(argv[i], "--threshold=", 12) == 0) {
+            char* end;
+            threshold = std::strtod(argv[i] + 12, &end);
+            if (*end || threshold < 0) {
+                usage();
+                return 2;
+            }
+        } else if (std::strncmp(argv[i], "--rounds=", 9) == 0) {
+            char* end;
+            rounds = std::strtoul(argv[i] + 9, &end, 10);
+            if (*end || argv[i][9] == '\0' || rounds == 0 || rounds > 100) {
+                usage();
+                return 2;
+            }
+        } else if (std::strncmp(argv[i], "--", 2) == 0) {
+            usage();
+            return 2;
+        } else {
+            filters.push_back(argv[i]);
+        }
+    }
+
+    // Read the baseline first, so a typo doesn't cost a whole run.
+    Baseline baseline;
+    if (baseline_path) {
+        baseline = read_baseline(baseline_path);
+        if (baseline.empty()) {
+            std::fprintf(stderr, "No results in %s\n", baseline_path);
+            return 2;
+        }
+    }
+
+    // The filters apply to the names of the individual benchmarks, which
+    // only the groups know, so every group runs and measure() skips what
+    // wasn't asked for.
+    std::vector<std::vector<Result>> all_rounds;
+    for (unsigned long round = 1; round <= rounds; ++round) {
+        if (rounds > 1)
+            std::printf("%sRound %lu of %lu\n", round > 1 ? "\n" : "", round, rounds);
+        for (auto benchmark : benchmarks)
+            benchmark();
+        all_rounds.push_back(std::move(results));
+        results.clear();
+    }
+    results = combine_rounds(all_rounds);
+
+    // Don't leave an empty file behind for a later --baseline to choke on.
+    if (results.empty()) {
+        std::fprintf(stderr, "No benchmarks match");
+        for (const char* filter : filters)
+            std::fprintf(stderr, " %s", filter);
+        std::fprintf(stderr, "\n");
+        return 2;
+    }
+
+    if (baseline_path) {
+        for (unsigned int round = 1; round <= confirmation_rounds; ++round) {
+            auto suspects = suspected_regressions(baseline, threshold);
+            if (suspects.empty())
+                break;
+            measure_again(suspects, round);
+        }
+    }
+
+    if (json && !write_json(json)) {
+        std::fprintf(stderr, "Failed to write %s\n", json);
+        return 2;
+    }
+
+    if (baseline_path && compare(baseline, threshold) > 0)
+        return 1;
+    return 0;
+}
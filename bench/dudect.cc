@@ -0,0 +1,220 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2016 Michael Catanzaro <michael.catanzaro@mst.edu>
+ * Copyright (c) 2016 Jacob Fischer <jtf3m8@mst.edu>
+ * Copyright (c) 2016 Christian Storer <cs9yb@mst.edu>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "polynomial.h"
+
+#include "field-tables.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+using namespace multinv;
+
+// A timing-leak detector in the style of dudect (Reparaz, Balasch and
+// Verbauwhede, "Dude, is my code constant time?", 2017). For each operation we
+// time many batches whose secret inputs are either all one fixed value or all
+// random, picked at random, and run Welch's t-test on the two distributions of
+// timings. If the operation takes the same time no matter what the secret is,
+// t stays small; |t| > 10 means it definitely doesn't.
+//
+// Like bench-multinv, pass substrings to run only some operations, e.g.
+// `dudect-multinv constant-time`.
+
+// Results get XORed in here so the compiler can't optimize the work away.
+static volatile uint8_t sink;
+
+static const unsigned int samples = 1u << 18;
+static const unsigned int batch_size = 16;
+// Operations are timed this many times to decide where to crop outliers.
+static const unsigned int warmup_samples = 10000;
+
+static inline uint64_t timestamp() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_lfence();
+    return __rdtsc();
+#else
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+// Welch's t-test, accumulated online with Welford's method.
+class WelchTest {
+  public:
+    void add(int group, double x) {
+        ++m_count[group];
+        double delta = x - m_mean[group];
+        m_mean[group] += delta / m_count[group];
+        m_m2[group] += delta * (x - m_mean[group]);
+    }
+
+    double t() const {
+        if (m_count[0] < 2 || m_count[1] < 2)
+            return 0;
+        double var0 = m_m2[0] / (m_count[0] - 1);
+        double var1 = m_m2[1] / (m_count[1] - 1);
+        double denominator = std::sqrt(var0 / m_count[0] + var1 / m_count[1]);
+        if (denominator == 0)
+            return 0;
+        return (m_mean[0] - m_mean[1]) / denominator;
+    }
+
+  private:
+    double m_count[2] = { 0, 0 };
+    double m_mean[2] = { 0, 0 };
+    double m_m2[2] = { 0, 0 };
+};
+
+typedef uint8_t (*Operation)(uint8_t secret);
+
+static const uint16_t ip = Polynomial::aes_irreducible_polynomial;
+
+// The other operand of the multiplications. It isn't secret.
+static const uint8_t multiplier = 0x53;
+
+static uint8_t multiply_bitwise(uint8_t secret) {
+    return multinv::multiply_bitwise(multiplier, secret, ip, 8);
+}
+
+static uint8_t multiply_table(uint8_t secret) {
+    static const FieldTables* tables = FieldTables::get(ip, 8);
+    return tables->multiply(multiplier, secret);
+}
+
+static uint8_t multiply_constant_time(uint8_t secret) {
+    return multinv::multiply_constant_time(multiplier, secret, ip, 8);
+}
+
+template <InverseStrategy strategy>
+static uint8_t inverse(uint8_t secret) {
+    return multiplicative_inverse(Polynomial{secret}, strategy).value();
+}
+
+struct Target {
+    const char* name;
+    Operation operation;
+};
+
+static const Target targets[] = {
+    { "/multiply/bitwise", multiply_bitwise },
+    { "/multiply/table", multiply_table },
+    { "/multiply/constant-time", multiply_constant_time },
+    { "/inverse/table", inverse<InverseStrategy::Table> },
+    { "/inverse/brute-force", inverse<InverseStrategy::BruteForce> },
+    { "/inverse/extended-euclid", inverse<InverseStrategy::ExtendedEuclid> },
+    { "/inverse/itoh-tsujii", inverse<InverseStrategy::ItohTsujii> },
+    { "/inverse/constant-time", inverse<InverseStrategy::ConstantTime> },
+};
+
+// Times one batch of operations on the given inputs, in cycles where we can
+// count them.
+static uint64_t time_batch(Operation operation, const uint8_t* inputs) {
+    uint8_t result = 0;
+    uint64_t start = timestamp();
+    for (unsigned int i = 0; i < batch_size; ++i)
+        result ^= operation(inputs[i]);
+    uint64_t end = timestamp();
+    sink ^= result;
+    return end - start;
+}
+
+static void test(const Target& target, std::mt19937& random) {
+    // Zero is out: the non-constant-time inverses crash on it. The fixed
+    // class is 1, which is about as easy as inputs get.
+    std::uniform_int_distribution<unsigned int> element(1, 255);
+    std::bernoulli_distribution coin;
+
+    // The inputs are all chosen before any timing starts, so generating them
+    // doesn't end up in the measurements.
+    std::vector<uint8_t> classes(samples);
+    std::vector<uint8_t> inputs(samples * batch_size);
+    for (unsigned int i = 0; i < samples; ++i) {
+        classes[i] = coin(random);
+        for (unsigned int j = 0; j < batch_size; ++j)
+            inputs[i * batch_size + j] = classes[i] ? static_cast<uint8_t>(element(random)) : 1;
+    }
+
+    // Interrupts and the like produce huge outliers, so as well as the full
+    // data we test it cropped at a few percentiles, as dudect does.
+    std::vector<uint64_t> warmup(warmup_samples);
+    for (unsigned int i = 0; i < warmup_samples; ++i)
+        warmup[i] = time_batch(target.operation, &inputs[(i % samples) * batch_size]);
+    std::sort(warmup.begin(), warmup.end());
+    static const double percentiles[] = { 0.5, 0.75, 0.9, 0.95, 0.99 };
+    const size_t crops = sizeof(percentiles) / sizeof(percentiles[0]);
+    uint64_t thresholds[crops];
+    for (size_t i = 0; i < crops; ++i)
+        thresholds[i] = warmup[static_cast<size_t>(percentiles[i] * (warmup_samples - 1))];
+
+    WelchTest full;
+    WelchTest cropped[crops];
+    uint64_t fixed_total = 0;
+    for (unsigned int i = 0; i < samples; ++i) {
+        uint64_t cycles = time_batch(target.operation, &inputs[i * batch_size]);
+        if (classes[i] == 0)
+            fixed_total += cycles;
+        full.add(classes[i], static_cast<double>(cycles));
+        for (size_t j = 0; j < crops; ++j) {
+            if (cycles <= thresholds[j])
+                cropped[j].add(classes[i], static_cast<double>(cycles));
+        }
+    }
+
+    double max_t = std::fabs(full.t());
+    for (const WelchTest& crop : cropped)
+        max_t = std::max(max_t, std::fabs(crop.t()));
+
+    const char* verdict = max_t > 10 ? "leaks" : max_t > 4.5 ? "maybe leaks" : "no leak detected";
+    unsigned int fixed_samples = static_cast<unsigned int>(std::count(classes.begin(), classes.end(), 0));
+    double per_op = fixed_samples ? static_cast<double>(fixed_total) / fixed_samples / batch_size : 0;
+    std::printf("%-32s max |t| %10.2f  %7.1f ticks/op  %s\n", target.name, max_t, per_op, verdict);
+}
+
+int main(int argc, char *argv[]) {
+    std::mt19937 random(20170101);
+
+    for (const Target& target : targets) {
+        bool selected = argc == 1;
+        for (int i = 1; i < argc; ++i) {
+            if (std::strstr(target.name, argv[i]))
+                selected = true;
+        }
+        if (selected)
+            test(target, random);
+    }
+}
@@ -0,0 +1,452 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2016 Michael Catanzaro <michael.catanzaro@mst.edu>
+ * Copyright (c) 2016 Jacob Fischer <jtf3m8@mst.edu>
+ * Copyright (c) 2016 Christian Storer <cs9yb@mst.edu>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "aes-sbox.h"
+
+#include "polynomial.h"
+#include "region.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HAVE_X86_KERNELS 1
+#include <immintrin.h>
+#else
+#define HAVE_X86_KERNELS 0
+#endif
+
+namespace multinv {
+
+// An 8x8 matrix over GF(2). Bit c of rows[r] is the entry in row r, column c,
+// so row r times a byte x is the parity of rows[r] & x.
+struct BitMatrix {
+    uint8_t rows[8];
+};
+
+static constexpr uint8_t apply(const BitMatrix& m, uint8_t x) {
+    uint8_t result = 0;
+    for (int r = 0; r < 8; ++r)
+        result |= (__builtin_parity(m.rows[r] & x)) << r;
+    return result;
+}
+
+static constexpr BitMatrix multiply(const BitMatrix& a, const BitMatrix& b) {
+    // Column c of a * b is a times column c of b.
+    BitMatrix result = { };
+    for (int c = 0; c < 8; ++c) {
+        uint8_t column = 0;
+        for (int r = 0; r < 8; ++r)
+            column |= ((b.rows[r] >> c) & 1) << r;
+        uint8_t product = apply(a, column);
+        for (int r = 0; r < 8; ++r)
+            result.rows[r] |= ((product >> r) & 1) << c;
+    }
+    return result;
+}
+
+// The matrix whose column c is columns[c].
+static constexpr BitMatrix from_columns(const uint8_t* columns) {
+    BitMatrix result = { };
+    for (int c = 0; c < 8; ++c) {
+        for (int r = 0; r < 8; ++r)
+            result.rows[r] |= ((columns[c] >> r) & 1) << c;
+    }
+    return result;
+}
+
+static constexpr BitMatrix invert(const BitMatrix& m) {
+    // A linear map on bytes is small enough to invert by tabulating it.
+    uint8_t preimage[256] = { };
+    for (unsigned int x = 0; x < 256; ++x)
+        preimage[apply(m, x)] = static_cast<uint8_t>(x);
+
+    uint8_t columns[8] = { };
+    for (int c = 0; c < 8; ++c)
+        columns[c] = preimage[1 << c];
+    return from_columns(columns);
+}
+
+// The tower field: GF(2^4) is GF(2)[x]/(x^4 + x + 1), and GF((2^4)^2) is
+// GF(2^4)[y]/(y^2 + y + lambda) for some lambda that makes that irreducible.
+// An element a y + b is stored as the byte (a << 4) | b.
+static const uint16_t gf16_irreducible_polynomial = 0b10011;
+
+static constexpr uint8_t gf16_multiply(uint8_t a, uint8_t b) {
+    return multiply_bitwise(a, b, gf16_irreducible_polynomial, 4);
+}
+
+static constexpr uint8_t tower_multiply(uint8_t x, uint8_t y, uint8_t lambda) {
+    // (a y + b)(c y + d) = ac y^2 + (ad + bc) y + bd, and y^2 = y + lambda.
+    uint8_t a = x >> 4, b = x & 0xf, c = y >> 4, d = y & 0xf;
+    uint8_t ac = gf16_multiply(a, c);
+    uint8_t high = ac ^ gf16_multiply(a, d) ^ gf16_multiply(b, c);
+    uint8_t low = gf16_multiply(ac, lambda) ^ gf16_multiply(b, d);
+    return static_cast<uint8_t>((high << 4) | low);
+}
+
+// Everything the bitsliced code needs to know, worked out at compile time
+// rather than copied out of a paper. Being constants, the matrices fold away
+// into straight-line XORs.
+struct TowerField {
+    uint8_t lambda;
+    // AES field to tower field, and back.
+    BitMatrix to_tower;
+    BitMatrix from_tower;
+    // The affine part of SubBytes, its inverse, and the constants.
+    BitMatrix affine;
+    BitMatrix inverse_affine;
+    // Basis changes with the affine maps folded in.
+    BitMatrix from_tower_then_affine;
+    BitMatrix inverse_affine_then_to_tower;
+};
+
+static constexpr TowerField make_tower_field() {
+    TowerField field = { };
+
+    // y^2 + y + lambda is irreducible if it has no roots, i.e. lambda isn't
+    // t^2 + t for any t.
+    for (field.lambda = 1; field.lambda < 16; ++field.lambda) {
+        bool has_root = false;
+        for (uint8_t t = 0; t < 16; ++t)
+            has_root |= (gf16_multiply(t, t) ^ t) == field.lambda;
+        if (!has_root)
+            break;
+    }
+
+    // Find a root beta of the AES polynomial in the tower field. Then
+    // x -> beta is an isomorphism, and its matrix has columns beta^i.
+    uint8_t beta = 0;
+    for (unsigned int candidate = 2; candidate < 256 && !beta; ++candidate) {
+        uint8_t powers[9] = { 1 };
+        for (int i = 1; i <= 8; ++i)
+            powers[i] = tower_multiply(powers[i - 1], static_cast<uint8_t>(candidate), field.lambda);
+        uint8_t value = 0;
+        for (int i = 0; i <= 8; ++i) {
+            if ((Polynomial::aes_irreducible_polynomial >> i) & 1)
+                value ^= powers[i];
+        }
+        if (value == 0)
+            beta = static_cast<uint8_t>(candidate);
+    }
+    if (!beta)
+        std::abort();
+
+    uint8_t columns[8] = { 1 };
+    for (int i = 1; i < 8; ++i)
+        columns[i] = tower_multiply(columns[i - 1], beta, field.lambda);
+    field.to_tower = from_columns(columns);
+    field.from_tower = invert(field.to_tower);
+
+    // Bit i of the output is bits i, i+4, i+5, i+6 and i+7 of the input.
+    for (int i = 0; i < 8; ++i)
+        field.affine.rows[i] = static_cast<uint8_t>((0b11110001 << i) | (0b11110001 >> (8 - i)));
+    field.inverse_affine = invert(field.affine);
+
+    field.from_tower_then_affine = multiply(field.affine, field.from_tower);
+    field.inverse_affine_then_to_tower = multiply(field.to_tower, field.inverse_affine);
+    return field;
+}
+
+static constexpr TowerField tower_field = make_tower_field();
+
+static const uint8_t sbox_constant = 0x63;
+// A^-1 0x63, so A^-1 (s + 0x63) = A^-1 s + 0x05.
+static const uint8_t inverse_sbox_constant = 0x05;
+
+// Bitsliced arithmetic. A Word holds one bit from each of 64 (or 256) bytes;
+// an array of eight Words holds all of them. Word is uint64_t, or a GCC vector
+// of them, which supports the same operators.
+
+#if HAVE_X86_KERNELS
+typedef uint64_t Word128 __attribute__((vector_size(16)));
+typedef uint64_t Word256 __attribute__((vector_size(32)));
+#endif
+
+// Swaps the bits of a selected by mask << shift with the bits of b selected
+// by mask.
+template <typename Word>
+static void swap_move(Word& a, Word& b, uint64_t mask, int shift) {
+    Word t = ((a >> shift) ^ b) & mask;
+    b ^= t;
+    a ^= t << shift;
+}
+
+// Transposes each 8x8 block of bits formed by the same byte of all eight
+// words, so that afterwards word i holds bit i of every byte. It's its own
+// inverse.
+template <typename Word>
+static void transpose(Word* w) {
+    for (int i = 0; i < 8; i += 2)
+        swap_move(w[i], w[i + 1], 0x5555555555555555, 1);
+    for (int i = 0; i < 8; i += 4) {
+        swap_move(w[i], w[i + 2], 0x3333333333333333, 2);
+        swap_move(w[i + 1], w[i + 3], 0x3333333333333333, 2);
+    }
+    for (int i = 0; i < 4; ++i)
+        swap_move(w[i], w[i + 4], 0x0f0f0f0f0f0f0f0f, 4);
+}
+
+// out = m * in. The matrix is public, so branching on it is fine, and since
+// it's a constant, once the loops are unrolled the branches are gone too.
+template <typename Word>
+static void apply(const BitMatrix& m, const Word* in, Word* out) {
+#pragma GCC unroll 8
+    for (int r = 0; r < 8; ++r) {
+        Word sum = Word();
+#pragma GCC unroll 8
+        for (int c = 0; c < 8; ++c) {
+            if ((m.rows[r] >> c) & 1)
+                sum ^= in[c];
+        }
+        out[r] = sum;
+    }
+}
+
+// GF(2^4) multiplication: schoolbook, then x^4 = x + 1, x^5 = x^2 + x and
+// x^6 = x^3 + x^2.
+template <typename Word>
+static void gf16_multiply(const Word* a, const Word* b, Word* out) {
+    Word p0 = a[0] & b[0];
+    Word p1 = (a[0] & b[1]) ^ (a[1] & b[0]);
+    Word p2 = (a[0] & b[2]) ^ (a[1] & b[1]) ^ (a[2] & b[0]);
+    Word p3 = (a[0] & b[3]) ^ (a[1] & b[2]) ^ (a[2] & b[1]) ^ (a[3] & b[0]);
+    Word p4 = (a[1] & b[3]) ^ (a[2] & b[2]) ^ (a[3] & b[1]);
+    Word p5 = (a[2] & b[3]) ^ (a[3] & b[2]);
+    Word p6 = a[3] & b[3];
+    out[0] = p0 ^ p4;
+    out[1] = p1 ^ p4 ^ p5;
+    out[2] = p2 ^ p5 ^ p6;
+    out[3] = p3 ^ p6;
+}
+
+// Squaring is linear: a0 + a1 x^2 + a2 x^4 + a3 x^6, reduced.
+template <typename Word>
+static void gf16_square(const Word* a, Word* out) {
+    Word a0 = a[0], a1 = a[1], a2 = a[2], a3 = a[3];
+    out[0] = a0 ^ a2;
+    out[1] = a2;
+    out[2] = a1 ^ a3;
+    out[3] = a3;
+}
+
+// a^-1 = a^14 = a^2 a^4 a^8, and 0 goes to 0.
+template <typename Word>
+static void gf16_inverse(const Word* a, Word* out) {
+    Word a2[4], a4[4], a8[4], a6[4];
+    gf16_square(a, a2);
+    gf16_square(a2, a4);
+    gf16_square(a4, a8);
+    gf16_multiply(a2, a4, a6);
+    gf16_multiply(a6, a8, out);
+}
+
+// (a y + b)^-1 = (a y + (a + b)) / (lambda a^2 + ab + b^2). In bits 4-7 and
+// 0-3 respectively of x.
+template <typename Word>
+static void tower_inverse(const Word* x, uint8_t lambda, Word* out) {
+    const Word* b = x;
+    const Word* a = x + 4;
+
+    Word lambda_slices[4];
+    for (int i = 0; i < 4; ++i)
+        lambda_slices[i] = ((lambda >> i) & 1) ? ~Word() : Word();
+
+    Word a2[4], lambda_a2[4], ab[4], b2[4], delta[4], delta_inverse[4], a_plus_b[4];
+    gf16_square(a, a2);
+    gf16_multiply(a2, lambda_slices, lambda_a2);
+    gf16_multiply(a, b, ab);
+    gf16_square(b, b2);
+    for (int i = 0; i < 4; ++i) {
+        delta[i] = lambda_a2[i] ^ ab[i] ^ b2[i];
+        a_plus_b[i] = a[i] ^ b[i];
+    }
+    gf16_inverse(delta, delta_inverse);
+    gf16_multiply(a, delta_inverse, out + 4);
+    gf16_multiply(a_plus_b, delta_inverse, out);
+}
+
+// Adds a constant byte to every byte.
+template <typename Word>
+static void add_constant(Word* slices, uint8_t constant) {
+    for (int i = 0; i < 8; ++i) {
+        if ((constant >> i) & 1)
+            slices[i] = ~slices[i];
+    }
+}
+
+template <typename Word>
+static void sub_bytes_sliced(Word* slices, const TowerField& field) {
+    Word tower[8], inverse[8];
+    apply(field.to_tower, slices, tower);
+    tower_inverse(tower, field.lambda, inverse);
+    apply(field.from_tower_then_affine, inverse, slices);
+    add_constant(slices, sbox_constant);
+}
+
+template <typename Word>
+static void inv_sub_bytes_sliced(Word* slices, const TowerField& field) {
+    Word tower[8], inverse[8];
+    add_constant(slices, sbox_constant);
+    apply(field.inverse_affine_then_to_tower, slices, tower);
+    tower_inverse(tower, field.lambda, inverse);
+    apply(field.from_tower, inverse, slices);
+}
+
+// The bytes of a block go into the words in 8-byte groups, in whatever order
+// the transpose and its inverse agree on; S-boxes don't care which byte is
+// where.
+template <typename Word>
+static const size_t block_size = 8 * sizeof(Word);
+
+template <typename Word, bool inverse>
+static void sbox_block(uint8_t* dst, const uint8_t* src, const TowerField& field) {
+    Word slices[8];
+    std::memcpy(slices, src, sizeof(slices));
+    transpose(slices);
+    if (inverse)
+        inv_sub_bytes_sliced(slices, field);
+    else
+        sub_bytes_sliced(slices, field);
+    transpose(slices);
+    std::memcpy(dst, slices, sizeof(slices));
+}
+
+template <typename Word, bool inverse>
+static void sbox_region(uint8_t* dst, const uint8_t* src, size_t len) {
+    const TowerField& field = tower_field;
+    const size_t block = block_size<Word>;
+
+    size_t i = 0;
+    for (; i + block <= len; i += block)
+        sbox_block<Word, inverse>(dst + i, src + i, field);
+
+    // Pad out the tail rather than doing it some other, leakier, way.
+    if (i < len) {
+        uint8_t buffer[block_size<Word>] = { };
+        std::memcpy(buffer, src + i, len - i);
+        sbox_block<Word, inverse>(buffer, buffer, field);
+        std::memcpy(dst + i, buffer, len - i);
+    }
+}
+
+// flatten, so the whole circuit is inlined into one loop and the compiler can
+// schedule it as it likes.
+__attribute__((flatten))
+static void sbox_region_scalar(uint8_t* dst, const uint8_t* src, size_t len, bool inverse) {
+    if (inverse)
+        sbox_region<uint64_t, true>(dst, src, len);
+    else
+        sbox_region<uint64_t, false>(dst, src, len);
+}
+
+#if HAVE_X86_KERNELS
+
+// The same, two and four words at a time in SSE and AVX2 registers.
+__attribute__((flatten))
+static void sbox_region_sse(uint8_t* dst, const uint8_t* src, size_t len, bool inverse) {
+    if (inverse)
+        sbox_region<Word128, true>(dst, src, len);
+    else
+        sbox_region<Word128, false>(dst, src, len);
+}
+
+__attribute__((target("avx2"), flatten))
+static void sbox_region_avx2(uint8_t* dst, const uint8_t* src, size_t len, bool inverse) {
+    if (inverse)
+        sbox_region<Word256, true>(dst, src, len);
+    else
+        sbox_region<Word256, false>(dst, src, len);
+}
+
+// As for make_affine_matrix() in region.cc: row i goes in byte 7 - i.
+static uint64_t gfni_matrix(const BitMatrix& m) {
+    uint64_t matrix = 0;
+    for (int i = 0; i < 8; ++i)
+        matrix |= static_cast<uint64_t>(m.rows[i]) << (8 * (7 - i));
+    return matrix;
+}
+
+// GF2P8AFFINEINVQB inverts in the AES field and then applies an affine map,
+// which is SubBytes exactly. Going backwards takes an extra GF2P8AFFINEQB
+// first.
+__attribute__((target("gfni,avx2")))
+static size_t sbox_region_gfni(uint8_t* dst, const uint8_t* src, size_t len, bool inverse) {
+    const TowerField& field = tower_field;
+    const __m256i affine = _mm256_set1_epi64x(static_cast<long long>(gfni_matrix(field.affine)));
+    const __m256i inverse_affine = _mm256_set1_epi64x(static_cast<long long>(gfni_matrix(field.inverse_affine)));
+    const __m256i identity = _mm256_set1_epi64x(0x0102040810204080);
+
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        if (inverse) {
+            x = _mm256_gf2p8affine_epi64_epi8(x, inverse_affine, inverse_sbox_constant);
+            x = _mm256_gf2p8affineinv_epi64_epi8(x, identity, 0);
+        } else {
+            x = _mm256_gf2p8affineinv_epi64_epi8(x, affine, sbox_constant);
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), x);
+    }
+    return i;
+}
+
+#endif
+
+static void sbox(uint8_t* dst, const uint8_t* src, size_t len, bool inverse) {
+    size_t done = 0;
+#if HAVE_X86_KERNELS
+    switch (region_kernel()) {
+    case RegionKernel::GFNI:
+        done = sbox_region_gfni(dst, src, len, inverse);
+        break;
+    case RegionKernel::AVX2:
+        sbox_region_avx2(dst, src, len, inverse);
+        return;
+    case RegionKernel::SSSE3:
+        sbox_region_sse(dst, src, len, inverse);
+        return;
+    case RegionKernel::Scalar:
+    default:
+        break;
+    }
+#endif
+
+    sbox_region_scalar(dst + done, src + done, len - done, inverse);
+}
+
+void aes_sub_bytes(uint8_t* dst, const uint8_t* src, size_t len) {
+    sbox(dst, src, len, false);
+}
+
+void aes_inv_sub_bytes(uint8_t* dst, const uint8_t* src, size_t len) {
+    sbox(dst, src, len, true);
+}
+
+}
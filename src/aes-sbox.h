@@ -0,0 +1,55 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2016 Michael Catanzaro <michael.catanzaro@mst.edu>
+ * Copyright (c) 2016 Jacob Fischer <jtf3m8@mst.edu>
+ * Copyright (c) 2016 Christian Storer <cs9yb@mst.edu>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace multinv {
+
+// AES SubBytes and InvSubBytes over whole buffers: dst[i] = S(src[i]) and
+// dst[i] = S^-1(src[i]). dst and src may be the same buffer, but must not
+// otherwise overlap.
+//
+// S(x) is the affine map A x + 0x63 applied to multiplicative_inverse(x) in
+// the AES field (with 0 going to 0). Rather than looking anything up, which
+// leaks the index through the cache, these compute it. Bytes are bitsliced 64,
+// 128 or 256 at a time (for the scalar, SSSE3 and AVX2 kernels), so each bit
+// position lives in its own word; moved into the isomorphic tower field
+// GF((2^4)^2), where inversion is a handful of GF(2^4) multiplications;
+// inverted with nothing but ANDs and XORs; and moved back. No branches or
+// memory accesses depend on the data, so this is constant-time. With GFNI,
+// GF2P8AFFINEINVQB does the whole thing in one instruction, and that's used
+// instead. region_kernel() decides which.
+// Reference: D. Canright, "A Very Compact S-Box for AES", CHES 2005.
+void aes_sub_bytes(uint8_t* dst, const uint8_t* src, size_t len);
+void aes_inv_sub_bytes(uint8_t* dst, const uint8_t* src, size_t len);
+
+}
@@ -0,0 +1,109 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2016 Michael Catanzaro <michael.catanzaro@mst.edu>
+ * Copyright (c) 2016 Jacob Fischer <jtf3m8@mst.edu>
+ * Copyright (c) 2016 Christian Storer <cs9yb@mst.edu>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "batch-inverse.h"
+
+#include "instrumentation.h"
+#include "region.h"
+
+namespace multinv {
+
+template <typename Element>
+static size_t montgomery_inverse(const Element* in, Element* out, size_t count,
+                                 const Element& zero, const Element& one) {
+    if (count == 0)
+        return 0;
+
+    // out[i] = product of all the nonzero elements before in[i].
+    size_t zeros = 0;
+    Element product = one;
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = product;
+        if (in[i].value() != 0)
+            product *= in[i];
+        else
+            ++zeros;
+    }
+
+    // inverse = 1 / (product of all the nonzero elements up to and including
+    // in[i]), starting with i = count - 1. Multiplying that by the product of
+    // the elements before in[i] leaves 1 / in[i]; multiplying it by in[i]
+    // moves on to the next i down.
+    Element inverse = multiplicative_inverse(product);
+    for (size_t i = count; i-- > 0;) {
+        if (in[i].value() == 0) {
+            out[i] = zero;
+            continue;
+        }
+        out[i] *= inverse;
+        inverse *= in[i];
+    }
+
+    return zeros;
+}
+
+size_t multiplicative_inverse_batch(const Polynomial* in, Polynomial* out, size_t count) {
+    if (count == 0)
+        return 0;
+    uint16_t ip = in[0].irreducible_polynomial();
+    int characteristic = in[0].characteristic();
+    MULTINV_INSTRUMENT(InverseBatch, ip, characteristic, count);
+    size_t zeros = montgomery_inverse(in, out, count, Polynomial{0, ip, characteristic}, Polynomial{1, ip, characteristic});
+    if (zeros)
+        MULTINV_INSTRUMENT_EVENT(InverseOfZero, ip, characteristic, zeros);
+    return zeros;
+}
+
+template <typename Word>
+size_t multiplicative_inverse_batch(const WidePolynomial<Word>* in, WidePolynomial<Word>* out, size_t count) {
+    if (count == 0)
+        return 0;
+    Word ip = in[0].irreducible_polynomial();
+    return montgomery_inverse(in, out, count, WidePolynomial<Word>{0, ip}, WidePolynomial<Word>{1, ip});
+}
+
+template size_t multiplicative_inverse_batch(const WidePolynomial<uint16_t>*, WidePolynomial<uint16_t>*, size_t);
+template size_t multiplicative_inverse_batch(const WidePolynomial<uint32_t>*, WidePolynomial<uint32_t>*, size_t);
+template size_t multiplicative_inverse_batch(const WidePolynomial<uint64_t>*, WidePolynomial<uint64_t>*, size_t);
+template size_t multiplicative_inverse_batch(const WidePolynomial<uint128_t>*, WidePolynomial<uint128_t>*, size_t);
+
+size_t multiplicative_inverse_batch(const uint8_t* in, uint8_t* out, size_t count,
+                                    uint16_t irreducible_polynomial, int characteristic) {
+    MULTINV_INSTRUMENT(InverseBatch, irreducible_polynomial, characteristic, count);
+    size_t zeros = 0;
+    for (size_t i = 0; i < count; ++i)
+        zeros += in[i] == 0;
+    if (zeros)
+        MULTINV_INSTRUMENT_EVENT(InverseOfZero, irreducible_polynomial, characteristic, zeros);
+
+    gf_inverse_region(out, in, count, irreducible_polynomial, characteristic);
+    return zeros;
+}
+
+}
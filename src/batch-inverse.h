@@ -0,0 +1,63 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2016 Michael Catanzaro <michael.catanzaro@mst.edu>
+ * Copyright (c) 2016 Jacob Fischer <jtf3m8@mst.edu>
+ * Copyright (c) 2016 Christian Storer <cs9yb@mst.edu>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "polynomial.h"
+#include "wide-polynomial.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace multinv {
+
+// Inverts count elements at once using Montgomery's trick: multiply
+// everything together, invert the product, then peel the individual inverses
+// back off. That's one inversion plus 3(count - 1) multiplications, rather
+// than count inversions, which is a big win wherever inversion is much more
+// expensive than multiplication.
+//
+// Unlike multiplicative_inverse(), zero doesn't crash: its "inverse" is zero,
+// and the return value is the number of zeros encountered. All elements must
+// belong to the same field. in and out must not overlap.
+size_t multiplicative_inverse_batch(const Polynomial* in, Polynomial* out, size_t count);
+
+template <typename Word>
+size_t multiplicative_inverse_batch(const WidePolynomial<Word>* in, WidePolynomial<Word>* out, size_t count);
+
+// The same, for raw elements of the field defined by irreducible_polynomial
+// and characteristic. Elements this small are cheaper to invert by table
+// lookup than to multiply three times, so this doesn't actually use
+// Montgomery's trick: it's gf_inverse_region() plus counting zeros. in and out
+// may be the same buffer.
+size_t multiplicative_inverse_batch(const uint8_t* in, uint8_t* out, size_t count,
+                                    uint16_t irreducible_polynomial = Polynomial::aes_irreducible_polynomial,
+                                    int characteristic = 8);
+
+}
@@ -0,0 +1,350 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2016 Michael Catanzaro <michael.catanzaro@mst.edu>
+ * Copyright (c) 2016 Jacob Fischer <jtf3m8@mst.edu>
+ * Copyright (c) 2016 Christian Storer <cs9yb@mst.edu>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "crc.h"
+
+#include "wide-polynomial.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__)
+#define HAVE_PCLMULQDQ 1
+#include <immintrin.h>
+#else
+#define HAVE_PCLMULQDQ 0
+#endif
+
+namespace multinv {
+
+static uint64_t load64(const uint8_t* p) {
+    uint64_t value;
+    std::memcpy(&value, p, 8);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap64(value);
+#endif
+    return value;
+}
+
+// Reverses the bits of each byte of value, leaving the bytes where they are.
+static uint64_t reverse_bits_in_bytes(uint64_t value) {
+    value = ((value >> 1) & 0x5555555555555555ull) | ((value & 0x5555555555555555ull) << 1);
+    value = ((value >> 2) & 0x3333333333333333ull) | ((value & 0x3333333333333333ull) << 2);
+    value = ((value >> 4) & 0x0f0f0f0f0f0f0f0full) | ((value & 0x0f0f0f0f0f0f0f0full) << 4);
+    return value;
+}
+
+// The low width bits of value, backwards.
+static uint64_t reflect(uint64_t value, int width) {
+    return __builtin_bswap64(reverse_bits_in_bytes(value)) >> (64 - width);
+}
+
+// Input in the order the register wants it: least significant bit first.
+template <bool ReflectInput>
+static uint8_t input_byte(uint8_t byte) {
+    return ReflectInput ? byte : static_cast<uint8_t>(reverse_bits_in_bytes(byte));
+}
+
+template <bool ReflectInput>
+static uint64_t input_word(const uint8_t* p) {
+    uint64_t word = load64(p);
+    return ReflectInput ? word : reverse_bits_in_bytes(word);
+}
+
+// Everything below works on the register in reflected form, where bit i is
+// the coefficient of x^(63 - i), and tables[256 * k + b] is b * x^(64 + 8k)
+// modulo the generator. Shifting right multiplies by x.
+
+template <bool ReflectInput>
+static uint64_t update_bytewise(const uint64_t* tables, uint64_t reg, const uint8_t* data, size_t len) {
+    for (size_t i = 0; i < len; ++i)
+        reg = tables[(reg ^ input_byte<ReflectInput>(data[i])) & 0xff] ^ (reg >> 8);
+    return reg;
+}
+
+// word * x^64, reduced: the byte of word that's furthest from the end of the
+// message needs the highest power of x.
+static inline uint64_t slice8(const uint64_t* tables, uint64_t word) {
+    uint64_t result = 0;
+#pragma GCC unroll 8
+    for (int k = 0; k < 8; ++k)
+        result ^= tables[256 * (7 - k) + ((word >> (8 * k)) & 0xff)];
+    return result;
+}
+
+template <bool ReflectInput>
+static uint64_t update_slicing8(const uint64_t* tables, uint64_t reg, const uint8_t* data, size_t len) {
+    for (; len >= 8; data += 8, len -= 8)
+        reg = slice8(tables, reg ^ input_word<ReflectInput>(data));
+    return update_bytewise<ReflectInput>(tables, reg, data, len);
+}
+
+template <bool ReflectInput>
+static uint64_t update_slicing16(const uint64_t* tables, uint64_t reg, const uint8_t* data, size_t len) {
+    for (; len >= 16; data += 16, len -= 16) {
+        reg = slice8(tables + 8 * 256, reg ^ input_word<ReflectInput>(data)) ^
+              slice8(tables, input_word<ReflectInput>(data + 8));
+    }
+    return update_slicing8<ReflectInput>(tables, reg, data, len);
+}
+
+#if HAVE_PCLMULQDQ
+
+static __m128i set_constants(const uint64_t* constants) {
+    return _mm_set_epi64x(static_cast<long long>(constants[1]), static_cast<long long>(constants[0]));
+}
+
+template <bool ReflectInput>
+__attribute__((target("ssse3")))
+static __m128i load_block(const uint8_t* p) {
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    if (ReflectInput)
+        return block;
+
+    // Each nibble reversed, and moved to the other half of the byte.
+    const __m128i reversed_low = _mm_set_epi64x(static_cast<long long>(0xf070b030d0509010ull),
+                                                static_cast<long long>(0xe060a020c0408000ull));
+    const __m128i reversed_high = _mm_set_epi64x(0x0f070b030d050901ll, 0x0e060a020c040800ll);
+    const __m128i mask = _mm_set1_epi8(0x0f);
+    __m128i low = _mm_shuffle_epi8(reversed_low, _mm_and_si128(block, mask));
+    __m128i high = _mm_shuffle_epi8(reversed_high, _mm_and_si128(_mm_srli_epi16(block, 4), mask));
+    return _mm_or_si128(low, high);
+}
+
+// accumulator * x^d + data, where constants holds x^(d + 63) and x^(d - 1).
+// The low half of the accumulator is the high half of the polynomial: it
+// needs x^(64 + d), and the high half needs x^d. Each product comes out of
+// PCLMULQDQ one bit short of where a reflected 128-bit value would have it,
+// which the constants make up for.
+__attribute__((target("pclmul")))
+static __m128i fold(__m128i accumulator, __m128i constants, __m128i data) {
+    __m128i high = _mm_clmulepi64_si128(accumulator, constants, 0x00);
+    __m128i low = _mm_clmulepi64_si128(accumulator, constants, 0x11);
+    return _mm_xor_si128(_mm_xor_si128(high, low), data);
+}
+
+// Needs at least 128 bytes. Eight independent accumulators keep enough
+// multiplications in flight to cover their latency. At the end, they're
+// folded into one, and the 16 bytes of remainder it holds are finished off,
+// along with the last few bytes of the message, with the tables.
+template <bool ReflectInput>
+__attribute__((target("pclmul,ssse3")))
+static uint64_t update_pclmulqdq(const uint64_t* tables, const uint64_t* fold_1024, const uint64_t* fold_128,
+                                 uint64_t reg, const uint8_t* data, size_t len) {
+    const __m128i by_1024 = set_constants(fold_1024);
+    const __m128i by_128 = set_constants(fold_128);
+
+    __m128i accumulators[8];
+#pragma GCC unroll 8
+    for (int i = 0; i < 8; ++i)
+        accumulators[i] = load_block<ReflectInput>(data + 16 * i);
+    // The register goes in on top of the first eight bytes, as if it had
+    // been part of the message.
+    accumulators[0] = _mm_xor_si128(accumulators[0], _mm_cvtsi64_si128(static_cast<long long>(reg)));
+    data += 128;
+    len -= 128;
+
+    for (; len >= 128; data += 128, len -= 128) {
+#pragma GCC unroll 8
+        for (int i = 0; i < 8; ++i)
+            accumulators[i] = fold(accumulators[i], by_1024, load_block<ReflectInput>(data + 16 * i));
+    }
+
+    __m128i accumulator = accumulators[0];
+#pragma GCC unroll 8
+    for (int i = 1; i < 8; ++i)
+        accumulator = fold(accumulator, by_128, accumulators[i]);
+    for (; len >= 16; data += 16, len -= 16)
+        accumulator = fold(accumulator, by_128, load_block<ReflectInput>(data));
+
+    uint8_t remainder[16];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(remainder), accumulator);
+    reg = update_slicing16<true>(tables, 0, remainder, 16);
+    return update_slicing16<ReflectInput>(tables, reg, data, len);
+}
+
+#endif
+
+static CrcKernel best_crc_kernel() {
+    if (crc_kernel_supported(CrcKernel::PCLMULQDQ))
+        return CrcKernel::PCLMULQDQ;
+    return CrcKernel::Slicing16;
+}
+
+static CrcKernel current_kernel = best_crc_kernel();
+
+CrcKernel crc_kernel() {
+    return current_kernel;
+}
+
+bool crc_kernel_supported(CrcKernel kernel) {
+#if HAVE_PCLMULQDQ
+    // Needed because we're called during static initialization.
+    __builtin_cpu_init();
+#endif
+
+    switch (kernel) {
+    case CrcKernel::Bytewise:
+    case CrcKernel::Slicing8:
+    case CrcKernel::Slicing16:
+        return true;
+    case CrcKernel::PCLMULQDQ:
+#if HAVE_PCLMULQDQ
+        return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("ssse3");
+#else
+        return false;
+#endif
+    default:
+        return false;
+    }
+}
+
+bool set_crc_kernel(CrcKernel kernel) {
+    if (!crc_kernel_supported(kernel))
+        return false;
+    current_kernel = kernel;
+    return true;
+}
+
+Crc::Crc(const CrcParameters& parameters)
+    : m_parameters(parameters)
+    , m_tables(16 * 256)
+{
+    if (parameters.width < 1 || parameters.width > 64)
+        std::abort();
+
+    const int width = parameters.width;
+    m_mask = ~uint64_t{0} >> (64 - width);
+    m_parameters.polynomial &= m_mask;
+    m_parameters.init &= m_mask;
+    m_parameters.xor_output &= m_mask;
+    m_reflected_polynomial = reflect(m_parameters.polynomial, width);
+    m_reflected_init = reflect(m_parameters.init, width);
+
+    // One bit at a time for the first table: multiply by x, and when that
+    // pushes a term out past x^63, add the generator back in.
+    for (unsigned int b = 0; b < 256; ++b) {
+        uint64_t value = b;
+        for (int i = 0; i < 8; ++i)
+            value = (value >> 1) ^ (m_reflected_polynomial & (0 - (value & 1)));
+        m_tables[b] = value;
+    }
+    // Then each table is the one before times x^8.
+    for (unsigned int k = 1; k < 16; ++k) {
+        for (unsigned int b = 0; b < 256; ++b) {
+            uint64_t previous = m_tables[256 * (k - 1) + b];
+            m_tables[256 * k + b] = (previous >> 8) ^ m_tables[previous & 0xff];
+        }
+    }
+
+    m_fold_1024[0] = power_of_x(1024 + 63);
+    m_fold_1024[1] = power_of_x(1024 - 1);
+    m_fold_128[0] = power_of_x(128 + 63);
+    m_fold_128[1] = power_of_x(128 - 1);
+}
+
+Crc::~Crc() = default;
+
+// The product of two reflected 64-bit polynomials comes out of
+// carryless_multiply() with x^0 in bit 126, so shifted up by one, its high
+// word is the part below x^64, and its low word is the part above, times
+// x^64. Reducing that is exactly what the tables are for.
+uint64_t Crc::multiply(uint64_t a, uint64_t b) const {
+    uint128_t product = carryless_multiply(a, b) << 1;
+    return static_cast<uint64_t>(product >> 64) ^ slice8(m_tables.data(), static_cast<uint64_t>(product));
+}
+
+// Square and multiply, starting from x^1.
+uint64_t Crc::power_of_x(uint64_t exponent) const {
+    uint64_t result = uint64_t{1} << 63;
+    uint64_t square = uint64_t{1} << 62;
+    for (; exponent != 0; exponent >>= 1) {
+        if (exponent & 1)
+            result = multiply(result, square);
+        square = multiply(square, square);
+    }
+    return result;
+}
+
+uint64_t Crc::register_from_crc(uint64_t crc) const {
+    uint64_t reg = (crc ^ m_parameters.xor_output) & m_mask;
+    return m_parameters.reflect_output ? reg : reflect(reg, m_parameters.width);
+}
+
+uint64_t Crc::crc_from_register(uint64_t reg) const {
+    if (!m_parameters.reflect_output)
+        reg = reflect(reg, m_parameters.width);
+    return reg ^ m_parameters.xor_output;
+}
+
+uint64_t Crc::update_register(uint64_t reg, const uint8_t* data, size_t len) const {
+    const uint64_t* tables = m_tables.data();
+    const bool reflected = m_parameters.reflect_input;
+
+    switch (current_kernel) {
+    case CrcKernel::PCLMULQDQ:
+#if HAVE_PCLMULQDQ
+        if (len >= 128) {
+            return reflected ? update_pclmulqdq<true>(tables, m_fold_1024, m_fold_128, reg, data, len)
+                             : update_pclmulqdq<false>(tables, m_fold_1024, m_fold_128, reg, data, len);
+        }
+#endif
+        return reflected ? update_slicing16<true>(tables, reg, data, len)
+                         : update_slicing16<false>(tables, reg, data, len);
+    case CrcKernel::Slicing16:
+        return reflected ? update_slicing16<true>(tables, reg, data, len)
+                         : update_slicing16<false>(tables, reg, data, len);
+    case CrcKernel::Slicing8:
+        return reflected ? update_slicing8<true>(tables, reg, data, len)
+                         : update_slicing8<false>(tables, reg, data, len);
+    case CrcKernel::Bytewise:
+    default:
+        return reflected ? update_bytewise<true>(tables, reg, data, len)
+                         : update_bytewise<false>(tables, reg, data, len);
+    }
+}
+
+uint64_t Crc::compute(const void* data, size_t len) const {
+    return crc_from_register(update_register(m_reflected_init, static_cast<const uint8_t*>(data), len));
+}
+
+uint64_t Crc::update(uint64_t crc, const void* data, size_t len) const {
+    return crc_from_register(update_register(register_from_crc(crc), static_cast<const uint8_t*>(data), len));
+}
+
+// With a register of zero to start, the CRC of a message is linear in it, so
+// the register after A then B is the register after A, shifted along by
+// len2 bytes, plus the register after B alone. The register after B that
+// we're given started from init, not zero, so that needs taking back out.
+uint64_t Crc::combine(uint64_t crc1, uint64_t crc2, uint64_t len2) const {
+    uint64_t shifted = multiply(register_from_crc(crc1) ^ m_reflected_init, power_of_x(8 * len2));
+    return crc_from_register(shifted ^ register_from_crc(crc2));
+}
+
+}
@@ -0,0 +1,135 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2016 Michael Catanzaro <michael.catanzaro@mst.edu>
+ * Copyright (c) 2016 Jacob Fischer <jtf3m8@mst.edu>
+ * Copyright (c) 2016 Christian Storer <cs9yb@mst.edu>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace multinv {
+
+// A CRC, described the usual way (Williams' "Painless Guide to CRC Error
+// Detection Algorithms", and every catalogue since): the remainder of the
+// message, times x^width, modulo the generator polynomial, with some
+// bit-twiddling at either end.
+struct CrcParameters {
+    // The degree of the generator, from 1 to 64.
+    int width;
+    // The generator, without its leading x^width term, most significant
+    // coefficient in the highest bit. Not reflected, even for reflected CRCs.
+    uint64_t polynomial;
+    // The register before any data goes in, also not reflected.
+    uint64_t init;
+    // Whether each byte goes in least significant bit first.
+    bool reflect_input;
+    // Whether the register comes out backwards.
+    bool reflect_output;
+    // XORed into the result.
+    uint64_t xor_output;
+};
+
+// A few that everybody uses. Raw remainders of the message times x^width are
+// {width, polynomial, 0, false, false, 0}.
+constexpr CrcParameters crc32_iso_hdlc{32, 0x04c11db7, 0xffffffff, true, true, 0xffffffff};  // zlib, Ethernet
+constexpr CrcParameters crc32_iscsi{32, 0x1edc6f41, 0xffffffff, true, true, 0xffffffff};     // CRC-32C
+constexpr CrcParameters crc32_bzip2{32, 0x04c11db7, 0xffffffff, false, false, 0xffffffff};
+constexpr CrcParameters crc64_xz{64, 0x42f0e1eba9ea3693, ~0ull, true, true, ~0ull};
+constexpr CrcParameters crc64_ecma_182{64, 0x42f0e1eba9ea3693, 0, false, false, 0};
+
+// Computes CRCs with a generator polynomial of up to 64 bits.
+//
+// This is the same polynomial remainder as Polynomial's reduction, just with
+// a longer dividend. Internally every width is a reflected 64-bit CRC: the
+// remainder modulo P * x^(64 - width) is the remainder modulo P, shifted up,
+// and in reflected form the shift disappears. Unreflected input has the bits
+// of each byte reversed on the way in, which is cheap next to everything
+// else.
+class Crc {
+  public:
+    // Crashes if parameters.width isn't from 1 to 64.
+    explicit Crc(const CrcParameters&);
+    ~Crc();
+
+    const CrcParameters& parameters() const { return m_parameters; }
+
+    // The CRC of len bytes of data.
+    uint64_t compute(const void* data, size_t len) const;
+    // The CRC of whatever crc was the CRC of, followed by len bytes of data.
+    // compute(nullptr, 0) is the CRC of nothing, which is where to start.
+    uint64_t update(uint64_t crc, const void* data, size_t len) const;
+    // The CRC of two messages concatenated, given their CRCs and the length
+    // of the second. Takes time logarithmic in len2, without looking at any
+    // data, so large streams can be checksummed in pieces, in parallel.
+    uint64_t combine(uint64_t crc1, uint64_t crc2, uint64_t len2) const;
+
+  private:
+    uint64_t register_from_crc(uint64_t) const;
+    uint64_t crc_from_register(uint64_t) const;
+    uint64_t update_register(uint64_t, const uint8_t*, size_t) const;
+
+    // In the reflected domain, where the most significant bit is x^0.
+    uint64_t multiply(uint64_t, uint64_t) const;
+    uint64_t power_of_x(uint64_t exponent) const;
+
+    CrcParameters m_parameters;
+    uint64_t m_mask;
+    // P * x^(64 - width) mod x^64, reflected.
+    uint64_t m_reflected_polynomial;
+    uint64_t m_reflected_init;
+    // m_tables[k][b] is b * x^(64 + 8k), reduced, for slicing-by-16.
+    std::vector<uint64_t> m_tables;
+    // x^(d + 63) and x^(d - 1), reduced, for folding 128-bit blocks d bits
+    // forward with PCLMULQDQ, for d = 1024 and d = 128.
+    uint64_t m_fold_1024[2];
+    uint64_t m_fold_128[2];
+};
+
+// The implementations of Crc::update(). The fastest one the CPU supports is
+// selected automatically.
+enum class CrcKernel {
+    // A byte at a time, from one 256-entry table.
+    Bytewise,
+    // Eight bytes at a time, from eight tables, so the lookups don't wait on
+    // each other.
+    Slicing8,
+    // Sixteen bytes at a time, from sixteen.
+    Slicing16,
+    // 128 bytes at a time, folded into eight 128-bit accumulators with
+    // carry-less multiplications by x^1024. Short messages and the last few
+    // bytes go through Slicing16.
+    PCLMULQDQ,
+};
+
+CrcKernel crc_kernel();
+bool crc_kernel_supported(CrcKernel);
+// Not thread safe.
+bool set_crc_kernel(CrcKernel);
+
+}
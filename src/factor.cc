@@ -0,0 +1,208 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2016 Michael Catanzaro <michael.catanzaro@mst.edu>
+ * Copyright (c) 2016 Jacob Fischer <jtf3m8@mst.edu>
+ * Copyright (c) 2016 Christian Storer <cs9yb@mst.edu>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "factor.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace multinv {
+
+__extension__ typedef unsigned __int128 uint128_t;
+
+static uint64_t multiply_mod(uint64_t a, uint64_t b, uint64_t m) {
+    return static_cast<uint64_t>(static_cast<uint128_t>(a) * b % m);
+}
+
+static uint64_t power_mod(uint64_t base, uint64_t exponent, uint64_t m) {
+    uint64_t result = 1;
+    base %= m;
+    for (; exponent != 0; exponent >>= 1) {
+        if (exponent & 1)
+            result = multiply_mod(result, base, m);
+        base = multiply_mod(base, base, m);
+    }
+    return result;
+}
+
+static uint64_t gcd(uint64_t a, uint64_t b) {
+    while (b != 0) {
+        uint64_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+static const uint64_t small_primes[] = { 2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37 };
+
+bool is_prime(uint64_t n) {
+    if (n < 2)
+        return false;
+    for (uint64_t p : small_primes) {
+        if (n % p == 0)
+            return n == p;
+    }
+
+    // n - 1 = d * 2^s, with d odd.
+    uint64_t d = n - 1;
+    int s = __builtin_ctzll(d);
+    d >>= s;
+
+    for (uint64_t witness : small_primes) {
+        uint64_t x = power_mod(witness, d, n);
+        if (x == 1 || x == n - 1)
+            continue;
+        bool composite = true;
+        for (int i = 1; i < s && composite; ++i) {
+            x = multiply_mod(x, x, n);
+            if (x == n - 1)
+                composite = false;
+        }
+        if (composite)
+            return false;
+    }
+    return true;
+}
+
+// Some nontrivial factor of n, which must be odd, composite and not a
+// perfect power of a small prime (trial division has already dealt with
+// those). Brent's cycle detection on x -> x^2 + c, batching gcds so we take
+// one per hundred or so steps rather than one per step.
+static uint64_t find_factor(uint64_t n) {
+    for (uint64_t c = 1;; ++c) {
+        auto step = [n, c](uint64_t x) {
+            uint64_t y = multiply_mod(x, x, n) + c;
+            return y >= n || y < c ? y - n : y;
+        };
+
+        const uint64_t batch = 128;
+        uint64_t y = 2;
+        uint64_t x = y;
+        uint64_t saved = y;
+        uint64_t product = 1;
+        uint64_t divisor = 1;
+        for (uint64_t length = 1; divisor == 1; length *= 2) {
+            x = y;
+            for (uint64_t i = 0; i < length; ++i)
+                y = step(y);
+            for (uint64_t done = 0; done < length && divisor == 1; done += batch) {
+                saved = y;
+                uint64_t count = std::min(batch, length - done);
+                for (uint64_t i = 0; i < count; ++i) {
+                    y = step(y);
+                    product = multiply_mod(product, x > y ? x - y : y - x, n);
+                }
+                divisor = gcd(product, n);
+            }
+        }
+
+        // The batched gcd overshot and collected every factor at once, so
+        // back up and go one step at a time.
+        if (divisor == n) {
+            do {
+                saved = step(saved);
+                divisor = gcd(x > saved ? x - saved : saved - x, n);
+            } while (divisor == 1);
+        }
+
+        if (divisor != n)
+            return divisor;
+        // Unlucky choice of c. Try another.
+    }
+}
+
+static void factor_into(uint64_t n, std::vector<uint64_t>& primes) {
+    if (n == 1)
+        return;
+    if (is_prime(n)) {
+        primes.push_back(n);
+        return;
+    }
+    uint64_t divisor = find_factor(n);
+    factor_into(divisor, primes);
+    factor_into(n / divisor, primes);
+}
+
+std::vector<PrimePower> factor(uint64_t n) {
+    if (n == 0)
+        std::abort();
+
+    std::vector<uint64_t> primes;
+    for (uint64_t p = 2; p < 1000 && p * p <= n; p += (p == 2 ? 1 : 2)) {
+        while (n % p == 0) {
+            primes.push_back(p);
+            n /= p;
+        }
+    }
+    factor_into(n, primes);
+    std::sort(primes.begin(), primes.end());
+
+    std::vector<PrimePower> result;
+    for (uint64_t p : primes) {
+        if (!result.empty() && result.back().prime == p)
+            ++result.back().exponent;
+        else
+            result.push_back(PrimePower{p, 1});
+    }
+    return result;
+}
+
+// Extended Euclid on a and m, keeping only a's coefficient: s * a == r
+// (mod m) at every step, and the last nonzero r is the gcd g. Then s is a's
+// inverse modulo m / g, and the solutions are spaced m / g apart.
+bool solve_linear_congruence(uint64_t a, uint64_t b, uint64_t m, uint64_t& x) {
+    if (m == 0)
+        std::abort();
+
+    __extension__ typedef __int128 int128_t;
+    int128_t r0 = m;
+    int128_t r1 = a % m;
+    int128_t s0 = 0;
+    int128_t s1 = 1;
+    while (r1 != 0) {
+        int128_t q = r0 / r1;
+        int128_t r = r0 - q * r1;
+        r0 = r1;
+        r1 = r;
+        int128_t s = s0 - q * s1;
+        s0 = s1;
+        s1 = s;
+    }
+
+    uint64_t g = static_cast<uint64_t>(r0);
+    if (b % g != 0)
+        return false;
+    uint64_t period = m / g;
+    uint64_t inverse = static_cast<uint64_t>(((s0 % period) + period) % period);
+    x = multiply_mod((b % m) / g, inverse, period);
+    return true;
+}
+
+}
@@ -0,0 +1,63 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2016 Michael Catanzaro <michael.catanzaro@mst.edu>
+ * Copyright (c) 2016 Jacob Fischer <jtf3m8@mst.edu>
+ * Copyright (c) 2016 Christian Storer <cs9yb@mst.edu>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace multinv {
+
+// One prime power p^e dividing some number.
+struct PrimePower {
+    uint64_t prime;
+    unsigned int exponent;
+};
+
+// Deterministic for every 64-bit n: Miller-Rabin with the first twelve primes
+// as witnesses is known to have no 64-bit pseudoprimes.
+// Reference: https://oeis.org/A014233
+bool is_prime(uint64_t n);
+
+// The prime factorization of n, smallest prime first. factor(1) is empty,
+// and factor(0) crashes, since zero doesn't have one.
+//
+// This exists because testing a polynomial for primitivity, or finding the
+// order of a field element, needs the prime factors of 2^n - 1. Trial
+// division takes care of small factors and Pollard's rho (Brent's variant)
+// of the rest, so even 2^64 - 1 takes well under a millisecond.
+// Reference: https://en.wikipedia.org/wiki/Pollard%27s_rho_algorithm
+std::vector<PrimePower> factor(uint64_t n);
+
+// The smallest x >= 0 with a * x == b (mod m), if there is one, which is when
+// gcd(a, m) divides b. Crashes if m is zero. Discrete logarithms come down to
+// this, since log(a^k) == k * log(a) modulo the order of the group.
+bool solve_linear_congruence(uint64_t a, uint64_t b, uint64_t m, uint64_t& x);
+
+}
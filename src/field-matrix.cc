@@ -0,0 +1,376 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2016 Michael Catanzaro <michael.catanzaro@mst.edu>
+ * Copyright (c) 2016 Jacob Fischer <jtf3m8@mst.edu>
+ * Copyright (c) 2016 Christian Storer <cs9yb@mst.edu>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "field-matrix.h"
+
+#include "field-tables.h"
+#include "region.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+namespace multinv {
+
+// Rows per task, and per RegionMatrix.
+static const size_t block_rows = 64;
+
+// How much of the inner dimension one RegionMatrix covers in multiply(). With
+// block_rows, that's 256 KiB of prepared tables per tile, and 128 rows of b
+// for gf_matrix_region() to stream through together.
+static const size_t block_inner = 128;
+
+// Columns per panel in row_reduce().
+static const size_t panel_width = 64;
+
+FieldMatrix::FieldMatrix(size_t rows, size_t columns, uint16_t irreducible_polynomial, int characteristic)
+    : m_rows(rows)
+    , m_columns(columns)
+    , m_irreducible_polynomial(irreducible_polynomial)
+    , m_characteristic(characteristic)
+    , m_elements(rows * columns)
+{
+    assert(FieldTables::get(irreducible_polynomial, characteristic));
+}
+
+FieldMatrix::FieldMatrix(size_t rows, size_t columns, std::vector<uint8_t> elements,
+                         uint16_t irreducible_polynomial, int characteristic)
+    : m_rows(rows)
+    , m_columns(columns)
+    , m_irreducible_polynomial(irreducible_polynomial)
+    , m_characteristic(characteristic)
+    , m_elements(std::move(elements))
+{
+    assert(FieldTables::get(irreducible_polynomial, characteristic));
+    if (m_elements.size() != rows * columns)
+        std::abort();
+#ifndef NDEBUG
+    for (uint8_t e : m_elements)
+        assert((e >> characteristic) == 0);
+#endif
+}
+
+FieldMatrix FieldMatrix::identity(size_t size, uint16_t irreducible_polynomial, int characteristic) {
+    FieldMatrix result(size, size, irreducible_polynomial, characteristic);
+    for (size_t i = 0; i < size; ++i)
+        result.m_elements[i * size + i] = 1;
+    return result;
+}
+
+void FieldMatrix::set(size_t r, size_t column, uint8_t value) {
+    assert((value >> m_characteristic) == 0);
+    m_elements[r * m_columns + column] = value;
+}
+
+FieldMatrix& FieldMatrix::operator+=(const FieldMatrix& rhs) {
+    assert(m_irreducible_polynomial == rhs.m_irreducible_polynomial);
+    assert(m_characteristic == rhs.m_characteristic);
+    if (m_rows != rhs.m_rows || m_columns != rhs.m_columns)
+        std::abort();
+
+    gf_add_region(m_elements.data(), rhs.m_elements.data(), m_elements.size());
+    return *this;
+}
+
+FieldMatrix& FieldMatrix::operator-=(const FieldMatrix& rhs) {
+    return *this += rhs;
+}
+
+FieldMatrix& FieldMatrix::operator*=(const FieldMatrix& rhs) {
+    *this = multiply(*this, rhs);
+    return *this;
+}
+
+// Calls body(begin, end) on blocks of at most block_rows of [0, count), on the
+// pool if there is one.
+template <typename Body>
+static void for_each_block(ThreadPool* pool, size_t count, Body&& body) {
+    if (pool) {
+        pool->parallel_for(count, block_rows, body);
+        return;
+    }
+    for (size_t begin = 0; begin < count; begin += block_rows)
+        body(begin, std::min(count, begin + block_rows));
+}
+
+FieldMatrix multiply(const FieldMatrix& a, const FieldMatrix& b, ThreadPool* pool) {
+    assert(a.irreducible_polynomial() == b.irreducible_polynomial());
+    assert(a.characteristic() == b.characteristic());
+    if (a.columns() != b.rows())
+        std::abort();
+
+    uint16_t ip = a.irreducible_polynomial();
+    int n = a.characteristic();
+    size_t inner = a.columns();
+    size_t width = b.columns();
+    FieldMatrix product(a.rows(), width, ip, n);
+    if (inner == 0 || width == 0)
+        return product;
+
+    for_each_block(pool, a.rows(), [&](size_t begin, size_t end) {
+        size_t count = end - begin;
+        std::vector<uint8_t> tile;
+        std::vector<const uint8_t*> sources;
+        std::vector<uint8_t*> destinations(count);
+        // The first tile writes straight into the product. The rest have to
+        // be added in, since gf_matrix_region() overwrites its output.
+        std::vector<uint8_t> scratch;
+        std::vector<uint8_t*> scratch_rows(count);
+
+        for (size_t k0 = 0; k0 < inner; k0 += block_inner) {
+            size_t k1 = std::min(inner, k0 + block_inner);
+
+            tile.clear();
+            for (size_t r = begin; r < end; ++r)
+                tile.insert(tile.end(), a.row(r) + k0, a.row(r) + k1);
+            RegionMatrix matrix(tile.data(), count, k1 - k0, ip, n);
+
+            sources.clear();
+            for (size_t k = k0; k < k1; ++k)
+                sources.push_back(b.row(k));
+
+            if (k0 == 0) {
+                for (size_t r = 0; r < count; ++r)
+                    destinations[r] = product.row(begin + r);
+                gf_matrix_region(destinations.data(), sources.data(), matrix, width);
+            } else {
+                scratch.resize(count * width);
+                for (size_t r = 0; r < count; ++r)
+                    scratch_rows[r] = scratch.data() + r * width;
+                gf_matrix_region(scratch_rows.data(), sources.data(), matrix, width);
+                for (size_t r = 0; r < count; ++r)
+                    gf_add_region(product.row(begin + r), scratch_rows[r], width);
+            }
+        }
+    });
+
+    return product;
+}
+
+static void swap_rows(uint8_t* a, uint8_t* b, size_t len) {
+    std::swap_ranges(a, a + len, b);
+}
+
+// Gauss-Jordan on a small size x size matrix that's known to be invertible.
+static std::vector<uint8_t> invert_small(std::vector<uint8_t> matrix, size_t size, const FieldTables& tables) {
+    std::vector<uint8_t> inverse(size * size);
+    for (size_t i = 0; i < size; ++i)
+        inverse[i * size + i] = 1;
+
+    for (size_t column = 0; column < size; ++column) {
+        size_t pivot = column;
+        while (matrix[pivot * size + column] == 0) {
+            ++pivot;
+            assert(pivot < size);
+        }
+        if (pivot != column) {
+            swap_rows(&matrix[pivot * size], &matrix[column * size], size);
+            swap_rows(&inverse[pivot * size], &inverse[column * size], size);
+        }
+
+        uint8_t scale = tables.inverse(matrix[column * size + column]);
+        for (size_t j = 0; j < size; ++j) {
+            matrix[column * size + j] = tables.multiply(matrix[column * size + j], scale);
+            inverse[column * size + j] = tables.multiply(inverse[column * size + j], scale);
+        }
+
+        for (size_t r = 0; r < size; ++r) {
+            uint8_t factor = matrix[r * size + column];
+            if (r == column || factor == 0)
+                continue;
+            for (size_t j = 0; j < size; ++j) {
+                matrix[r * size + j] ^= tables.multiply(factor, matrix[column * size + j]);
+                inverse[r * size + j] ^= tables.multiply(factor, inverse[column * size + j]);
+            }
+        }
+    }
+
+    return inverse;
+}
+
+size_t row_reduce(FieldMatrix& matrix, ThreadPool* pool) {
+    uint16_t ip = matrix.irreducible_polynomial();
+    int n = matrix.characteristic();
+    const FieldTables& tables = FieldTables::require(ip, n);
+    size_t rows = matrix.rows();
+    size_t columns = matrix.columns();
+    size_t rank = 0;
+
+    std::vector<uint8_t> panel;
+    std::vector<size_t> pivot_columns;
+
+    for (size_t c0 = 0; c0 < columns && rank < rows; c0 += panel_width) {
+        size_t width = std::min(columns - c0, panel_width);
+        size_t first = rank;
+
+        // Find this panel's pivots by eliminating within a copy of the panel.
+        // Only rows that could still become pivot rows matter here; rows
+        // above get fixed up along with everything else below.
+        panel.resize(rows * width);
+        for (size_t r = first; r < rows; ++r)
+            std::memcpy(&panel[r * width], matrix.row(r) + c0, width);
+        pivot_columns.clear();
+
+        for (size_t c = 0; c < width && rank < rows; ++c) {
+            size_t pivot = rank;
+            while (pivot < rows && panel[pivot * width + c] == 0)
+                ++pivot;
+            if (pivot == rows)
+                continue;
+            if (pivot != rank) {
+                swap_rows(&panel[pivot * width], &panel[rank * width], width);
+                swap_rows(matrix.row(pivot), matrix.row(rank), columns);
+            }
+
+            uint8_t* pivot_row = &panel[rank * width];
+            uint8_t scale = tables.inverse(pivot_row[c]);
+            for (size_t j = c; j < width; ++j)
+                pivot_row[j] = tables.multiply(pivot_row[j], scale);
+            for (size_t r = rank + 1; r < rows; ++r) {
+                uint8_t* row = &panel[r * width];
+                uint8_t factor = row[c];
+                if (factor == 0)
+                    continue;
+                for (size_t j = c; j < width; ++j)
+                    row[j] ^= tables.multiply(factor, pivot_row[j]);
+            }
+
+            pivot_columns.push_back(c);
+            ++rank;
+        }
+
+        size_t found = rank - first;
+        if (found == 0)
+            continue;
+
+        // Every row operation in the panel together amounts to this: if Q is
+        // the pivot rows' original entries in the pivot columns, the pivot
+        // rows become Q^-1 times themselves, and every other row has
+        // row[pivot columns] times the new pivot rows subtracted from it. The
+        // pivot rows are already swapped into place.
+        size_t len = columns - c0;
+        std::vector<uint8_t> q(found * found);
+        for (size_t i = 0; i < found; ++i) {
+            for (size_t j = 0; j < found; ++j)
+                q[i * found + j] = matrix.at(first + i, c0 + pivot_columns[j]);
+        }
+        std::vector<uint8_t> q_inverse = invert_small(std::move(q), found, tables);
+
+        std::vector<uint8_t> pivot_rows(found * len);
+        std::vector<const uint8_t*> sources(found);
+        std::vector<uint8_t*> destinations(found);
+        for (size_t i = 0; i < found; ++i) {
+            sources[i] = matrix.row(first + i) + c0;
+            destinations[i] = &pivot_rows[i * len];
+        }
+        RegionMatrix scale_pivots(q_inverse.data(), found, found, ip, n);
+        gf_matrix_region(destinations.data(), sources.data(), scale_pivots, len);
+        for (size_t i = 0; i < found; ++i) {
+            std::memcpy(matrix.row(first + i) + c0, destinations[i], len);
+            sources[i] = matrix.row(first + i) + c0;
+        }
+
+        // The rows around the pivot rows, counted as if the pivot rows
+        // weren't there.
+        for_each_block(pool, rows - found, [&](size_t begin, size_t end) {
+            size_t count = end - begin;
+            std::vector<uint8_t> factors(count * found);
+            std::vector<uint8_t> scratch(count * len);
+            std::vector<uint8_t*> targets(count);
+            std::vector<uint8_t*> scratch_rows(count);
+            for (size_t i = 0; i < count; ++i) {
+                size_t r = begin + i < first ? begin + i : begin + i + found;
+                targets[i] = matrix.row(r) + c0;
+                scratch_rows[i] = &scratch[i * len];
+                for (size_t j = 0; j < found; ++j)
+                    factors[i * found + j] = targets[i][pivot_columns[j]];
+            }
+
+            RegionMatrix eliminate(factors.data(), count, found, ip, n);
+            gf_matrix_region(scratch_rows.data(), sources.data(), eliminate, len);
+            for (size_t i = 0; i < count; ++i)
+                gf_add_region(targets[i], scratch_rows[i], len);
+        });
+    }
+
+    return rank;
+}
+
+size_t rank(FieldMatrix matrix, ThreadPool* pool) {
+    return row_reduce(matrix, pool);
+}
+
+bool invert(FieldMatrix& matrix, ThreadPool* pool) {
+    if (!matrix.is_square())
+        std::abort();
+
+    // Row reduce [A | I]. If A is invertible, that gives [I | A^-1]; if not,
+    // the last row's pivot ends up on the right.
+    size_t size = matrix.rows();
+    FieldMatrix augmented(size, 2 * size, matrix.irreducible_polynomial(), matrix.characteristic());
+    for (size_t r = 0; r < size; ++r) {
+        std::memcpy(augmented.row(r), matrix.row(r), size);
+        augmented.row(r)[size + r] = 1;
+    }
+
+    row_reduce(augmented, pool);
+    if (size > 0 && augmented.at(size - 1, size - 1) == 0)
+        return false;
+
+    for (size_t r = 0; r < size; ++r)
+        std::memcpy(matrix.row(r), augmented.row(r) + size, size);
+    return true;
+}
+
+FieldMatrix operator+(FieldMatrix a, const FieldMatrix& b) {
+    return a += b;
+}
+
+FieldMatrix operator-(FieldMatrix a, const FieldMatrix& b) {
+    return a -= b;
+}
+
+FieldMatrix operator*(const FieldMatrix& a, const FieldMatrix& b) {
+    return multiply(a, b);
+}
+
+bool operator==(const FieldMatrix& a, const FieldMatrix& b) {
+    return a.irreducible_polynomial() == b.irreducible_polynomial() &&
+           a.characteristic() == b.characteristic() &&
+           a.rows() == b.rows() && a.columns() == b.columns() &&
+           a.elements() == b.elements();
+}
+
+bool operator!=(const FieldMatrix& a, const FieldMatrix& b) {
+    return !(a == b);
+}
+
+}
@@ -0,0 +1,117 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2016 Michael Catanzaro <michael.catanzaro@mst.edu>
+ * Copyright (c) 2016 Jacob Fischer <jtf3m8@mst.edu>
+ * Copyright (c) 2016 Christian Storer <cs9yb@mst.edu>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "polynomial.h"
+#include "thread-pool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace multinv {
+
+// A dense rows x columns matrix over GF(2^n), n<=8, stored row by row in one
+// contiguous buffer, one byte per element. That's an eighth the size of a
+// grid of Polynomials, and lets whole rows go through the region kernels.
+class FieldMatrix {
+  public:
+    // All zeros.
+    FieldMatrix(size_t rows, size_t columns,
+                uint16_t irreducible_polynomial = Polynomial::aes_irreducible_polynomial,
+                int characteristic = 8);
+    // elements has rows * columns elements, row by row.
+    FieldMatrix(size_t rows, size_t columns, std::vector<uint8_t> elements,
+                uint16_t irreducible_polynomial = Polynomial::aes_irreducible_polynomial,
+                int characteristic = 8);
+
+    static FieldMatrix identity(size_t size,
+                                uint16_t irreducible_polynomial = Polynomial::aes_irreducible_polynomial,
+                                int characteristic = 8);
+
+    size_t rows() const { return m_rows; }
+    size_t columns() const { return m_columns; }
+    bool is_square() const { return m_rows == m_columns; }
+
+    uint8_t at(size_t row, size_t column) const { return m_elements[row * m_columns + column]; }
+    void set(size_t row, size_t column, uint8_t value);
+    uint8_t* row(size_t r) { return m_elements.data() + r * m_columns; }
+    const uint8_t* row(size_t r) const { return m_elements.data() + r * m_columns; }
+    const std::vector<uint8_t>& elements() const { return m_elements; }
+
+    // The field the elements belong to, as for Polynomial.
+    uint16_t irreducible_polynomial() const { return m_irreducible_polynomial; }
+    int characteristic() const { return m_characteristic; }
+
+    FieldMatrix& operator+=(const FieldMatrix&);
+    FieldMatrix& operator-=(const FieldMatrix&);
+    FieldMatrix& operator*=(const FieldMatrix&);
+
+  private:
+    size_t m_rows;
+    size_t m_columns;
+    uint16_t m_irreducible_polynomial;
+    int m_characteristic;
+    std::vector<uint8_t> m_elements;
+};
+
+// The algorithms below optionally split their work across a ThreadPool, a
+// block of rows per task. Without one, they run on the calling thread.
+
+// a * b. a.columns() must equal b.rows().
+//
+// Blocked so that each piece of b gets used by a block of rows of a while it
+// is still in cache: every tile of a becomes a RegionMatrix and is applied to
+// the matching rows of b with gf_matrix_region().
+FieldMatrix multiply(const FieldMatrix& a, const FieldMatrix& b, ThreadPool* = nullptr);
+
+// Gauss-Jordan elimination in place, leaving the matrix in reduced row
+// echelon form. Returns the rank.
+//
+// Pivots are found a panel of columns at a time using only those columns,
+// then the row operations for the whole panel are applied to the rest of the
+// matrix at once, as one matrix multiplication. So the bulk of the work goes
+// through gf_matrix_region() rather than one row operation per pivot.
+size_t row_reduce(FieldMatrix&, ThreadPool* = nullptr);
+
+size_t rank(FieldMatrix, ThreadPool* = nullptr);
+
+// Replaces a square matrix with its inverse and returns true, or returns false
+// and leaves it alone if it's singular.
+bool invert(FieldMatrix&, ThreadPool* = nullptr);
+
+FieldMatrix operator+(FieldMatrix, const FieldMatrix&);
+FieldMatrix operator-(FieldMatrix, const FieldMatrix&);
+FieldMatrix operator*(const FieldMatrix&, const FieldMatrix&);
+
+bool operator==(const FieldMatrix&, const FieldMatrix&);
+bool operator!=(const FieldMatrix&, const FieldMatrix&);
+
+}
@@ -0,0 +1,628 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2016 Michael Catanzaro <michael.catanzaro@mst.edu>
+ * Copyright (c) 2016 Jacob Fischer <jtf3m8@mst.edu>
+ * Copyright (c) 2016 Christian Storer <cs9yb@mst.edu>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "field-polynomial.h"
+
+#include "field-tables.h"
+#include "region.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <utility>
+
+namespace multinv {
+
+// Below this many coefficients, Karatsuba hands over to schoolbook.
+static const size_t karatsuba_threshold = 32;
+
+// Quotients and divisors at least this long are divided by Newton iteration,
+// which turns division into a couple of multiplications.
+static const size_t newton_division_threshold = 512;
+
+FieldPolynomial::FieldPolynomial(uint16_t irreducible_polynomial, int characteristic)
+    : m_irreducible_polynomial(irreducible_polynomial)
+    , m_characteristic(characteristic)
+{
+    assert(FieldTables::get(irreducible_polynomial, characteristic));
+}
+
+FieldPolynomial::FieldPolynomial(std::vector<uint8_t> coefficients, uint16_t irreducible_polynomial, int characteristic)
+    : m_coefficients(std::move(coefficients))
+    , m_irreducible_polynomial(irreducible_polynomial)
+    , m_characteristic(characteristic)
+{
+    assert(FieldTables::get(irreducible_polynomial, characteristic));
+#ifndef NDEBUG
+    for (uint8_t c : m_coefficients)
+        assert((c >> characteristic) == 0);
+#endif
+    normalize();
+}
+
+void FieldPolynomial::normalize() {
+    while (!m_coefficients.empty() && m_coefficients.back() == 0)
+        m_coefficients.pop_back();
+}
+
+void FieldPolynomial::set_coefficient(size_t i, uint8_t value) {
+    assert((value >> m_characteristic) == 0);
+    if (i >= m_coefficients.size()) {
+        if (value == 0)
+            return;
+        m_coefficients.resize(i + 1);
+    }
+    m_coefficients[i] = value;
+    normalize();
+}
+
+uint8_t FieldPolynomial::evaluate(uint8_t x) const {
+    const FieldTables& tables = FieldTables::require(m_irreducible_polynomial, m_characteristic);
+    uint8_t result = 0;
+    for (size_t i = m_coefficients.size(); i-- > 0;)
+        result = tables.multiply(result, x) ^ m_coefficients[i];
+    return result;
+}
+
+FieldPolynomial& FieldPolynomial::operator+=(const FieldPolynomial& rhs) {
+    assert(m_irreducible_polynomial == rhs.m_irreducible_polynomial);
+    assert(m_characteristic == rhs.m_characteristic);
+
+    if (m_coefficients.size() < rhs.m_coefficients.size())
+        m_coefficients.resize(rhs.m_coefficients.size());
+    for (size_t i = 0; i < rhs.m_coefficients.size(); ++i)
+        m_coefficients[i] ^= rhs.m_coefficients[i];
+    normalize();
+    return *this;
+}
+
+FieldPolynomial& FieldPolynomial::operator-=(const FieldPolynomial& rhs) {
+    return *this += rhs;
+}
+
+FieldPolynomial& FieldPolynomial::operator*=(const FieldPolynomial& rhs) {
+    *this = multiply(*this, rhs);
+    return *this;
+}
+
+// gf_mul_add_region() has to build tables for every constant, which takes
+// about as long as doing a couple of hundred elements the slow way.
+static const size_t region_threshold = 256;
+
+// dst[i] += constant * src[i]
+static void mul_add(uint8_t* dst, const uint8_t* src, uint8_t constant, size_t len, const FieldTables& tables) {
+    if (constant == 0)
+        return;
+    if (len >= region_threshold) {
+        gf_mul_add_region(dst, src, constant, len, tables.irreducible_polynomial(), tables.characteristic());
+        return;
+    }
+    for (size_t i = 0; i < len; ++i)
+        dst[i] ^= tables.multiply(constant, src[i]);
+}
+
+// out[0, na + nb - 1) += a * b, one row at a time.
+static void multiply_schoolbook(uint8_t* out, const uint8_t* a, size_t na, const uint8_t* b, size_t nb,
+                                const FieldTables& tables) {
+    // Longer rows make for fewer, more efficient region calls.
+    if (na > nb) {
+        std::swap(a, b);
+        std::swap(na, nb);
+    }
+
+    if (nb >= region_threshold) {
+        for (size_t i = 0; i < na; ++i)
+            mul_add(out + i, b, a[i], nb, tables);
+        return;
+    }
+
+    // Short rows: take the logarithms of b once, rather than once per row.
+    unsigned int logs[region_threshold];
+    for (size_t j = 0; j < nb; ++j)
+        logs[j] = b[j] ? tables.log(b[j]) : 0;
+    for (size_t i = 0; i < na; ++i) {
+        if (a[i] == 0)
+            continue;
+        unsigned int log_a = tables.log(a[i]);
+        uint8_t* row = out + i;
+        for (size_t j = 0; j < nb; ++j) {
+            if (b[j])
+                row[j] ^= tables.exp(log_a + logs[j]);
+        }
+    }
+}
+
+// The Gao-Mateer additive FFT: evaluates f, which has 2^m coefficients, at
+// every point in the GF(2)-linear span of basis[0..m), in place. Point i is
+// the sum of the basis elements selected by the bits of i, so with the
+// basis 1, x, x^2, ..., point i is just the element i.
+//
+// The trick is that x^2 + x is linear with kernel {0, 1}. Writing
+// f(x) = f0(x^2 + x) + x f1(x^2 + x) turns one evaluation at 2^m points into
+// two at 2^(m-1) points.
+// Reference: S. Gao and T. Mateer, "Additive Fast Fourier Transforms Over
+// Finite Fields", IEEE Transactions on Information Theory 56(12), 2010.
+
+// Rewrites f, which has len (a power of two) coefficients, as
+// sum (t0_i + t1_i x)(x^2 + x)^i, leaving t0_i in f[2i] and t1_i in f[2i + 1].
+// Dividing by (x^2 + x)^(len/4) = x^(len/2) + x^(len/4) takes just two passes
+// of XORs, and the quotient and remainder can then be expanded independently.
+static void taylor_expand(uint8_t* f, size_t len) {
+    if (len <= 2)
+        return;
+
+    size_t s = len / 4;
+    for (size_t i = 0; i < s; ++i)
+        f[2 * s + i] ^= f[3 * s + i];
+    for (size_t i = 0; i < s; ++i)
+        f[s + i] ^= f[2 * s + i];
+
+    taylor_expand(f, len / 2);
+    taylor_expand(f + len / 2, len / 2);
+}
+
+static void inverse_taylor_expand(uint8_t* f, size_t len) {
+    if (len <= 2)
+        return;
+
+    inverse_taylor_expand(f, len / 2);
+    inverse_taylor_expand(f + len / 2, len / 2);
+
+    size_t s = len / 4;
+    for (size_t i = 0; i < s; ++i)
+        f[s + i] ^= f[2 * s + i];
+    for (size_t i = 0; i < s; ++i)
+        f[2 * s + i] ^= f[3 * s + i];
+}
+
+// For a basis b_0..b_(m-1), the evaluation of f(b_(m-1) x) happens on the
+// span of gamma_i = b_i / b_(m-1) (plus 1), and the half-size evaluations on
+// the span of delta_i = gamma_i^2 + gamma_i.
+static void subspace_basis(const uint8_t* basis, int m, uint8_t* gamma, uint8_t* delta, const FieldTables& tables) {
+    uint8_t beta = basis[m - 1];
+    for (int i = 0; i < m - 1; ++i) {
+        gamma[i] = tables.divide(basis[i], beta);
+        delta[i] = tables.square(gamma[i]) ^ gamma[i];
+    }
+}
+
+// Every element of the span of gamma[0..m-1), in the same order as the
+// evaluation points.
+static void subspace_elements(const uint8_t* gamma, int m, uint8_t* elements) {
+    elements[0] = 0;
+    for (size_t i = 1; i < (size_t{1} << (m - 1)); ++i)
+        elements[i] = elements[i & (i - 1)] ^ gamma[__builtin_ctzl(i)];
+}
+
+// scratch needs room for 2^m elements.
+static void additive_fft(uint8_t* f, int m, const uint8_t* basis, const FieldTables& tables, uint8_t* scratch) {
+    if (m == 0)
+        return;
+    if (m == 1) {
+        f[1] = f[0] ^ tables.multiply(f[1], basis[0]);
+        return;
+    }
+
+    size_t len = size_t{1} << m;
+    size_t half = len / 2;
+    uint8_t beta = basis[m - 1];
+
+    // g(x) = f(beta x)
+    uint8_t power = 1;
+    for (size_t i = 0; i < len; ++i) {
+        f[i] = tables.multiply(f[i], power);
+        power = tables.multiply(power, beta);
+    }
+
+    taylor_expand(f, len);
+
+    // Even coefficients are g0, odd ones g1.
+    for (size_t i = 0; i < half; ++i) {
+        scratch[i] = f[2 * i];
+        scratch[half + i] = f[2 * i + 1];
+    }
+    std::copy(scratch, scratch + len, f);
+
+    uint8_t gamma[8];
+    uint8_t delta[8];
+    subspace_basis(basis, m, gamma, delta, tables);
+    additive_fft(f, m - 1, delta, tables, scratch);
+    additive_fft(f + half, m - 1, delta, tables, scratch);
+
+    // g(gamma) = g0(delta) + gamma g1(delta), and gamma + 1 maps to the same
+    // delta.
+    subspace_elements(gamma, m, scratch);
+    for (size_t i = 0; i < half; ++i) {
+        uint8_t u = f[i];
+        uint8_t v = f[half + i];
+        f[i] = u ^ tables.multiply(scratch[i], v);
+        f[half + i] = f[i] ^ v;
+    }
+}
+
+// Undoes additive_fft(), step by step in reverse.
+static void inverse_additive_fft(uint8_t* f, int m, const uint8_t* basis, const FieldTables& tables, uint8_t* scratch) {
+    if (m == 0)
+        return;
+    if (m == 1) {
+        f[1] = tables.divide(f[0] ^ f[1], basis[0]);
+        return;
+    }
+
+    size_t len = size_t{1} << m;
+    size_t half = len / 2;
+    uint8_t beta = basis[m - 1];
+
+    uint8_t gamma[8];
+    uint8_t delta[8];
+    subspace_basis(basis, m, gamma, delta, tables);
+    subspace_elements(gamma, m, scratch);
+    for (size_t i = 0; i < half; ++i) {
+        uint8_t v = f[i] ^ f[half + i];
+        f[i] ^= tables.multiply(scratch[i], v);
+        f[half + i] = v;
+    }
+
+    inverse_additive_fft(f, m - 1, delta, tables, scratch);
+    inverse_additive_fft(f + half, m - 1, delta, tables, scratch);
+
+    for (size_t i = 0; i < half; ++i) {
+        scratch[2 * i] = f[i];
+        scratch[2 * i + 1] = f[half + i];
+    }
+    std::copy(scratch, scratch + len, f);
+
+    inverse_taylor_expand(f, len);
+
+    uint8_t inverse_beta = tables.inverse(beta);
+    uint8_t power = 1;
+    for (size_t i = 0; i < len; ++i) {
+        f[i] = tables.multiply(f[i], power);
+        power = tables.multiply(power, inverse_beta);
+    }
+}
+
+// The basis 1, x, x^2, ..., so that evaluation point i is the element i.
+static const uint8_t standard_basis[8] = { 1, 2, 4, 8, 16, 32, 64, 128 };
+
+// out[0, 2 len - 1) = a * b, where a and b have len coefficients each and the
+// product fits in the field: 2 len - 1 <= 2^n.
+static void multiply_fft(uint8_t* out, const uint8_t* a, const uint8_t* b, size_t len, const FieldTables& tables) {
+    int m = 0;
+    while ((size_t{1} << m) < 2 * len - 1)
+        ++m;
+    assert(m <= tables.characteristic());
+
+    size_t points = size_t{1} << m;
+    uint8_t fa[256] = { };
+    uint8_t fb[256] = { };
+    uint8_t scratch[256];
+    std::copy(a, a + len, fa);
+    std::copy(b, b + len, fb);
+
+    additive_fft(fa, m, standard_basis, tables, scratch);
+    additive_fft(fb, m, standard_basis, tables, scratch);
+    for (size_t i = 0; i < points; ++i)
+        fa[i] = tables.multiply(fa[i], fb[i]);
+    inverse_additive_fft(fa, m, standard_basis, tables, scratch);
+
+    std::copy(fa, fa + 2 * len - 1, out);
+}
+
+static void multiply_schoolbook_balanced(uint8_t* out, const uint8_t* a, const uint8_t* b, size_t len,
+                                         const FieldTables& tables) {
+    std::fill(out, out + 2 * len - 1, 0);
+    multiply_schoolbook(out, a, len, b, len, tables);
+}
+
+typedef void (*BaseMultiply)(uint8_t* out, const uint8_t* a, const uint8_t* b, size_t len, const FieldTables&);
+
+// out[0, 2 len - 1) = a * b, where a and b have len coefficients each:
+// a0 b0 + x^h ((a0 + a1)(b0 + b1) - a0 b0 - a1 b1) + x^2h a1 b1. Products of
+// at most threshold coefficients are handed to base. scratch needs room for
+// 4 (len + 64) elements.
+static void karatsuba(uint8_t* out, const uint8_t* a, const uint8_t* b, size_t len,
+                      BaseMultiply base, size_t threshold, const FieldTables& tables, uint8_t* scratch) {
+    if (len <= threshold) {
+        base(out, a, b, len, tables);
+        return;
+    }
+
+    size_t h = (len + 1) / 2;
+    size_t l = len - h;
+    uint8_t* sa = scratch;
+    uint8_t* sb = sa + h;
+    uint8_t* z1 = sb + h;
+    uint8_t* rest = z1 + 2 * h;
+
+    karatsuba(out, a, b, h, base, threshold, tables, rest);
+    out[2 * h - 1] = 0;
+    karatsuba(out + 2 * h, a + h, b + h, l, base, threshold, tables, rest);
+
+    for (size_t i = 0; i < h; ++i) {
+        sa[i] = a[i] ^ (i < l ? a[h + i] : 0);
+        sb[i] = b[i] ^ (i < l ? b[h + i] : 0);
+    }
+    karatsuba(z1, sa, sb, h, base, threshold, tables, rest);
+
+    for (size_t i = 0; i < 2 * h - 1; ++i)
+        z1[i] ^= out[i];
+    for (size_t i = 0; i < 2 * l - 1; ++i)
+        z1[i] ^= out[2 * h + i];
+    for (size_t i = 0; i < 2 * h - 1; ++i)
+        out[h + i] ^= z1[i];
+}
+
+// Karatsuba only splits evenly, so a long a is cut into pieces as long as b.
+static void multiply_recursive(uint8_t* out, const uint8_t* a, size_t na, const uint8_t* b, size_t nb,
+                               BaseMultiply base, size_t threshold, const FieldTables& tables) {
+    if (na < nb) {
+        std::swap(a, b);
+        std::swap(na, nb);
+    }
+
+    std::vector<uint8_t> scratch(4 * (nb + 64));
+    std::vector<uint8_t> piece(nb);
+    std::vector<uint8_t> product(2 * nb - 1);
+    for (size_t k = 0; k < na; k += nb) {
+        size_t len = std::min(nb, na - k);
+        const uint8_t* chunk = a + k;
+        if (len < nb) {
+            std::fill(std::copy(chunk, chunk + len, piece.begin()), piece.end(), 0);
+            chunk = piece.data();
+        }
+        karatsuba(product.data(), chunk, b, nb, base, threshold, tables, scratch.data());
+        for (size_t i = 0; i < len + nb - 1; ++i)
+            out[k + i] ^= product[i];
+    }
+}
+
+FieldPolynomial multiply(const FieldPolynomial& a, const FieldPolynomial& b, MultiplicationAlgorithm algorithm) {
+    assert(a.irreducible_polynomial() == b.irreducible_polynomial());
+    assert(a.characteristic() == b.characteristic());
+
+    if (a.is_zero() || b.is_zero())
+        return FieldPolynomial(a.irreducible_polynomial(), a.characteristic());
+
+    const FieldTables& tables = FieldTables::require(a.irreducible_polynomial(), a.characteristic());
+    const std::vector<uint8_t>& ca = a.coefficients();
+    const std::vector<uint8_t>& cb = b.coefficients();
+    std::vector<uint8_t> product(ca.size() + cb.size() - 1);
+
+    if (algorithm == MultiplicationAlgorithm::Automatic) {
+        // The FFT never wins: the field is too small for it to get going
+        // before it runs out of points. See bench-multinv /field-polynomial/.
+        if (std::min(ca.size(), cb.size()) <= karatsuba_threshold)
+            algorithm = MultiplicationAlgorithm::Schoolbook;
+        else
+            algorithm = MultiplicationAlgorithm::Karatsuba;
+    }
+
+    switch (algorithm) {
+    case MultiplicationAlgorithm::Schoolbook:
+        multiply_schoolbook(product.data(), ca.data(), ca.size(), cb.data(), cb.size(), tables);
+        break;
+    case MultiplicationAlgorithm::Karatsuba:
+        multiply_recursive(product.data(), ca.data(), ca.size(), cb.data(), cb.size(),
+                           multiply_schoolbook_balanced, karatsuba_threshold, tables);
+        break;
+    case MultiplicationAlgorithm::AdditiveFFT:
+        multiply_recursive(product.data(), ca.data(), ca.size(), cb.data(), cb.size(),
+                           multiply_fft, size_t{1} << (a.characteristic() - 1), tables);
+        break;
+    case MultiplicationAlgorithm::Automatic:
+    default:
+        std::abort();
+    }
+
+    return FieldPolynomial(std::move(product), a.irreducible_polynomial(), a.characteristic());
+}
+
+// Long division, one row of the divisor at a time. quotient must have room
+// for na - nb + 1 coefficients, and the remainder is left in the low nb - 1
+// coefficients of a.
+static void divide_schoolbook(uint8_t* a, size_t na, const uint8_t* b, size_t nb, uint8_t* quotient,
+                              const FieldTables& tables) {
+    uint8_t inverse_lead = tables.inverse(b[nb - 1]);
+    for (size_t i = na; i-- > nb - 1;) {
+        uint8_t q = tables.multiply(a[i], inverse_lead);
+        quotient[i - (nb - 1)] = q;
+        mul_add(a + i - (nb - 1), b, q, nb, tables);
+    }
+}
+
+// 1 / f mod x^precision, for f with a nonzero constant term, by Newton
+// iteration: g' = g (2 - f g), which in characteristic 2 is just f g^2. And
+// squaring is linear, so g^2 costs nothing but spreading out the squared
+// coefficients.
+static FieldPolynomial inverse_power_series(const FieldPolynomial& f, size_t precision, const FieldTables& tables) {
+    std::vector<uint8_t> g{ tables.inverse(f.coefficient(0)) };
+    for (size_t have = 1; have < precision;) {
+        have = std::min(2 * have, precision);
+
+        std::vector<uint8_t> square(2 * g.size() - 1);
+        for (size_t i = 0; i < g.size(); ++i)
+            square[2 * i] = tables.square(g[i]);
+
+        std::vector<uint8_t> low(f.coefficients().begin(),
+                                 f.coefficients().begin() + std::min(have, f.coefficients().size()));
+        FieldPolynomial next = multiply(FieldPolynomial(std::move(low), f.irreducible_polynomial(), f.characteristic()),
+                                        FieldPolynomial(std::move(square), f.irreducible_polynomial(), f.characteristic()));
+        g = next.coefficients();
+        g.resize(have);
+    }
+    return FieldPolynomial(std::move(g), f.irreducible_polynomial(), f.characteristic());
+}
+
+// With rev(p) meaning p's coefficients in reverse order, a = q b + r becomes
+// rev(a) = rev(q) rev(b) + x^(deg a - deg r) rev(r), so rev(q) is
+// rev(a) / rev(b) mod x^(deg q + 1), which Newton iteration finds with a
+// couple of multiplications.
+static void divide_newton(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b,
+                          std::vector<uint8_t>& quotient, std::vector<uint8_t>& remainder,
+                          const FieldTables& tables, uint16_t ip, int n) {
+    size_t k = a.size() - b.size() + 1;
+
+    std::vector<uint8_t> reversed_b(b.rbegin(), b.rend());
+    if (reversed_b.size() > k)
+        reversed_b.resize(k);
+    FieldPolynomial inverse = inverse_power_series(FieldPolynomial(std::move(reversed_b), ip, n), k, tables);
+
+    std::vector<uint8_t> reversed_a(a.rbegin(), a.rbegin() + k);
+    FieldPolynomial reversed_q = multiply(FieldPolynomial(std::move(reversed_a), ip, n), inverse);
+
+    quotient.assign(k, 0);
+    for (size_t i = 0; i < k; ++i)
+        quotient[k - 1 - i] = reversed_q.coefficient(i);
+
+    FieldPolynomial qb = multiply(FieldPolynomial(quotient, ip, n), FieldPolynomial(b, ip, n));
+    remainder.assign(a.begin(), a.begin() + (b.size() - 1));
+    for (size_t i = 0; i < remainder.size(); ++i)
+        remainder[i] ^= qb.coefficient(i);
+}
+
+void divmod(const FieldPolynomial& dividend, const FieldPolynomial& divisor,
+            FieldPolynomial& quotient, FieldPolynomial& remainder) {
+    uint16_t ip = dividend.irreducible_polynomial();
+    int n = dividend.characteristic();
+    assert(divisor.irreducible_polynomial() == ip);
+    assert(divisor.characteristic() == n);
+
+    if (divisor.is_zero())
+        std::abort();
+
+    if (dividend.degree() < divisor.degree()) {
+        quotient = FieldPolynomial(ip, n);
+        remainder = dividend;
+        return;
+    }
+
+    const FieldTables& tables = FieldTables::require(ip, n);
+    const std::vector<uint8_t>& a = dividend.coefficients();
+    const std::vector<uint8_t>& b = divisor.coefficients();
+    std::vector<uint8_t> q(a.size() - b.size() + 1);
+    std::vector<uint8_t> r;
+
+    if (q.size() >= newton_division_threshold && b.size() >= newton_division_threshold) {
+        divide_newton(a, b, q, r, tables, ip, n);
+    } else {
+        r = a;
+        divide_schoolbook(r.data(), r.size(), b.data(), b.size(), q.data(), tables);
+        r.resize(b.size() - 1);
+    }
+
+    quotient = FieldPolynomial(std::move(q), ip, n);
+    remainder = FieldPolynomial(std::move(r), ip, n);
+}
+
+FieldPolynomial gcd(FieldPolynomial a, FieldPolynomial b) {
+    FieldPolynomial quotient(a.irreducible_polynomial(), a.characteristic());
+    FieldPolynomial remainder(a.irreducible_polynomial(), a.characteristic());
+    while (!b.is_zero()) {
+        divmod(a, b, quotient, remainder);
+        a = std::move(b);
+        b = std::move(remainder);
+    }
+
+    if (a.is_zero())
+        return a;
+
+    const FieldTables& tables = FieldTables::require(a.irreducible_polynomial(), a.characteristic());
+    std::vector<uint8_t> monic = a.coefficients();
+    gf_mul_region(monic.data(), monic.data(), tables.inverse(monic.back()), monic.size(),
+                  a.irreducible_polynomial(), a.characteristic());
+    return FieldPolynomial(std::move(monic), a.irreducible_polynomial(), a.characteristic());
+}
+
+std::vector<uint8_t> evaluate(const FieldPolynomial& p, const std::vector<uint8_t>& points) {
+    std::vector<uint8_t> values(points.size());
+    int n = p.characteristic();
+    size_t field_size = size_t{1} << n;
+    const std::vector<uint8_t>& c = p.coefficients();
+
+    // Horner's rule costs deg p multiplications per point; the FFT costs
+    // about n 2^n for every point in the field.
+    if (points.size() * c.size() <= 4 * n * field_size) {
+        for (size_t i = 0; i < points.size(); ++i)
+            values[i] = p.evaluate(points[i]);
+        return values;
+    }
+
+    // x^(2^n) = x for every x in the field, so reduce p mod x^(2^n) - x
+    // first: x^i becomes x^((i - 1) mod (2^n - 1) + 1).
+    std::vector<uint8_t> f(field_size);
+    for (size_t i = 0; i < c.size(); ++i)
+        f[i < field_size ? i : (i - 1) % (field_size - 1) + 1] ^= c[i];
+
+    std::vector<uint8_t> scratch(field_size);
+    additive_fft(f.data(), n, standard_basis, FieldTables::require(p.irreducible_polynomial(), n), scratch.data());
+    for (size_t i = 0; i < points.size(); ++i)
+        values[i] = f[points[i]];
+    return values;
+}
+
+FieldPolynomial operator+(FieldPolynomial lhs, const FieldPolynomial& rhs) {
+    lhs += rhs;
+    return lhs;
+}
+
+FieldPolynomial operator-(FieldPolynomial lhs, const FieldPolynomial& rhs) {
+    lhs -= rhs;
+    return lhs;
+}
+
+FieldPolynomial operator*(const FieldPolynomial& lhs, const FieldPolynomial& rhs) {
+    return multiply(lhs, rhs);
+}
+
+FieldPolynomial operator/(const FieldPolynomial& lhs, const FieldPolynomial& rhs) {
+    FieldPolynomial quotient(lhs.irreducible_polynomial(), lhs.characteristic());
+    FieldPolynomial remainder(lhs.irreducible_polynomial(), lhs.characteristic());
+    divmod(lhs, rhs, quotient, remainder);
+    return quotient;
+}
+
+FieldPolynomial operator%(const FieldPolynomial& lhs, const FieldPolynomial& rhs) {
+    FieldPolynomial quotient(lhs.irreducible_polynomial(), lhs.characteristic());
+    FieldPolynomial remainder(lhs.irreducible_polynomial(), lhs.characteristic());
+    divmod(lhs, rhs, quotient, remainder);
+    return remainder;
+}
+
+bool operator==(const FieldPolynomial& lhs, const FieldPolynomial& rhs) {
+    return lhs.irreducible_polynomial() == rhs.irreducible_polynomial()
+        && lhs.characteristic() == rhs.characteristic()
+        && lhs.coefficients() == rhs.coefficients();
+}
+
+bool operator!=(const FieldPolynomial& lhs, const FieldPolynomial& rhs) {
+    return !(lhs == rhs);
+}
+
+}
@@ -0,0 +1,123 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2016 Michael Catanzaro <michael.catanzaro@mst.edu>
+ * Copyright (c) 2016 Jacob Fischer <jtf3m8@mst.edu>
+ * Copyright (c) 2016 Christian Storer <cs9yb@mst.edu>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "polynomial.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace multinv {
+
+// A polynomial whose coefficients are elements of GF(2^n), n<=8, as opposed to
+// Polynomial, which is a single element of GF(2^n) (and therefore a polynomial
+// over GF(2)). These form a ring rather than a field: there's division with
+// remainder, but no inverses.
+//
+// Coefficients are stored lowest degree first, one per byte, with no trailing
+// zeros, so the zero polynomial has no coefficients at all and degree -1.
+class FieldPolynomial {
+  public:
+    explicit FieldPolynomial(uint16_t irreducible_polynomial = Polynomial::aes_irreducible_polynomial,
+                             int characteristic = 8);
+    explicit FieldPolynomial(std::vector<uint8_t> coefficients,
+                             uint16_t irreducible_polynomial = Polynomial::aes_irreducible_polynomial,
+                             int characteristic = 8);
+
+    long degree() const { return static_cast<long>(m_coefficients.size()) - 1; }
+    bool is_zero() const { return m_coefficients.empty(); }
+    // Zero for anything past the degree.
+    uint8_t coefficient(size_t i) const { return i < m_coefficients.size() ? m_coefficients[i] : 0; }
+    void set_coefficient(size_t i, uint8_t value);
+    const std::vector<uint8_t>& coefficients() const { return m_coefficients; }
+
+    // The field the coefficients belong to, as for Polynomial.
+    uint16_t irreducible_polynomial() const { return m_irreducible_polynomial; }
+    int characteristic() const { return m_characteristic; }
+
+    // Horner's rule. See also the multipoint evaluate() below.
+    uint8_t evaluate(uint8_t x) const;
+
+    FieldPolynomial& operator+=(const FieldPolynomial&);
+    FieldPolynomial& operator-=(const FieldPolynomial&);
+    FieldPolynomial& operator*=(const FieldPolynomial&);
+
+  private:
+    void normalize();
+
+    std::vector<uint8_t> m_coefficients;
+    uint16_t m_irreducible_polynomial;
+    int m_characteristic;
+};
+
+// Ways to multiply two FieldPolynomials. They all give the same answer.
+enum class MultiplicationAlgorithm {
+    // Whichever is fastest for polynomials of this size.
+    Automatic,
+    // Every coefficient of one times every coefficient of the other. O(n^2)
+    // multiplications, but done a whole row at a time by gf_mul_add_region().
+    Schoolbook,
+    // Three half-size products instead of four, recursively, down to
+    // schoolbook. O(n^1.58).
+    Karatsuba,
+    // Evaluate both at 2^k points with the Gao-Mateer additive FFT, multiply
+    // pointwise, interpolate. O(n log^2 n), but GF(2^n) only has 2^n points
+    // to evaluate at, so it can only produce products with up to 2^n
+    // coefficients. Bigger products are split up Karatsuba-style until the
+    // pieces fit.
+    AdditiveFFT,
+};
+
+FieldPolynomial multiply(const FieldPolynomial&, const FieldPolynomial&,
+                         MultiplicationAlgorithm = MultiplicationAlgorithm::Automatic);
+
+// dividend = quotient * divisor + remainder, with deg remainder < deg divisor.
+// Dividing by the zero polynomial crashes.
+void divmod(const FieldPolynomial& dividend, const FieldPolynomial& divisor,
+            FieldPolynomial& quotient, FieldPolynomial& remainder);
+
+// The monic greatest common divisor, or zero if both are zero.
+FieldPolynomial gcd(FieldPolynomial, FieldPolynomial);
+
+// p(x) for every x in points. Many points are done all at once with the
+// additive FFT, which evaluates p at every element of the field.
+std::vector<uint8_t> evaluate(const FieldPolynomial& p, const std::vector<uint8_t>& points);
+
+FieldPolynomial operator+(FieldPolynomial, const FieldPolynomial&);
+FieldPolynomial operator-(FieldPolynomial, const FieldPolynomial&);
+FieldPolynomial operator*(const FieldPolynomial&, const FieldPolynomial&);
+FieldPolynomial operator/(const FieldPolynomial&, const FieldPolynomial&);
+FieldPolynomial operator%(const FieldPolynomial&, const FieldPolynomial&);
+
+bool operator==(const FieldPolynomial&, const FieldPolynomial&);
+bool operator!=(const FieldPolynomial&, const FieldPolynomial&);
+
+}
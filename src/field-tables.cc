@@ -0,0 +1,139 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2016 Michael Catanzaro <michael.catanzaro@mst.edu>
+ * Copyright (c) 2016 Jacob Fischer <jtf3m8@mst.edu>
+ * Copyright (c) 2016 Christian Storer <cs9yb@mst.edu>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "field-tables.h"
+
+#include "polynomial.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+
+namespace multinv {
+
+// One slot for every possible field: indexed by characteristic, then by the
+// irreducible polynomial with its leading term dropped.
+struct CacheEntry {
+    std::atomic<const FieldTables*> tables;
+    std::atomic<bool> checked;
+};
+
+static CacheEntry cache[9][256];
+static std::mutex cache_mutex;
+
+const FieldTables* FieldTables::get(uint16_t irreducible_polynomial, int characteristic) {
+    if (characteristic < 1 || characteristic > 8)
+        return nullptr;
+    if ((irreducible_polynomial >> characteristic) != 1)
+        return nullptr;
+
+    CacheEntry& entry = cache[characteristic][irreducible_polynomial & 0xff];
+    const FieldTables* tables = entry.tables.load(std::memory_order_acquire);
+    if (tables || entry.checked.load(std::memory_order_acquire))
+        return tables;
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    if (!entry.checked.load(std::memory_order_relaxed)) {
+        entry.tables.store(build(irreducible_polynomial, characteristic), std::memory_order_release);
+        entry.checked.store(true, std::memory_order_release);
+    }
+    return entry.tables.load(std::memory_order_relaxed);
+}
+
+const FieldTables& FieldTables::require(uint16_t irreducible_polynomial, int characteristic) {
+    const FieldTables* tables = get(irreducible_polynomial, characteristic);
+    if (!tables)
+        std::abort();
+    return *tables;
+}
+
+const FieldTables* FieldTables::build(uint16_t irreducible_polynomial, int characteristic) {
+    unsigned int order = (1u << characteristic) - 1;
+
+    // A generator is any element whose powers cycle through all order()
+    // nonzero elements before returning to 1. Every field has one; if nothing
+    // qualifies, the polynomial isn't irreducible and this isn't a field.
+    for (unsigned int candidate = 1; candidate <= order; ++candidate) {
+        uint8_t g = static_cast<uint8_t>(candidate);
+        uint8_t power = g;
+        unsigned int cycle = 1;
+        while (power != 1 && cycle <= order) {
+            power = multiply_bitwise(power, g, irreducible_polynomial, characteristic);
+            ++cycle;
+        }
+        if (power == 1 && cycle == order)
+            return new FieldTables(irreducible_polynomial, characteristic, g);
+    }
+
+    return nullptr;
+}
+
+FieldTables::FieldTables(uint16_t irreducible_polynomial, int characteristic, uint8_t generator)
+    : m_irreducible_polynomial(irreducible_polynomial)
+    , m_characteristic(characteristic)
+    , m_order((1u << characteristic) - 1)
+    , m_generator(generator)
+    , m_exp()
+    , m_log()
+    , m_inverse()
+    , m_square()
+    , m_sqrt()
+    , m_reduce()
+{
+    uint8_t power = 1;
+    for (unsigned int i = 0; i < 2 * m_order; ++i) {
+        m_exp[i] = power;
+        if (i < m_order)
+            m_log[power] = static_cast<uint8_t>(i);
+        power = multiply_bitwise(power, generator, irreducible_polynomial, characteristic);
+    }
+
+    for (unsigned int a = 1; a <= m_order; ++a)
+        m_inverse[a] = m_exp[(m_order - m_log[a]) % m_order];
+
+    for (unsigned int a = 0; a <= m_order; ++a) {
+        m_square[a] = multiply(a, a);
+        m_sqrt[m_square[a]] = static_cast<uint8_t>(a);
+    }
+
+    for (unsigned int h = 0; h < (1u << (characteristic - 1)); ++h)
+        m_reduce[h] = reduce_constant_time(static_cast<uint16_t>(h << characteristic), irreducible_polynomial, characteristic);
+}
+
+uint8_t FieldTables::power(uint8_t a, unsigned int exponent) const {
+    if (exponent == 0)
+        return 1;
+    if (a == 0)
+        return 0;
+
+    unsigned long long log = static_cast<unsigned long long>(m_log[a]) * (exponent % m_order);
+    return m_exp[log % m_order];
+}
+
+}
@@ -0,0 +1,120 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2016 Michael Catanzaro <michael.catanzaro@mst.edu>
+ * Copyright (c) 2016 Jacob Fischer <jtf3m8@mst.edu>
+ * Copyright (c) 2016 Christian Storer <cs9yb@mst.edu>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+
+namespace multinv {
+
+// Log/antilog tables for one field GF(2^n), n<=8.
+//
+// A field this small has at most 256 elements, so rather than shifting and
+// reducing on every multiplication we find a generator g once, tabulate g^i
+// and its inverse function, and turn multiplication into addition of
+// logarithms. Tables are built on first use, shared by everybody using the
+// same field, and never freed.
+// Reference: https://en.wikipedia.org/wiki/Finite_field_arithmetic#Generator_based_tables
+class FieldTables {
+  public:
+    // Returns the tables for the field defined by irreducible_polynomial, or
+    // nullptr if irreducible_polynomial is not an irreducible polynomial of
+    // degree characteristic (i.e. it doesn't define a field at all).
+    // Looking up tables that have already been built is lock-free and cheap.
+    static const FieldTables* get(uint16_t irreducible_polynomial, int characteristic);
+    // The same, for code that has no use for anything but a field: crashes
+    // instead of returning nullptr.
+    static const FieldTables& require(uint16_t irreducible_polynomial, int characteristic);
+
+    uint16_t irreducible_polynomial() const { return m_irreducible_polynomial; }
+    int characteristic() const { return m_characteristic; }
+    // The number of nonzero elements, 2^n - 1.
+    unsigned int order() const { return m_order; }
+    // The element whose powers were tabulated.
+    uint8_t generator() const { return m_generator; }
+
+    // g^i, for 0 <= i < 2 * order().
+    uint8_t exp(unsigned int i) const { return m_exp[i]; }
+    // log_g(a), for a != 0.
+    unsigned int log(uint8_t a) const { assert(a != 0); return m_log[a]; }
+
+    uint8_t multiply(uint8_t a, uint8_t b) const {
+        if (a == 0 || b == 0)
+            return 0;
+        return m_exp[m_log[a] + m_log[b]];
+    }
+
+    uint8_t divide(uint8_t a, uint8_t b) const {
+        assert(b != 0);
+        if (a == 0)
+            return 0;
+        return m_exp[m_log[a] + m_order - m_log[b]];
+    }
+
+    // Zero has no inverse. Since somebody has to pick something, inverse(0)
+    // is zero, which is what AES does.
+    uint8_t inverse(uint8_t a) const { return m_inverse[a]; }
+
+    uint8_t power(uint8_t a, unsigned int exponent) const;
+
+    // Squaring is linear over GF(2) (it's the Frobenius map), and so is its
+    // inverse, so every element has exactly one square root.
+    uint8_t square(uint8_t a) const { return m_square[a]; }
+    uint8_t sqrt(uint8_t a) const { return m_sqrt[a]; }
+
+    // value modulo the irreducible polynomial, for value of degree at most
+    // 2n - 2, as from multiply_carryless(). The bits from x^n up are a linear
+    // function of the result, so one table of them does it.
+    uint8_t reduce(uint16_t value) const {
+        assert((value >> (2 * m_characteristic - 1)) == 0);
+        return static_cast<uint8_t>((value & m_order) ^ m_reduce[value >> m_characteristic]);
+    }
+
+  private:
+    FieldTables(uint16_t irreducible_polynomial, int characteristic, uint8_t generator);
+
+    static const FieldTables* build(uint16_t irreducible_polynomial, int characteristic);
+
+    uint16_t m_irreducible_polynomial;
+    int m_characteristic;
+    unsigned int m_order;
+    uint8_t m_generator;
+
+    // Doubled up so multiply() and divide() never need to reduce mod order().
+    uint8_t m_exp[512];
+    uint8_t m_log[256];
+    uint8_t m_inverse[256];
+    uint8_t m_square[256];
+    uint8_t m_sqrt[256];
+    // h * x^n, reduced, for every h of degree less than n - 1.
+    uint8_t m_reduce[128];
+};
+
+}
@@ -0,0 +1,610 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2016 Michael Catanzaro <michael.catanzaro@mst.edu>
+ * Copyright (c) 2016 Jacob Fischer <jtf3m8@mst.edu>
+ * Copyright (c) 2016 Christian Storer <cs9yb@mst.edu>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "field-vector.h"
+
+#include "field-tables.h"
+#include "region.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+#if defined(__x86_64__)
+#define HAVE_BMI2 1
+#include <immintrin.h>
+#else
+#define HAVE_BMI2 0
+#endif
+
+namespace multinv {
+
+// The on-disk format is a 32 byte header followed directly by data_size()
+// bytes of elements, exactly as they're laid out in memory, so a mapped file
+// can be used as is. Integers in the header are little-endian:
+//
+//   0   magic, "GFVECTOR"
+//   8   format version, 32 bits
+//   12  irreducible polynomial, 16 bits
+//   14  characteristic, 8 bits
+//   15  layout, 8 bits: 0 for Bytes, 1 for Packed
+//   16  number of elements, 64 bits
+//   24  reserved, zero
+//
+// Anything that changes the meaning of existing files has to bump the version.
+// The packed layout is defined in terms of bytes, not words, so the elements
+// read the same on any machine.
+static const char file_magic[8] = {'G', 'F', 'V', 'E', 'C', 'T', 'O', 'R'};
+static const uint32_t file_version = 1;
+static const size_t header_size = 32;
+
+// Elements per bulk operation block in the Packed layout. A multiple of eight,
+// so that blocks start and end on byte boundaries.
+static const size_t block_size = 4096;
+
+static void store_le(uint8_t* p, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i)
+        p[i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+static uint64_t load_le(const uint8_t* p, size_t bytes) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; ++i)
+        value |= static_cast<uint64_t>(p[i]) << (8 * i);
+    return value;
+}
+
+// Unaligned little-endian 64-bit loads and stores, for whole groups of eight
+// packed elements that have eight bytes to spare.
+static uint64_t load64(const uint8_t* p) {
+    uint64_t value;
+    std::memcpy(&value, p, 8);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap64(value);
+#endif
+    return value;
+}
+
+static void store64(uint8_t* p, uint64_t value) {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap64(value);
+#endif
+    std::memcpy(p, &value, 8);
+}
+
+static void write_header(uint8_t* header, size_t size, uint16_t irreducible_polynomial,
+                         int characteristic, FieldVectorLayout layout) {
+    std::memset(header, 0, header_size);
+    std::memcpy(header, file_magic, sizeof file_magic);
+    store_le(header + 8, file_version, 4);
+    store_le(header + 12, irreducible_polynomial, 2);
+    header[14] = static_cast<uint8_t>(characteristic);
+    header[15] = layout == FieldVectorLayout::Packed ? 1 : 0;
+    store_le(header + 16, size, 8);
+}
+
+size_t FieldVector::storage_size(size_t size, int characteristic, FieldVectorLayout layout) {
+    if (layout == FieldVectorLayout::Bytes)
+        return size;
+    return (size * characteristic + 7) / 8;
+}
+
+FieldVector::FieldVector(size_t size, uint16_t irreducible_polynomial, int characteristic, FieldVectorLayout layout)
+    : m_size(size)
+    , m_irreducible_polynomial(irreducible_polynomial)
+    , m_characteristic(characteristic)
+    , m_layout(layout)
+    , m_writable(true)
+    , m_storage(storage_size(size, characteristic, layout))
+    , m_data(m_storage.data())
+    , m_mapping(nullptr)
+    , m_mapping_size(0)
+{
+    assert(FieldTables::get(irreducible_polynomial, characteristic));
+}
+
+FieldVector::FieldVector(const std::vector<uint8_t>& elements, uint16_t irreducible_polynomial,
+                         int characteristic, FieldVectorLayout layout)
+    : FieldVector(elements.size(), irreducible_polynomial, characteristic, layout)
+{
+    put(0, elements.size(), elements.data());
+}
+
+FieldVector::FieldVector(size_t size, uint16_t irreducible_polynomial, int characteristic, FieldVectorLayout layout,
+                         uint8_t* mapping, size_t mapping_size, bool writable)
+    : m_size(size)
+    , m_irreducible_polynomial(irreducible_polynomial)
+    , m_characteristic(characteristic)
+    , m_layout(layout)
+    , m_writable(writable)
+    , m_data(mapping + header_size)
+    , m_mapping(mapping)
+    , m_mapping_size(mapping_size)
+{
+}
+
+FieldVector::FieldVector(const FieldVector& other)
+    : m_size(other.m_size)
+    , m_irreducible_polynomial(other.m_irreducible_polynomial)
+    , m_characteristic(other.m_characteristic)
+    , m_layout(other.m_layout)
+    , m_writable(true)
+    , m_storage(other.m_data, other.m_data + other.data_size())
+    , m_data(m_storage.data())
+    , m_mapping(nullptr)
+    , m_mapping_size(0)
+{
+}
+
+FieldVector::FieldVector(FieldVector&& other)
+    : m_size(other.m_size)
+    , m_irreducible_polynomial(other.m_irreducible_polynomial)
+    , m_characteristic(other.m_characteristic)
+    , m_layout(other.m_layout)
+    , m_writable(other.m_writable)
+    , m_storage(std::move(other.m_storage))
+    , m_data(other.m_mapping ? other.m_data : m_storage.data())
+    , m_mapping(other.m_mapping)
+    , m_mapping_size(other.m_mapping_size)
+{
+    other.m_size = 0;
+    other.m_writable = true;
+    other.m_storage.clear();
+    other.m_data = other.m_storage.data();
+    other.m_mapping = nullptr;
+    other.m_mapping_size = 0;
+}
+
+FieldVector::~FieldVector() {
+    if (m_mapping)
+        munmap(m_mapping, m_mapping_size);
+}
+
+FieldVector& FieldVector::operator=(FieldVector other) {
+    // Swapping vectors doesn't move their buffers, so m_data stays valid.
+    std::swap(m_size, other.m_size);
+    std::swap(m_irreducible_polynomial, other.m_irreducible_polynomial);
+    std::swap(m_characteristic, other.m_characteristic);
+    std::swap(m_layout, other.m_layout);
+    std::swap(m_writable, other.m_writable);
+    std::swap(m_storage, other.m_storage);
+    std::swap(m_data, other.m_data);
+    std::swap(m_mapping, other.m_mapping);
+    std::swap(m_mapping_size, other.m_mapping_size);
+    return *this;
+}
+
+std::unique_ptr<FieldVector> FieldVector::create(const char* path, size_t size, uint16_t irreducible_polynomial,
+                                                 int characteristic, FieldVectorLayout layout) {
+    assert(FieldTables::get(irreducible_polynomial, characteristic));
+
+    int fd = ::open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (fd == -1)
+        return nullptr;
+
+    size_t mapping_size = header_size + storage_size(size, characteristic, layout);
+    void* mapping = MAP_FAILED;
+    if (ftruncate(fd, mapping_size) == 0)
+        mapping = mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+        return nullptr;
+
+    uint8_t* bytes = static_cast<uint8_t*>(mapping);
+    write_header(bytes, size, irreducible_polynomial, characteristic, layout);
+    return std::unique_ptr<FieldVector>(new FieldVector(size, irreducible_polynomial, characteristic, layout,
+                                                        bytes, mapping_size, true));
+}
+
+std::unique_ptr<FieldVector> FieldVector::open(const char* path, bool writable) {
+    int fd = ::open(path, (writable ? O_RDWR : O_RDONLY) | O_CLOEXEC);
+    if (fd == -1)
+        return nullptr;
+
+    struct stat st;
+    void* mapping = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && static_cast<size_t>(st.st_size) >= header_size)
+        mapping = mmap(nullptr, st.st_size, PROT_READ | (writable ? PROT_WRITE : 0), MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+        return nullptr;
+
+    size_t mapping_size = st.st_size;
+    uint8_t* bytes = static_cast<uint8_t*>(mapping);
+    uint64_t size = load_le(bytes + 16, 8);
+    uint16_t irreducible_polynomial = static_cast<uint16_t>(load_le(bytes + 12, 2));
+    int characteristic = bytes[14];
+    uint8_t layout = bytes[15];
+
+    // Every element takes at least one bit, which keeps the size check below
+    // from overflowing.
+    bool valid = std::memcmp(bytes, file_magic, sizeof file_magic) == 0
+        && load_le(bytes + 8, 4) == file_version
+        && characteristic >= 1 && characteristic <= 8
+        && FieldTables::get(irreducible_polynomial, characteristic)
+        && layout <= 1
+        && size / 8 <= mapping_size
+        && header_size + storage_size(size, characteristic, static_cast<FieldVectorLayout>(layout)) <= mapping_size;
+    if (!valid) {
+        munmap(mapping, mapping_size);
+        errno = EINVAL;
+        return nullptr;
+    }
+
+    return std::unique_ptr<FieldVector>(new FieldVector(size, irreducible_polynomial, characteristic,
+                                                        static_cast<FieldVectorLayout>(layout),
+                                                        bytes, mapping_size, writable));
+}
+
+bool FieldVector::save(const char* path) const {
+    int fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (fd == -1)
+        return false;
+
+    uint8_t header[header_size];
+    write_header(header, m_size, m_irreducible_polynomial, m_characteristic, m_layout);
+
+    bool ok = true;
+    const uint8_t* pieces[] = { header, m_data };
+    size_t lengths[] = { header_size, data_size() };
+    for (size_t i = 0; ok && i < 2; ++i) {
+        const uint8_t* p = pieces[i];
+        size_t len = lengths[i];
+        while (len > 0) {
+            ssize_t written = write(fd, p, len);
+            if (written < 0) {
+                if (errno == EINTR)
+                    continue;
+                ok = false;
+                break;
+            }
+            p += written;
+            len -= written;
+        }
+    }
+
+    if (close(fd) != 0)
+        ok = false;
+    return ok;
+}
+
+// In the Packed layout, element i is bits [i * n, i * n + n) of the data, so
+// it lies within two adjacent bytes.
+uint8_t FieldVector::packed_at(size_t i) const {
+    const unsigned n = m_characteristic;
+    size_t bit = i * n;
+    size_t byte = bit / 8;
+    unsigned bits = m_data[byte];
+    if (byte + 1 < (m_size * n + 7) / 8)
+        bits |= m_data[byte + 1] << 8;
+    return static_cast<uint8_t>((bits >> (bit % 8)) & ((1u << n) - 1));
+}
+
+void FieldVector::set(size_t i, uint8_t value) {
+    assert(i < m_size);
+    assert((value >> m_characteristic) == 0);
+    if (!m_writable)
+        std::abort();
+    if (m_layout == FieldVectorLayout::Bytes) {
+        m_data[i] = value;
+        return;
+    }
+
+    const unsigned n = m_characteristic;
+    size_t bit = i * n;
+    size_t byte = bit / 8;
+    unsigned shift = bit % 8;
+    unsigned mask = ((1u << n) - 1) << shift;
+    unsigned shifted = value << shift;
+    m_data[byte] = static_cast<uint8_t>((m_data[byte] & ~mask) | shifted);
+    if (shift + n > 8)
+        m_data[byte + 1] = static_cast<uint8_t>((m_data[byte + 1] & ~(mask >> 8)) | (shifted >> 8));
+}
+
+// Bulk packing and unpacking go a group of eight elements at a time: the
+// group starting at element 8g is the n bytes starting at byte ng, read as one
+// little-endian number. Groups with at least eight bytes of data from their
+// start, i.e. all but the last few, are moved with a single 64-bit access.
+// These are templates so that every shift is a constant.
+
+template<unsigned n>
+static void unpack_groups(const uint8_t* packed, uint8_t* elements, size_t groups) {
+    const uint64_t mask = (1u << n) - 1;
+    for (size_t g = 0; g < groups; ++g) {
+        uint64_t group = load64(packed + g * n);
+        for (unsigned k = 0; k < 8; ++k)
+            elements[8 * g + k] = static_cast<uint8_t>((group >> (k * n)) & mask);
+    }
+}
+
+// Each group is stored as a 64-bit word, whose top 8 - n bytes belong to the
+// groups after it. Those get overwritten next time round anyway, so only the
+// bytes past the last group need preserving, and they're read up front: once
+// the stores start, they're gone.
+template<unsigned n>
+static uint64_t bytes_after_groups(const uint8_t* packed, size_t groups) {
+    if (n == 8 || groups == 0)
+        return 0;
+    return load64(packed + (groups - 1) * n) & ~((uint64_t(1) << (8 * n % 64)) - 1);
+}
+
+template<unsigned n>
+static void pack_groups(const uint8_t* elements, uint8_t* packed, size_t groups) {
+    const unsigned mask = (1u << n) - 1;
+    uint64_t after = bytes_after_groups<n>(packed, groups);
+    for (size_t g = 0; g < groups; ++g) {
+        uint64_t group = 0;
+        for (unsigned k = 0; k < 8; ++k)
+            group |= static_cast<uint64_t>(elements[8 * g + k] & mask) << (k * n);
+        if (g == groups - 1)
+            group |= after;
+        store64(packed + g * n, group);
+    }
+}
+
+#if HAVE_BMI2
+// PDEP scatters the low bits of a word to the positions set in a mask, so
+// with the low n bits of every byte set it unpacks a whole group at once, and
+// PEXT packs it back up.
+template<unsigned n>
+__attribute__((target("bmi2")))
+static void unpack_groups_bmi2(const uint8_t* packed, uint8_t* elements, size_t groups) {
+    const uint64_t mask = 0x0101010101010101ull * ((1u << n) - 1);
+    for (size_t g = 0; g < groups; ++g)
+        store64(elements + 8 * g, _pdep_u64(load64(packed + g * n), mask));
+}
+
+template<unsigned n>
+__attribute__((target("bmi2")))
+static void pack_groups_bmi2(const uint8_t* elements, uint8_t* packed, size_t groups) {
+    const uint64_t mask = 0x0101010101010101ull * ((1u << n) - 1);
+    uint64_t after = bytes_after_groups<n>(packed, groups);
+    for (size_t g = 0; g < groups; ++g) {
+        uint64_t group = _pext_u64(load64(elements + 8 * g), mask);
+        if (g == groups - 1)
+            group |= after;
+        store64(packed + g * n, group);
+    }
+}
+#endif
+
+using GroupFunction = void (*)(const uint8_t*, uint8_t*, size_t);
+
+static const GroupFunction unpack_functions[] = {
+    nullptr, unpack_groups<1>, unpack_groups<2>, unpack_groups<3>, unpack_groups<4>,
+    unpack_groups<5>, unpack_groups<6>, unpack_groups<7>, unpack_groups<8>,
+};
+
+static const GroupFunction pack_functions[] = {
+    nullptr, pack_groups<1>, pack_groups<2>, pack_groups<3>, pack_groups<4>,
+    pack_groups<5>, pack_groups<6>, pack_groups<7>, pack_groups<8>,
+};
+
+#if HAVE_BMI2
+static const GroupFunction unpack_functions_bmi2[] = {
+    nullptr, unpack_groups_bmi2<1>, unpack_groups_bmi2<2>, unpack_groups_bmi2<3>, unpack_groups_bmi2<4>,
+    unpack_groups_bmi2<5>, unpack_groups_bmi2<6>, unpack_groups_bmi2<7>, unpack_groups_bmi2<8>,
+};
+
+static const GroupFunction pack_functions_bmi2[] = {
+    nullptr, pack_groups_bmi2<1>, pack_groups_bmi2<2>, pack_groups_bmi2<3>, pack_groups_bmi2<4>,
+    pack_groups_bmi2<5>, pack_groups_bmi2<6>, pack_groups_bmi2<7>, pack_groups_bmi2<8>,
+};
+
+static bool have_bmi2() {
+    // Needed because we may be called during static initialization.
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("bmi2");
+}
+
+static const bool use_bmi2 = have_bmi2();
+#endif
+
+static GroupFunction unpack_function(int n) {
+#if HAVE_BMI2
+    if (use_bmi2)
+        return unpack_functions_bmi2[n];
+#endif
+    return unpack_functions[n];
+}
+
+static GroupFunction pack_function(int n) {
+#if HAVE_BMI2
+    if (use_bmi2)
+        return pack_functions_bmi2[n];
+#endif
+    return pack_functions[n];
+}
+
+// How many whole groups starting at element first, of the count elements
+// from there, can go through the functions above.
+static size_t whole_groups(size_t first, size_t count, int n, size_t data_size) {
+    if (first % 8 || data_size < 8)
+        return 0;
+    size_t safe = (data_size - 8) / n + 1;
+    size_t g = first / 8;
+    return g < safe ? std::min(count / 8, safe - g) : 0;
+}
+
+void FieldVector::get(size_t first, size_t count, uint8_t* elements) const {
+    assert(first + count <= m_size);
+    if (m_layout == FieldVectorLayout::Bytes) {
+        std::copy(m_data + first, m_data + first + count, elements);
+        return;
+    }
+
+    const unsigned n = m_characteristic;
+    size_t groups = whole_groups(first, count, n, data_size());
+    unpack_function(n)(m_data + first / 8 * n, elements, groups);
+    for (size_t i = 8 * groups; i < count; ++i)
+        elements[i] = packed_at(first + i);
+}
+
+void FieldVector::put(size_t first, size_t count, const uint8_t* elements) {
+    assert(first + count <= m_size);
+    if (!m_writable)
+        std::abort();
+    if (m_layout == FieldVectorLayout::Bytes) {
+        std::copy(elements, elements + count, m_data + first);
+        return;
+    }
+
+    const unsigned n = m_characteristic;
+    size_t groups = whole_groups(first, count, n, data_size());
+    pack_function(n)(elements, m_data + first / 8 * n, groups);
+    for (size_t i = 8 * groups; i < count; ++i)
+        set(first + i, elements[i]);
+}
+
+std::vector<uint8_t> FieldVector::elements() const {
+    std::vector<uint8_t> result(m_size);
+    get(0, m_size, result.data());
+    return result;
+}
+
+FieldVector FieldVector::with_layout(FieldVectorLayout layout) const {
+    return FieldVector(elements(), m_irreducible_polynomial, m_characteristic, layout);
+}
+
+// Calls function(dst, src, len) on this vector's elements and src's, one per
+// byte, a block at a time, then stores dst back. Without src, src is dst. In
+// the Bytes layout the elements are used where they are.
+template<typename Function>
+void FieldVector::transform(const FieldVector* src, Function function) {
+    if (!m_writable)
+        std::abort();
+    if (src && (src->m_size != m_size
+                || src->m_irreducible_polynomial != m_irreducible_polynomial
+                || src->m_characteristic != m_characteristic))
+        std::abort();
+
+    bool packed = m_layout == FieldVectorLayout::Packed;
+    bool src_packed = src && src->m_layout == FieldVectorLayout::Packed;
+    if (!packed && !src_packed) {
+        function(m_data, src ? src->m_data : m_data, m_size);
+        return;
+    }
+
+    uint8_t dst_block[block_size];
+    uint8_t src_block[block_size];
+    for (size_t first = 0; first < m_size; first += block_size) {
+        size_t count = std::min(block_size, m_size - first);
+        uint8_t* dst = m_data + first;
+        if (packed) {
+            get(first, count, dst_block);
+            dst = dst_block;
+        }
+        const uint8_t* source = dst;
+        if (src_packed) {
+            src->get(first, count, src_block);
+            source = src_block;
+        } else if (src) {
+            source = src->m_data + first;
+        }
+        function(dst, source, count);
+        if (packed)
+            put(first, count, dst_block);
+    }
+}
+
+FieldVector& FieldVector::operator+=(const FieldVector& rhs) {
+    // Addition is XOR, which doesn't care how the bits are grouped.
+    if (m_layout == rhs.m_layout) {
+        if (!m_writable || rhs.m_size != m_size
+            || rhs.m_irreducible_polynomial != m_irreducible_polynomial
+            || rhs.m_characteristic != m_characteristic)
+            std::abort();
+        gf_add_region(m_data, rhs.m_data, data_size());
+        return *this;
+    }
+    transform(&rhs, gf_add_region);
+    return *this;
+}
+
+FieldVector& FieldVector::operator-=(const FieldVector& rhs) {
+    // Characteristic two.
+    return *this += rhs;
+}
+
+void FieldVector::multiply(uint8_t constant) {
+    assert((constant >> m_characteristic) == 0);
+    transform(nullptr, [&](uint8_t* dst, const uint8_t* src, size_t len) {
+        gf_mul_region(dst, src, constant, len, m_irreducible_polynomial, m_characteristic);
+    });
+}
+
+void FieldVector::multiply_add(uint8_t constant, const FieldVector& src) {
+    assert((constant >> m_characteristic) == 0);
+    if (constant == 0)
+        return;
+    if (constant == 1) {
+        *this += src;
+        return;
+    }
+    transform(&src, [&](uint8_t* dst, const uint8_t* source, size_t len) {
+        gf_mul_add_region(dst, source, constant, len, m_irreducible_polynomial, m_characteristic);
+    });
+}
+
+void FieldVector::invert() {
+    transform(nullptr, [&](uint8_t* dst, const uint8_t* src, size_t len) {
+        gf_inverse_region(dst, src, len, m_irreducible_polynomial, m_characteristic);
+    });
+}
+
+FieldVector operator+(FieldVector lhs, const FieldVector& rhs) {
+    return lhs += rhs;
+}
+
+FieldVector operator-(FieldVector lhs, const FieldVector& rhs) {
+    return lhs -= rhs;
+}
+
+bool operator==(const FieldVector& a, const FieldVector& b) {
+    if (a.size() != b.size()
+        || a.irreducible_polynomial() != b.irreducible_polynomial()
+        || a.characteristic() != b.characteristic())
+        return false;
+    if (a.layout() == b.layout())
+        return std::equal(a.data(), a.data() + a.data_size(), b.data());
+    return a.elements() == b.elements();
+}
+
+bool operator!=(const FieldVector& a, const FieldVector& b) {
+    return !(a == b);
+}
+
+}
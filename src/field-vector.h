@@ -0,0 +1,256 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2016 Michael Catanzaro <michael.catanzaro@mst.edu>
+ * Copyright (c) 2016 Jacob Fischer <jtf3m8@mst.edu>
+ * Copyright (c) 2016 Christian Storer <cs9yb@mst.edu>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "polynomial.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+namespace multinv {
+
+enum class FieldVectorLayout {
+    // One element per byte. Bulk operations go straight to the region
+    // kernels.
+    Bytes,
+    // characteristic bits per element, with no padding between them: element
+    // i occupies bits i * n through i * n + n - 1, counting from the least
+    // significant bit of the first byte. Eight elements fill exactly n bytes.
+    // Bulk operations unpack a block at a time, so they cost a little more.
+    Packed,
+};
+
+// A fixed-size array of elements of GF(2^n), n<=8, which stores the field
+// once rather than once per element. A Polynomial is eight bytes, so even the
+// Bytes layout is an eighth the size of a std::vector<Polynomial>, and Packed
+// gets GF(2^3) down to three bits an element.
+//
+// A FieldVector either owns its elements or works directly on a file mapped
+// into memory; see create() and open(). Either way it behaves the same.
+class FieldVector {
+  public:
+    class Reference;
+    template<typename Vector, typename Value> class Iterator;
+    using iterator = Iterator<FieldVector, Reference>;
+    using const_iterator = Iterator<const FieldVector, uint8_t>;
+
+    // All zeros.
+    explicit FieldVector(size_t size,
+                         uint16_t irreducible_polynomial = Polynomial::aes_irreducible_polynomial,
+                         int characteristic = 8,
+                         FieldVectorLayout = FieldVectorLayout::Bytes);
+    // One element per byte of elements, stored in the given layout.
+    FieldVector(const std::vector<uint8_t>& elements,
+                uint16_t irreducible_polynomial = Polynomial::aes_irreducible_polynomial,
+                int characteristic = 8,
+                FieldVectorLayout = FieldVectorLayout::Bytes);
+    // Copies always own their elements, even if other is mapped.
+    FieldVector(const FieldVector& other);
+    FieldVector(FieldVector&& other);
+    ~FieldVector();
+
+    FieldVector& operator=(FieldVector other);
+
+    // Creates path (replacing it if it exists) at the right size for a vector
+    // of size zeros, and maps it. Returns nullptr if that fails.
+    static std::unique_ptr<FieldVector> create(const char* path, size_t size,
+                                               uint16_t irreducible_polynomial = Polynomial::aes_irreducible_polynomial,
+                                               int characteristic = 8,
+                                               FieldVectorLayout = FieldVectorLayout::Bytes);
+    // Maps a file written by create() or save(), without reading or
+    // converting anything: elements are read from, and if writable written
+    // to, the file itself. Returns nullptr if the file can't be mapped, or
+    // isn't a version of the format this build understands.
+    static std::unique_ptr<FieldVector> open(const char* path, bool writable = false);
+
+    // Writes the vector in the format open() expects. Returns false on
+    // failure.
+    bool save(const char* path) const;
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    uint16_t irreducible_polynomial() const { return m_irreducible_polynomial; }
+    int characteristic() const { return m_characteristic; }
+    FieldVectorLayout layout() const { return m_layout; }
+    // Whether the elements live in a file opened with open() or create().
+    bool mapped() const { return m_mapping != nullptr; }
+    // Whether the elements may be changed. Only false for files opened read
+    // only.
+    bool writable() const { return m_writable; }
+
+    // The elements in their stored layout, data_size() bytes. In the Packed
+    // layout, any bits past the last element are always zero.
+    uint8_t* data() { return m_data; }
+    const uint8_t* data() const { return m_data; }
+    size_t data_size() const { return storage_size(m_size, m_characteristic, m_layout); }
+
+    uint8_t at(size_t i) const {
+        assert(i < m_size);
+        return m_layout == FieldVectorLayout::Bytes ? m_data[i] : packed_at(i);
+    }
+    void set(size_t i, uint8_t value);
+    Polynomial polynomial(size_t i) const { return Polynomial(at(i), m_irreducible_polynomial, m_characteristic); }
+
+    Reference operator[](size_t i);
+    uint8_t operator[](size_t i) const { return at(i); }
+
+    iterator begin();
+    iterator end();
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    // Elements [first, first + count) one per byte, and back.
+    void get(size_t first, size_t count, uint8_t* elements) const;
+    void put(size_t first, size_t count, const uint8_t* elements);
+    std::vector<uint8_t> elements() const;
+
+    // The same elements in the other layout.
+    FieldVector with_layout(FieldVectorLayout) const;
+
+    // Element-wise, in place. Both vectors must be the same size and from
+    // the same field, though not necessarily in the same layout.
+    FieldVector& operator+=(const FieldVector&);
+    FieldVector& operator-=(const FieldVector&);
+    // this[i] *= constant
+    void multiply(uint8_t constant);
+    // this[i] += constant * src[i]
+    void multiply_add(uint8_t constant, const FieldVector& src);
+    // this[i] = multiplicative_inverse(this[i]), except that zero stays zero,
+    // as for gf_inverse_region().
+    void invert();
+
+    // Bytes needed to store size elements of GF(2^characteristic).
+    static size_t storage_size(size_t size, int characteristic, FieldVectorLayout);
+
+  private:
+    FieldVector(size_t size, uint16_t irreducible_polynomial, int characteristic, FieldVectorLayout,
+                uint8_t* mapping, size_t mapping_size, bool writable);
+
+    uint8_t packed_at(size_t i) const;
+    template<typename Function> void transform(const FieldVector* src, Function);
+
+    size_t m_size;
+    uint16_t m_irreducible_polynomial;
+    int m_characteristic;
+    FieldVectorLayout m_layout;
+    bool m_writable;
+    std::vector<uint8_t> m_storage;
+    uint8_t* m_data;
+    // The whole file, header and all, if there is one.
+    uint8_t* m_mapping;
+    size_t m_mapping_size;
+};
+
+// Stands in for an element of a non-const FieldVector, which may not have a
+// byte of its own to point to.
+class FieldVector::Reference {
+  public:
+    Reference(FieldVector& vector, size_t index)
+        : m_vector(&vector)
+        , m_index(index)
+    {
+    }
+
+    operator uint8_t() const { return m_vector->at(m_index); }
+    Reference& operator=(uint8_t value) { m_vector->set(m_index, value); return *this; }
+    Reference& operator=(const Reference& other) { return *this = static_cast<uint8_t>(other); }
+
+    // Swaps the elements, not the references, the way std::vector<bool>'s
+    // does. std::sort() and friends need it: std::swap() won't take
+    // temporaries.
+    friend void swap(Reference a, Reference b) {
+        uint8_t value = a;
+        a = static_cast<uint8_t>(b);
+        b = value;
+    }
+
+  private:
+    FieldVector* m_vector;
+    size_t m_index;
+};
+
+template<typename Vector, typename Value>
+class FieldVector::Iterator {
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = uint8_t;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = Value;
+
+    Iterator(Vector* vector, size_t index)
+        : m_vector(vector)
+        , m_index(index)
+    {
+    }
+
+    Value operator*() const { return (*m_vector)[m_index]; }
+    Value operator[](difference_type n) const { return (*m_vector)[m_index + n]; }
+
+    Iterator& operator++() { ++m_index; return *this; }
+    Iterator operator++(int) { Iterator old = *this; ++m_index; return old; }
+    Iterator& operator--() { --m_index; return *this; }
+    Iterator operator--(int) { Iterator old = *this; --m_index; return old; }
+    Iterator& operator+=(difference_type n) { m_index += n; return *this; }
+    Iterator& operator-=(difference_type n) { m_index -= n; return *this; }
+    Iterator operator+(difference_type n) const { return {m_vector, m_index + n}; }
+    Iterator operator-(difference_type n) const { return {m_vector, m_index - n}; }
+    friend Iterator operator+(difference_type n, const Iterator& it) { return it + n; }
+    difference_type operator-(const Iterator& other) const { return m_index - other.m_index; }
+
+    bool operator==(const Iterator& other) const { return m_index == other.m_index; }
+    bool operator!=(const Iterator& other) const { return m_index != other.m_index; }
+    bool operator<(const Iterator& other) const { return m_index < other.m_index; }
+    bool operator>(const Iterator& other) const { return m_index > other.m_index; }
+    bool operator<=(const Iterator& other) const { return m_index <= other.m_index; }
+    bool operator>=(const Iterator& other) const { return m_index >= other.m_index; }
+
+  private:
+    Vector* m_vector;
+    size_t m_index;
+};
+
+inline FieldVector::Reference FieldVector::operator[](size_t i) { return {*this, i}; }
+inline FieldVector::iterator FieldVector::begin() { return {this, 0}; }
+inline FieldVector::iterator FieldVector::end() { return {this, m_size}; }
+inline FieldVector::const_iterator FieldVector::begin() const { return {this, 0}; }
+inline FieldVector::const_iterator FieldVector::end() const { return {this, m_size}; }
+
+FieldVector operator+(FieldVector, const FieldVector&);
+FieldVector operator-(FieldVector, const FieldVector&);
+
+bool operator==(const FieldVector&, const FieldVector&);
+bool operator!=(const FieldVector&, const FieldVector&);
+
+}
@@ -0,0 +1,177 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2016 Michael Catanzaro <michael.catanzaro@mst.edu>
+ * Copyright (c) 2016 Jacob Fischer <jtf3m8@mst.edu>
+ * Copyright (c) 2016 Christian Storer <cs9yb@mst.edu>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "polynomial.h"
+
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+
+namespace multinv {
+
+// Log/antilog tables for a field known at compile time. Same layout as
+// FieldTables, except generator is zero if there isn't one.
+struct GFTables {
+    uint8_t generator;
+    uint8_t exp[512];
+    uint8_t log[256];
+    uint8_t inverse[256];
+};
+
+constexpr GFTables make_gf_tables(uint16_t irreducible_polynomial, int characteristic) {
+    GFTables tables{};
+    unsigned int order = (1u << characteristic) - 1;
+
+    for (unsigned int candidate = 1; candidate <= order && !tables.generator; ++candidate) {
+        uint8_t g = static_cast<uint8_t>(candidate);
+        uint8_t power = g;
+        unsigned int cycle = 1;
+        while (power != 1 && cycle <= order) {
+            power = multiply_bitwise(power, g, irreducible_polynomial, characteristic);
+            ++cycle;
+        }
+        if (power == 1 && cycle == order)
+            tables.generator = g;
+    }
+    if (!tables.generator)
+        return tables;
+
+    uint8_t power = 1;
+    for (unsigned int i = 0; i < 2 * order; ++i) {
+        tables.exp[i] = power;
+        if (i < order)
+            tables.log[power] = static_cast<uint8_t>(i);
+        power = multiply_bitwise(power, tables.generator, irreducible_polynomial, characteristic);
+    }
+
+    for (unsigned int a = 1; a <= order; ++a)
+        tables.inverse[a] = tables.exp[(order - tables.log[a]) % order];
+
+    return tables;
+}
+
+// An element of GF(2^N) with the field fixed at compile time.
+//
+// This is what the FIXME in Polynomial::operator*= was asking for: since the
+// irreducible polynomial and characteristic are template parameters, they take
+// up no space (sizeof(GF<IP, N>) == 1), the tables are computed by the compiler,
+// and trying to mix elements of different fields is a compile error rather
+// than an assertion failure. Polynomial remains the way to go when the field
+// is only known at runtime.
+template <uint16_t IP, int N = 8>
+class GF {
+  public:
+    static_assert(N > 0 && N <= 8, "Characteristic must be compatible with an eight-bit value");
+    static_assert((IP >> N) == 1, "Irreducible polynomial must have degree N");
+
+    constexpr GF() : m_value(0) { }
+
+    explicit constexpr GF(uint8_t value)
+        : m_value(value)
+    {
+        assert((value >> N) == 0);
+    }
+
+    explicit GF(const Polynomial& p)
+        : m_value(p.value())
+    {
+        assert(p.irreducible_polynomial() == IP);
+        assert(p.characteristic() == N);
+    }
+
+    // The bit representation of this polynomial.
+    constexpr uint8_t value() const { return m_value; }
+    // The irreducible polynomial that defines the field this polynomial exists in.
+    static constexpr uint16_t irreducible_polynomial() { return IP; }
+    // The n in GF(2^n).
+    static constexpr int characteristic() { return N; }
+    // The number of nonzero elements, 2^n - 1.
+    static constexpr unsigned int order() { return (1u << N) - 1; }
+
+    Polynomial polynomial() const { return Polynomial{m_value, IP, N}; }
+
+    constexpr GF& operator+=(GF rhs) {
+        m_value ^= rhs.m_value;
+        return *this;
+    }
+
+    constexpr GF& operator-=(GF rhs) {
+        return *this += rhs;
+    }
+
+    constexpr GF& operator*=(GF rhs) {
+        if (m_value == 0 || rhs.m_value == 0)
+            m_value = 0;
+        else
+            m_value = s_tables.exp[s_tables.log[m_value] + s_tables.log[rhs.m_value]];
+        return *this;
+    }
+
+    constexpr GF& operator/=(GF rhs) {
+        if (rhs.m_value == 0)
+            std::abort();
+        if (m_value != 0)
+            m_value = s_tables.exp[s_tables.log[m_value] + order() - s_tables.log[rhs.m_value]];
+        return *this;
+    }
+
+    friend constexpr GF multiplicative_inverse(GF p) {
+        if (p.m_value == 0)
+            std::abort();
+        return GF{s_tables.inverse[p.m_value]};
+    }
+
+    friend constexpr GF operator+(GF lhs, GF rhs) { return lhs += rhs; }
+    friend constexpr GF operator-(GF lhs, GF rhs) { return lhs -= rhs; }
+    friend constexpr GF operator*(GF lhs, GF rhs) { return lhs *= rhs; }
+    friend constexpr GF operator/(GF lhs, GF rhs) { return lhs /= rhs; }
+
+    friend constexpr bool operator==(GF lhs, GF rhs) { return lhs.m_value == rhs.m_value; }
+    friend constexpr bool operator!=(GF lhs, GF rhs) { return !(lhs == rhs); }
+    friend constexpr bool operator<(GF lhs, GF rhs) { return lhs.m_value < rhs.m_value; }
+    friend constexpr bool operator>(GF lhs, GF rhs) { return rhs < lhs; }
+    friend constexpr bool operator<=(GF lhs, GF rhs) { return !(lhs > rhs); }
+    friend constexpr bool operator>=(GF lhs, GF rhs) { return !(lhs < rhs); }
+
+  private:
+    uint8_t m_value;
+
+    static constexpr GFTables s_tables = make_gf_tables(IP, N);
+    static_assert(s_tables.generator != 0, "Irreducible polynomial is not irreducible");
+};
+
+template <uint16_t IP, int N>
+constexpr GFTables GF<IP, N>::s_tables;
+
+// The field used by AES.
+using GF256 = GF<Polynomial::aes_irreducible_polynomial, 8>;
+
+}
@@ -0,0 +1,368 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2016 Michael Catanzaro <michael.catanzaro@mst.edu>
+ * Copyright (c) 2016 Jacob Fischer <jtf3m8@mst.edu>
+ * Copyright (c) 2016 Christian Storer <cs9yb@mst.edu>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "instrumentation.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace multinv {
+
+const char* instrumented_operation_name(InstrumentedOperation operation) {
+    switch (operation) {
+    case InstrumentedOperation::Multiply:
+        return "multiply";
+    case InstrumentedOperation::Inverse:
+        return "inverse";
+    case InstrumentedOperation::InverseOfZero:
+        return "inverse-of-zero";
+    case InstrumentedOperation::MulRegion:
+        return "mul-region";
+    case InstrumentedOperation::MulAddRegion:
+        return "mul-add-region";
+    case InstrumentedOperation::InverseRegion:
+        return "inverse-region";
+    case InstrumentedOperation::MatrixRegion:
+        return "matrix-region";
+    case InstrumentedOperation::InverseBatch:
+        return "inverse-batch";
+    default:
+        std::abort();
+    }
+}
+
+bool instrumentation_enabled() {
+#ifdef MULTINV_INSTRUMENTATION
+    return true;
+#else
+    return false;
+#endif
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+static const char latency_unit[] = "cycles";
+#else
+static const char latency_unit[] = "ns";
+#endif
+
+#ifdef MULTINV_INSTRUMENTATION
+
+static const unsigned int sample_interval = 64;
+static const size_t slots_per_thread = 8;
+
+static uint64_t timestamp() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+// Only ever written by the thread that owns it, so a plain load and store
+// does for an increment. It's atomic only so other threads can read it.
+class Counter {
+  public:
+    void add(uint64_t n) { m_value.store(m_value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed); }
+    uint64_t get() const { return m_value.load(std::memory_order_relaxed); }
+
+  private:
+    std::atomic<uint64_t> m_value{0};
+};
+
+struct LatencyHistogram {
+    Counter buckets[latency_buckets];
+};
+
+// One field's counts, in one thread.
+struct Slot {
+    // (characteristic << 16) | irreducible_polynomial, or 0 while unused.
+    // Set once, by the owning thread.
+    std::atomic<uint32_t> key{0};
+    Counter calls[instrumented_operation_count];
+    Counter elements[instrumented_operation_count];
+    LatencyHistogram latency[instrumented_operation_count];
+};
+
+struct ThreadCounters {
+    Slot slots[slots_per_thread];
+    // Every field that didn't get a slot of its own.
+    Slot overflow;
+    // Owner only.
+    unsigned int calls_until_sample = sample_interval;
+};
+
+using Totals = std::map<uint32_t, FieldStats>;
+
+// All heap allocated and never freed, since threads (e.g. the shared
+// ThreadPool's) can still be exiting while static destructors run.
+static std::mutex& registry_mutex() {
+    static std::mutex* mutex = new std::mutex;
+    return *mutex;
+}
+
+static std::vector<ThreadCounters*>& registry() {
+    static std::vector<ThreadCounters*>* threads = new std::vector<ThreadCounters*>;
+    return *threads;
+}
+
+// Counts left behind by threads that have exited.
+static Totals& retired() {
+    static Totals* totals = new Totals;
+    return *totals;
+}
+
+// What the counts were at the last reset.
+static Totals& reset_point() {
+    static Totals* totals = new Totals;
+    return *totals;
+}
+
+static void accumulate(const Slot& slot, uint32_t key, Totals& totals) {
+    FieldStats& stats = totals[key];
+    stats.irreducible_polynomial = static_cast<uint16_t>(key);
+    stats.characteristic = static_cast<int>(key >> 16);
+    for (size_t i = 0; i < instrumented_operation_count; ++i) {
+        OperationStats& operation = stats.operations[i];
+        operation.calls += slot.calls[i].get();
+        operation.elements += slot.elements[i].get();
+        for (size_t bucket = 0; bucket < latency_buckets; ++bucket)
+            operation.latency[bucket] += slot.latency[i].buckets[bucket].get();
+    }
+}
+
+static void accumulate(const ThreadCounters& counters, Totals& totals) {
+    for (const Slot& slot : counters.slots) {
+        uint32_t key = slot.key.load(std::memory_order_acquire);
+        if (key != 0)
+            accumulate(slot, key, totals);
+    }
+    accumulate(counters.overflow, 0, totals);
+}
+
+// Registers the thread's counters on its first instrumented call, and folds
+// them into retired() when it exits.
+class ThreadRegistration {
+  public:
+    ThreadRegistration();
+    ~ThreadRegistration();
+
+    ThreadCounters& counters() { return *m_counters; }
+
+  private:
+    ThreadCounters* m_counters;
+};
+
+ThreadRegistration::ThreadRegistration()
+    : m_counters(new ThreadCounters)
+{
+    std::lock_guard<std::mutex> lock(registry_mutex());
+    registry().push_back(m_counters);
+}
+
+ThreadRegistration::~ThreadRegistration() {
+    std::lock_guard<std::mutex> lock(registry_mutex());
+    accumulate(*m_counters, retired());
+    registry().erase(std::find(registry().begin(), registry().end(), m_counters));
+    delete m_counters;
+}
+
+static Slot& slot_for(uint16_t irreducible_polynomial, int characteristic, ThreadCounters*& owner) {
+    static thread_local ThreadRegistration registration;
+    ThreadCounters& counters = registration.counters();
+    owner = &counters;
+
+    uint32_t key = (static_cast<uint32_t>(characteristic) << 16) | irreducible_polynomial;
+    for (Slot& slot : counters.slots) {
+        uint32_t slot_key = slot.key.load(std::memory_order_relaxed);
+        if (slot_key == key)
+            return slot;
+        if (slot_key == 0) {
+            slot.key.store(key, std::memory_order_release);
+            return slot;
+        }
+    }
+    return counters.overflow;
+}
+
+LatencyHistogram* instrumentation_begin(InstrumentedOperation operation, uint16_t irreducible_polynomial,
+                                        int characteristic, size_t elements, uint64_t& start) {
+    ThreadCounters* counters;
+    Slot& slot = slot_for(irreducible_polynomial, characteristic, counters);
+    size_t i = static_cast<size_t>(operation);
+    slot.calls[i].add(1);
+    slot.elements[i].add(elements);
+
+    if (--counters->calls_until_sample != 0)
+        return nullptr;
+    counters->calls_until_sample = sample_interval;
+    start = timestamp();
+    return &slot.latency[i];
+}
+
+void instrumentation_end(LatencyHistogram* latency, uint64_t start) {
+    uint64_t elapsed = timestamp() - start;
+    size_t bucket = elapsed ? static_cast<size_t>(63 - __builtin_clzll(elapsed)) : 0;
+    latency->buckets[std::min(bucket, latency_buckets - 1)].add(1);
+}
+
+void instrumentation_event(InstrumentedOperation operation, uint16_t irreducible_polynomial, int characteristic,
+                           size_t elements) {
+    ThreadCounters* counters;
+    Slot& slot = slot_for(irreducible_polynomial, characteristic, counters);
+    size_t i = static_cast<size_t>(operation);
+    slot.calls[i].add(1);
+    slot.elements[i].add(elements);
+}
+
+// Caller holds registry_mutex().
+static Totals collect() {
+    Totals totals = retired();
+    for (const ThreadCounters* counters : registry())
+        accumulate(*counters, totals);
+    return totals;
+}
+
+std::vector<FieldStats> instrumentation_stats() {
+    Totals totals;
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex());
+        totals = collect();
+        for (const auto& entry : reset_point()) {
+            FieldStats& stats = totals[entry.first];
+            for (size_t i = 0; i < instrumented_operation_count; ++i) {
+                stats.operations[i].calls -= entry.second.operations[i].calls;
+                stats.operations[i].elements -= entry.second.operations[i].elements;
+                for (size_t bucket = 0; bucket < latency_buckets; ++bucket)
+                    stats.operations[i].latency[bucket] -= entry.second.operations[i].latency[bucket];
+            }
+        }
+    }
+
+    std::vector<std::pair<uint64_t, const FieldStats*>> busiest;
+    for (const auto& entry : totals) {
+        uint64_t calls = 0;
+        for (const OperationStats& operation : entry.second.operations)
+            calls += operation.calls;
+        if (calls != 0)
+            busiest.emplace_back(calls, &entry.second);
+    }
+    std::stable_sort(busiest.begin(), busiest.end(), [](const std::pair<uint64_t, const FieldStats*>& a,
+                                                        const std::pair<uint64_t, const FieldStats*>& b) {
+        return a.first > b.first;
+    });
+
+    std::vector<FieldStats> stats;
+    for (const auto& entry : busiest)
+        stats.push_back(*entry.second);
+    return stats;
+}
+
+void reset_instrumentation_stats() {
+    std::lock_guard<std::mutex> lock(registry_mutex());
+    reset_point() = collect();
+}
+
+#else
+
+std::vector<FieldStats> instrumentation_stats() {
+    return {};
+}
+
+void reset_instrumentation_stats() {
+}
+
+#endif
+
+// The upper end of the bucket holding the given fraction of the samples.
+static uint64_t latency_percentile(const OperationStats& operation, uint64_t samples, double fraction) {
+    uint64_t wanted = static_cast<uint64_t>(fraction * static_cast<double>(samples - 1));
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < latency_buckets; ++bucket) {
+        seen += operation.latency[bucket];
+        if (seen > wanted)
+            return uint64_t{2} << bucket;
+    }
+    return uint64_t{2} << (latency_buckets - 1);
+}
+
+void print_instrumentation_stats(FILE* file) {
+    if (!instrumentation_enabled()) {
+        std::fprintf(file, "libmultinv was built without instrumentation; configure with --enable-instrumentation\n");
+        return;
+    }
+
+    std::vector<FieldStats> stats = instrumentation_stats();
+    if (stats.empty()) {
+        std::fprintf(file, "No field operations so far\n");
+        return;
+    }
+
+    for (const FieldStats& field : stats) {
+        if (field.characteristic == 0)
+            std::fprintf(file, "Other fields\n");
+        else
+            std::fprintf(file, "GF(2^%d) mod %#x\n", field.characteristic, field.irreducible_polynomial);
+        std::fprintf(file, "  %-16s %14s %16s %10s %10s  (%s, sampled)\n",
+                     "operation", "calls", "elements", "median", "p99", latency_unit);
+
+        for (size_t i = 0; i < instrumented_operation_count; ++i) {
+            const OperationStats& operation = field.operations[i];
+            if (operation.calls == 0)
+                continue;
+
+            uint64_t samples = 0;
+            for (uint64_t count : operation.latency)
+                samples += count;
+            char median[32] = "-";
+            char p99[32] = "-";
+            if (samples != 0) {
+                std::snprintf(median, sizeof(median), "<%llu",
+                              static_cast<unsigned long long>(latency_percentile(operation, samples, 0.5)));
+                std::snprintf(p99, sizeof(p99), "<%llu",
+                              static_cast<unsigned long long>(latency_percentile(operation, samples, 0.99)));
+            }
+
+            std::fprintf(file, "  %-16s %14llu %16llu %10s %10s\n",
+                         instrumented_operation_name(static_cast<InstrumentedOperation>(i)),
+                         static_cast<unsigned long long>(operation.calls),
+                         static_cast<unsigned long long>(operation.elements), median, p99);
+        }
+    }
+}
+
+}
@@ -0,0 +1,159 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2016 Michael Catanzaro <michael.catanzaro@mst.edu>
+ * Copyright (c) 2016 Jacob Fischer <jtf3m8@mst.edu>
+ * Copyright (c) 2016 Christian Storer <cs9yb@mst.edu>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace multinv {
+
+// Counts of what libmultinv spends its time on, for deciding what's worth
+// tuning. Configure with --enable-instrumentation to turn it on; otherwise the
+// MULTINV_INSTRUMENT macros expand to nothing, and the functions below exist
+// but report nothing.
+//
+// Every thread counts into its own table, with no locks and no atomic
+// read-modify-writes, so threads never contend. Tables hold a handful of
+// fields each; calls in any others are lumped together as field 0 with
+// characteristic 0. One call in 64 is timed (in TSC cycles on x86, in
+// nanoseconds elsewhere) to build up latency histograms without doubling the
+// cost of every call.
+
+enum class InstrumentedOperation {
+    // Polynomial::operator*= and operator*. Everything else that multiplies
+    // Polynomials goes through one of them, so this includes their
+    // multiplications too.
+    Multiply,
+    // multiplicative_inverse() of a Polynomial, with any strategy.
+    Inverse,
+    // Attempts to invert (or divide by) zero. Unless the strategy was
+    // ConstantTime or the zero was part of a batch, the process then aborted.
+    // Elements are the number of zeros.
+    InverseOfZero,
+    // The region functions. Elements are bytes of src, or for matrices, of
+    // all the sources put together. The parallel versions count each chunk
+    // as a call.
+    MulRegion,
+    MulAddRegion,
+    InverseRegion,
+    MatrixRegion,
+    // multiplicative_inverse_batch() of Polynomials or bytes.
+    InverseBatch,
+};
+
+constexpr size_t instrumented_operation_count = 8;
+const char* instrumented_operation_name(InstrumentedOperation);
+
+// Bucket i counts calls that took [2^i, 2^(i+1)) cycles (bucket 0 also gets
+// zero).
+constexpr size_t latency_buckets = 40;
+
+struct OperationStats {
+    uint64_t calls;
+    uint64_t elements;
+    uint64_t latency[latency_buckets];
+};
+
+struct FieldStats {
+    uint16_t irreducible_polynomial;
+    int characteristic;
+    OperationStats operations[instrumented_operation_count];
+};
+
+// Whether the library was built with instrumentation at all.
+bool instrumentation_enabled();
+
+// Totals across every thread, past and present, since the last reset, one
+// entry per field that was used, busiest first. Threads still running may be
+// partway through updating their counts, so a snapshot taken while they're
+// busy is very slightly stale, but never torn.
+std::vector<FieldStats> instrumentation_stats();
+
+// Start counting from zero again.
+void reset_instrumentation_stats();
+
+// instrumentation_stats() as a table, with median and 99th percentile
+// latencies, for humans.
+void print_instrumentation_stats(FILE*);
+
+#ifdef MULTINV_INSTRUMENTATION
+
+struct LatencyHistogram;
+
+// Counts one call and, if it's the one to sample, returns the histogram its
+// latency belongs in and sets start. Don't use these directly; use the macros.
+LatencyHistogram* instrumentation_begin(InstrumentedOperation, uint16_t irreducible_polynomial, int characteristic,
+                                        size_t elements, uint64_t& start);
+void instrumentation_end(LatencyHistogram*, uint64_t start);
+void instrumentation_event(InstrumentedOperation, uint16_t irreducible_polynomial, int characteristic,
+                           size_t elements);
+
+class InstrumentationScope {
+  public:
+    InstrumentationScope(InstrumentedOperation operation, uint16_t irreducible_polynomial, int characteristic,
+                         size_t elements)
+        : m_start(0)
+        , m_latency(instrumentation_begin(operation, irreducible_polynomial, characteristic, elements, m_start))
+    {
+    }
+
+    ~InstrumentationScope() {
+        if (m_latency)
+            instrumentation_end(m_latency, m_start);
+    }
+
+    InstrumentationScope(const InstrumentationScope&) = delete;
+    InstrumentationScope& operator=(const InstrumentationScope&) = delete;
+
+  private:
+    uint64_t m_start;
+    LatencyHistogram* m_latency;
+};
+
+// Counts, and sometimes times, the rest of the enclosing scope.
+#define MULTINV_INSTRUMENT(operation, irreducible_polynomial, characteristic, elements) \
+    ::multinv::InstrumentationScope multinv_instrumentation_scope_(                     \
+        ::multinv::InstrumentedOperation::operation, irreducible_polynomial, characteristic, elements)
+
+// Counts something that isn't worth timing.
+#define MULTINV_INSTRUMENT_EVENT(operation, irreducible_polynomial, characteristic, elements) \
+    ::multinv::instrumentation_event(                                                     \
+        ::multinv::InstrumentedOperation::operation, irreducible_polynomial, characteristic, elements)
+
+#else
+
+#define MULTINV_INSTRUMENT(operation, irreducible_polynomial, characteristic, elements) ((void)0)
+#define MULTINV_INSTRUMENT_EVENT(operation, irreducible_polynomial, characteristic, elements) ((void)0)
+
+#endif
+
+}
@@ -0,0 +1,575 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2016 Michael Catanzaro <michael.catanzaro@mst.edu>
+ * Copyright (c) 2016 Jacob Fischer <jtf3m8@mst.edu>
+ * Copyright (c) 2016 Christian Storer <cs9yb@mst.edu>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "irreducible.h"
+
+#include "thread-pool.h"
+#include "wide-polynomial.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <utility>
+
+namespace multinv {
+
+static bool valid(uint64_t polynomial, int degree) {
+    if (degree < 1 || degree > 64)
+        return false;
+    return degree == 64 || (polynomial >> degree) == 0;
+}
+
+static uint64_t low_mask(int degree) {
+    return degree == 64 ? ~uint64_t{0} : (uint64_t{1} << degree) - 1;
+}
+
+// Same as compute_barrett_constant() in wide-polynomial.cc, for any degree.
+static uint64_t compute_barrett_constant(uint64_t polynomial, int degree) {
+    const uint64_t top_bit = uint64_t{1} << (degree - 1);
+    const uint64_t mask = low_mask(degree);
+    uint64_t remainder = polynomial;
+    uint64_t quotient = 0;
+    for (int i = degree - 1; i >= 0; --i) {
+        bool bit = remainder & top_bit;
+        remainder = (remainder << 1) & mask;
+        if (bit) {
+            quotient |= uint64_t{1} << i;
+            remainder ^= polynomial;
+        }
+    }
+    return quotient;
+}
+
+// Arithmetic modulo x^degree + polynomial, on elements of lower degree. This
+// is WidePolynomial's Barrett reduction, except the degree needn't match the
+// word size: the product is split at bit degree rather than bit 64.
+class Modulus {
+  public:
+    Modulus(uint64_t polynomial, int degree, uint64_t barrett_constant)
+        : m_polynomial(polynomial)
+        , m_degree(degree)
+        , m_mask(low_mask(degree))
+        , m_barrett_constant(barrett_constant)
+    {
+    }
+
+    Modulus(uint64_t polynomial, int degree)
+        : Modulus(polynomial, degree, compute_barrett_constant(polynomial, degree))
+    {
+    }
+
+    uint64_t multiply(uint64_t a, uint64_t b) const {
+        uint128_t product = carryless_multiply(a, b);
+        uint64_t low = static_cast<uint64_t>(product) & m_mask;
+        uint64_t high = static_cast<uint64_t>(product >> m_degree);
+        uint64_t quotient = high ^ static_cast<uint64_t>(carryless_multiply(high, m_barrett_constant) >> m_degree);
+        return low ^ (static_cast<uint64_t>(carryless_multiply(quotient, m_polynomial)) & m_mask);
+    }
+
+    uint64_t power(uint64_t a, uint64_t exponent) const {
+        uint64_t result = 1;
+        for (; exponent != 0; exponent >>= 1) {
+            if (exponent & 1)
+                result = multiply(result, a);
+            a = multiply(a, a);
+        }
+        return result;
+    }
+
+    // The element x, which for degree 1 has already wrapped around.
+    uint64_t x() const { return m_degree == 1 ? m_polynomial : 2; }
+
+  private:
+    uint64_t m_polynomial;
+    int m_degree;
+    uint64_t m_mask;
+    uint64_t m_barrett_constant;
+};
+
+static int degree_of(uint128_t a) {
+    uint64_t high = static_cast<uint64_t>(a >> 64);
+    uint64_t low = static_cast<uint64_t>(a);
+    if (high != 0)
+        return 127 - __builtin_clzll(high);
+    if (low != 0)
+        return 63 - __builtin_clzll(low);
+    return -1;
+}
+
+// Euclid's algorithm in GF(2)[x]. 128 bits so that a can hold a full
+// degree-64 polynomial, leading term and all.
+static uint128_t gcd(uint128_t a, uint128_t b) {
+    while (b != 0) {
+        int b_degree = degree_of(b);
+        for (int a_degree = degree_of(a); a_degree >= b_degree; a_degree = degree_of(a))
+            a ^= b << (a_degree - b_degree);
+        std::swap(a, b);
+    }
+    return a;
+}
+
+static bool ben_or(uint64_t polynomial, int degree) {
+    Modulus modulus{polynomial, degree};
+    const uint128_t f = (uint128_t{1} << degree) | polynomial;
+    const uint64_t x = modulus.x();
+
+    // gcds are slow next to multiplications, so rather than taking one per
+    // step we multiply the x^(2^i) - x together and take the gcd of the
+    // product whenever i reaches a power of two. Small factors are the
+    // common ones, so that still finds most of them early. A factor of
+    // degree 1 would show up at i = 1, but is_irreducible() has already
+    // ruled those out, so we start at i = 2.
+    uint64_t power = modulus.multiply(x, x);
+    uint64_t product = 1;
+    for (int i = 2; i <= degree / 2; ++i) {
+        power = modulus.multiply(power, power);
+        product = modulus.multiply(product, power ^ x);
+        if (((i & (i - 1)) == 0 || i == degree / 2) && gcd(f, product) != 1)
+            return false;
+    }
+    return true;
+}
+
+static bool rabin(uint64_t polynomial, int degree) {
+    Modulus modulus{polynomial, degree};
+    const uint128_t f = (uint128_t{1} << degree) | polynomial;
+    const uint64_t x = modulus.x();
+    const std::vector<PrimePower> primes = factor(static_cast<uint64_t>(degree));
+
+    uint64_t power = x;
+    for (int i = 1; i <= degree; ++i) {
+        power = modulus.multiply(power, power);
+        for (const PrimePower& p : primes) {
+            if (static_cast<uint64_t>(i) == degree / p.prime && gcd(f, power ^ x) != 1)
+                return false;
+        }
+    }
+    return power == x;
+}
+
+bool is_irreducible(uint64_t polynomial, int degree, IrreducibilityTest test) {
+    if (!valid(polynomial, degree))
+        return false;
+    if (degree == 1)
+        return true;
+
+    // Cheap checks first. Without a constant term, x is a factor. With an
+    // even number of terms, 1 is a root, so x + 1 is a factor. That's three
+    // quarters of all candidates gone.
+    if (!(polynomial & 1) || __builtin_popcountll(polynomial) % 2 == 1)
+        return false;
+
+    switch (test) {
+    case IrreducibilityTest::BenOr:
+        return ben_or(polynomial, degree);
+    case IrreducibilityTest::Rabin:
+        return rabin(polynomial, degree);
+    default:
+        std::abort();
+    }
+}
+
+// The prime factors of 2^degree - 1, which every primitivity test and every
+// order computation needs. Factoring isn't free, so each is done once.
+static const std::vector<PrimePower>& group_order_factors(int degree) {
+    static std::mutex mutex;
+    static std::vector<PrimePower> factors[65];
+    static bool done[65];
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!done[degree]) {
+        factors[degree] = factor(low_mask(degree));
+        done[degree] = true;
+    }
+    return factors[degree];
+}
+
+// a generates the group iff a^(order/p) != 1 for every prime p dividing the
+// order; otherwise its order is a proper divisor, and so divides one of those.
+static bool generates(const Modulus& modulus, uint64_t a, uint64_t order,
+                      const std::vector<PrimePower>& order_factors) {
+    if (a == 0)
+        return false;
+    for (const PrimePower& p : order_factors) {
+        if (modulus.power(a, order / p.prime) == 1)
+            return false;
+    }
+    return true;
+}
+
+bool is_primitive(uint64_t polynomial, int degree) {
+    if (!is_irreducible(polynomial, degree))
+        return false;
+    Modulus modulus{polynomial, degree};
+    return generates(modulus, modulus.x(), low_mask(degree), group_order_factors(degree));
+}
+
+// Every candidate of the given degree in increasing order, keeping the ones
+// that pass. Candidates without a constant term are divisible by x, so we
+// only try odd ones (except in degree 1, where x itself is irreducible).
+template <typename Test>
+static std::vector<uint64_t> search(int degree, size_t max_count, ThreadPool* pool, const Test& test) {
+    std::vector<uint64_t> found;
+    if (degree < 1 || degree > 64 || max_count == 0)
+        return found;
+
+    if (degree == 1) {
+        for (uint64_t candidate = 0; candidate <= 1 && found.size() < max_count; ++candidate) {
+            if (test(candidate))
+                found.push_back(candidate);
+        }
+        return found;
+    }
+
+    const uint64_t candidates = uint64_t{1} << (degree - 1);
+
+    if (!pool) {
+        for (uint64_t i = 0; i < candidates && found.size() < max_count; ++i) {
+            if (test(2 * i + 1))
+                found.push_back(2 * i + 1);
+        }
+        return found;
+    }
+
+    // Test a batch of chunks at a time, every chunk in parallel, then keep
+    // the results in order until we have enough. A chunk can stop early once
+    // it alone has found enough, since nothing after it will be needed.
+    const uint64_t chunk = 1024;
+    const size_t chunks_per_round = pool->size() * 4;
+    for (uint64_t start = 0; start < candidates && found.size() < max_count;) {
+        const uint64_t round = std::min<uint64_t>(candidates - start, chunk * chunks_per_round);
+        const size_t chunks = static_cast<size_t>((round + chunk - 1) / chunk);
+        const size_t wanted = max_count - found.size();
+        std::vector<std::vector<uint64_t>> results(chunks);
+
+        pool->parallel_for(chunks, 1, [&](size_t begin, size_t end) {
+            for (size_t c = begin; c < end; ++c) {
+                uint64_t first = start + c * chunk;
+                uint64_t last = std::min(first + chunk, start + round);
+                for (uint64_t i = first; i < last && results[c].size() < wanted; ++i) {
+                    if (test(2 * i + 1))
+                        results[c].push_back(2 * i + 1);
+                }
+            }
+        });
+
+        for (const std::vector<uint64_t>& result : results) {
+            for (uint64_t polynomial : result) {
+                if (found.size() < max_count)
+                    found.push_back(polynomial);
+            }
+        }
+        start += round;
+    }
+    return found;
+}
+
+std::vector<uint64_t> enumerate_irreducible_polynomials(int degree, size_t max_count, ThreadPool* pool) {
+    return search(degree, max_count, pool, [degree](uint64_t polynomial) {
+        return is_irreducible(polynomial, degree);
+    });
+}
+
+std::vector<uint64_t> enumerate_primitive_polynomials(int degree, size_t max_count, ThreadPool* pool) {
+    if (degree < 1 || degree > 64)
+        return {};
+
+    const std::vector<PrimePower>& order_factors = group_order_factors(degree);
+    return search(degree, max_count, pool, [degree, &order_factors](uint64_t polynomial) {
+        if (!is_irreducible(polynomial, degree))
+            return false;
+        Modulus modulus{polynomial, degree};
+        return generates(modulus, modulus.x(), low_mask(degree), order_factors);
+    });
+}
+
+// Candidates with three terms, then five, then seven... in increasing order
+// within each weight. Even weights are skipped since they're divisible by
+// x + 1.
+template <typename Test>
+static uint64_t find_sparsest(int degree, const Test& test) {
+    if (degree < 1 || degree > 64)
+        std::abort();
+
+    if (degree == 1)
+        return test(0) ? 0 : 1;
+
+    const uint64_t limit = uint64_t{1} << (degree - 1);
+    for (int middle_terms = 1; middle_terms < degree; middle_terms += 2) {
+        // Gosper's hack: the next larger word with the same number of bits
+        // set. The bits are the exponents 1 to degree-1 of the middle terms.
+        uint64_t exponents = (uint64_t{1} << middle_terms) - 1;
+        while (exponents < limit) {
+            uint64_t polynomial = (exponents << 1) | 1;
+            if (test(polynomial))
+                return polynomial;
+
+            uint64_t lowest = exponents & (~exponents + 1);
+            uint64_t ripple = exponents + lowest;
+            exponents = (((ripple ^ exponents) >> 2) / lowest) | ripple;
+        }
+    }
+
+    // Every degree has irreducible and primitive polynomials.
+    std::abort();
+}
+
+uint64_t find_irreducible_polynomial(int degree) {
+    return find_sparsest(degree, [degree](uint64_t polynomial) {
+        return is_irreducible(polynomial, degree);
+    });
+}
+
+uint64_t find_primitive_polynomial(int degree) {
+    return find_sparsest(degree, [degree](uint64_t polynomial) {
+        return is_primitive(polynomial, degree);
+    });
+}
+
+const FieldDescriptor* FieldDescriptor::get(uint64_t polynomial, int characteristic) {
+    if (!valid(polynomial, characteristic))
+        return nullptr;
+
+    // Unlike FieldTables, there are far too many possible fields for a slot
+    // apiece, so this takes a lock every time. Look the descriptor up once
+    // and hang on to it.
+    static std::mutex mutex;
+    static std::map<std::pair<int, uint64_t>, const FieldDescriptor*> cache;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto key = std::make_pair(characteristic, polynomial);
+    auto it = cache.find(key);
+    if (it != cache.end())
+        return it->second;
+
+    const FieldDescriptor* descriptor = nullptr;
+    if (is_irreducible(polynomial, characteristic))
+        descriptor = new FieldDescriptor(polynomial, characteristic);
+    cache.emplace(key, descriptor);
+    return descriptor;
+}
+
+FieldDescriptor::FieldDescriptor(uint64_t polynomial, int characteristic)
+    : m_irreducible_polynomial(polynomial)
+    , m_characteristic(characteristic)
+    , m_order(low_mask(characteristic))
+    , m_barrett_constant(compute_barrett_constant(polynomial, characteristic))
+    , m_order_factors(group_order_factors(characteristic))
+    , m_primitive(false)
+    , m_generator(0)
+{
+    Modulus modulus{m_irreducible_polynomial, m_characteristic, m_barrett_constant};
+    m_primitive = generates(modulus, modulus.x(), m_order, m_order_factors);
+
+    // phi(2^n - 1) of the 2^n - 1 nonzero elements are generators, which is
+    // never a small fraction, so this doesn't take long.
+    m_generator = 1;
+    while (!generates(modulus, m_generator, m_order, m_order_factors))
+        ++m_generator;
+}
+
+uint64_t FieldDescriptor::multiply(uint64_t a, uint64_t b) const {
+    return Modulus{m_irreducible_polynomial, m_characteristic, m_barrett_constant}.multiply(a, b);
+}
+
+uint64_t FieldDescriptor::power(uint64_t a, uint64_t exponent) const {
+    return Modulus{m_irreducible_polynomial, m_characteristic, m_barrett_constant}.power(a, exponent);
+}
+
+bool FieldDescriptor::is_generator(uint64_t a) const {
+    Modulus modulus{m_irreducible_polynomial, m_characteristic, m_barrett_constant};
+    return generates(modulus, a, m_order, m_order_factors);
+}
+
+uint64_t FieldDescriptor::element_order(uint64_t a) const {
+    if (a == 0)
+        std::abort();
+
+    // Start from the group order and divide out each prime for as long as
+    // a^(order/p) is still 1.
+    Modulus modulus{m_irreducible_polynomial, m_characteristic, m_barrett_constant};
+    uint64_t order = m_order;
+    for (const PrimePower& p : m_order_factors) {
+        for (unsigned int i = 0; i < p.exponent; ++i) {
+            if (modulus.power(a, order / p.prime) != 1)
+                break;
+            order /= p.prime;
+        }
+    }
+    return order;
+}
+
+// Baby-step giant-step in a subgroup of prime order p, generated by gamma.
+// With s baby steps tabulated, gamma^j for j < s, any h in the subgroup is
+// gamma^(i * s + j) for some i <= p / s, so multiplying h by gamma^-s until
+// it lands in the table finds it. The table is open addressing on the
+// elements themselves, none of which is zero.
+class BabySteps {
+  public:
+    BabySteps(const Modulus& modulus, uint64_t gamma, uint64_t prime)
+        : m_prime(prime)
+    {
+        m_steps = std::min<uint64_t>(static_cast<uint64_t>(std::ceil(std::sqrt(static_cast<double>(prime)))),
+                                     max_baby_steps);
+        int bits = 1;
+        while ((uint64_t{1} << bits) < 2 * m_steps)
+            ++bits;
+        m_shift = 64 - bits;
+        m_elements.assign(size_t{1} << bits, 0);
+        m_exponents.assign(size_t{1} << bits, 0);
+
+        uint64_t element = 1;
+        for (uint64_t j = 0; j < m_steps; ++j) {
+            size_t slot = find_slot(element);
+            m_elements[slot] = element;
+            m_exponents[slot] = static_cast<uint32_t>(j);
+            element = modulus.multiply(element, gamma);
+        }
+        m_giant_step = modulus.power(gamma, prime - m_steps);
+    }
+
+    // log_gamma(h). Crashes if h isn't in the subgroup.
+    uint64_t log(const Modulus& modulus, uint64_t h) const {
+        for (uint64_t i = 0; i <= m_prime / m_steps; ++i) {
+            size_t slot = find_slot(h);
+            if (m_elements[slot] == h)
+                return i * m_steps + m_exponents[slot];
+            h = modulus.multiply(h, m_giant_step);
+        }
+        std::abort();
+    }
+
+  private:
+    static constexpr uint64_t max_baby_steps = uint64_t{1} << 20;
+
+    // Where element is, or the empty slot where it would be.
+    size_t find_slot(uint64_t element) const {
+        size_t mask = m_elements.size() - 1;
+        size_t slot = static_cast<size_t>((element * 0x9e3779b97f4a7c15ull) >> m_shift);
+        while (m_elements[slot] != element && m_elements[slot] != 0)
+            slot = (slot + 1) & mask;
+        return slot;
+    }
+
+    uint64_t m_prime;
+    uint64_t m_steps;
+    uint64_t m_giant_step;
+    int m_shift;
+    std::vector<uint64_t> m_elements;
+    std::vector<uint32_t> m_exponents;
+};
+
+// std::min() takes it by reference, so it needs a definition.
+constexpr uint64_t BabySteps::max_baby_steps;
+
+// For each p^e in order_factors(), the inverse of the generator raised to
+// order() / p^e, which generates the subgroup of order p^e, and the baby
+// steps for the subgroup of order p.
+struct FieldDescriptor::DiscreteLogTables {
+    struct Subgroup {
+        uint64_t inverse;
+        BabySteps baby_steps;
+    };
+    std::vector<Subgroup> subgroups;
+};
+
+static uint64_t value_of(const PrimePower& p) {
+    uint64_t value = 1;
+    for (unsigned int i = 0; i < p.exponent; ++i)
+        value *= p.prime;
+    return value;
+}
+
+FieldDescriptor::~FieldDescriptor() = default;
+
+const FieldDescriptor::DiscreteLogTables& FieldDescriptor::discrete_log_tables() const {
+    std::call_once(m_discrete_log_tables_built, [this] {
+        Modulus modulus{m_irreducible_polynomial, m_characteristic, m_barrett_constant};
+        std::unique_ptr<DiscreteLogTables> tables{new DiscreteLogTables};
+        for (const PrimePower& p : m_order_factors) {
+            uint64_t prime_power = value_of(p);
+            uint64_t generator = modulus.power(m_generator, m_order / prime_power);
+            uint64_t gamma = modulus.power(generator, prime_power / p.prime);
+            tables->subgroups.push_back({ modulus.power(generator, prime_power - 1),
+                                          BabySteps(modulus, gamma, p.prime) });
+        }
+        m_discrete_log_tables = std::move(tables);
+    });
+    return *m_discrete_log_tables;
+}
+
+uint64_t FieldDescriptor::discrete_log(uint64_t a) const {
+    if (a == 0)
+        std::abort();
+
+    Modulus modulus{m_irreducible_polynomial, m_characteristic, m_barrett_constant};
+    const DiscreteLogTables& tables = discrete_log_tables();
+
+    // The logarithm so far, modulo the product of the prime powers so far.
+    uint64_t log = 0;
+    uint64_t modulo = 1;
+    for (size_t i = 0; i < m_order_factors.size(); ++i) {
+        const PrimePower& p = m_order_factors[i];
+        const DiscreteLogTables::Subgroup& subgroup = tables.subgroups[i];
+
+        // a^(order / p^e) is generator^x in the subgroup, for x = log mod
+        // p^e. Dividing out the digits of x found so far and raising what's
+        // left to p^(e - 1 - k) leaves gamma^(digit k).
+        uint64_t prime_power = value_of(p);
+        uint64_t h = modulus.power(a, m_order / prime_power);
+        uint64_t x = 0;
+        uint64_t place = 1;
+        for (unsigned int k = 0; k < p.exponent; ++k) {
+            uint64_t remaining = modulus.multiply(h, modulus.power(subgroup.inverse, x));
+            for (unsigned int j = k + 1; j < p.exponent; ++j)
+                remaining = modulus.power(remaining, p.prime);
+            x += subgroup.baby_steps.log(modulus, remaining) * place;
+            place *= p.prime;
+        }
+
+        // log + modulo * t == x (mod p^e).
+        uint64_t t;
+        if (!solve_linear_congruence(modulo % prime_power, (x + prime_power - log % prime_power) % prime_power,
+                                     prime_power, t))
+            std::abort();
+        log += modulo * t;
+        modulo *= prime_power;
+    }
+    return log;
+}
+
+bool FieldDescriptor::discrete_log(uint64_t a, uint64_t base, uint64_t& log) const {
+    if (a == 0 || base == 0)
+        std::abort();
+    return solve_linear_congruence(discrete_log(base), discrete_log(a), m_order, log);
+}
+
+}
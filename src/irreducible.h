@@ -0,0 +1,160 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2016 Michael Catanzaro <michael.catanzaro@mst.edu>
+ * Copyright (c) 2016 Jacob Fischer <jtf3m8@mst.edu>
+ * Copyright (c) 2016 Christian Storer <cs9yb@mst.edu>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "factor.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace multinv {
+
+class ThreadPool;
+
+// Finding and checking the polynomials that define fields.
+//
+// Everything here deals with polynomials over GF(2) of degree 1 to 64, written
+// the way WidePolynomial writes its irreducible polynomials: the coefficients
+// of x^0 through x^(degree-1) as bits of a word, with the leading x^degree
+// term left implicit. So x^8 + x^4 + x^3 + x + 1 is (0x1b, 8), and to check
+// one of Polynomial's 9-bit irreducible polynomials, drop its top bit.
+
+enum class IrreducibilityTest {
+    // f is irreducible iff gcd(f, x^(2^i) - x) = 1 for every i <= n/2. Stops
+    // soon after finding the smallest factor, and random polynomials tend to
+    // have small factors, so this is the one to use for searching.
+    BenOr,
+    // f is irreducible iff x^(2^n) = x mod f and gcd(f, x^(2^(n/p)) - x) = 1
+    // for every prime p dividing n. Always squares all the way up to
+    // x^(2^n), but takes only a couple of gcds.
+    Rabin,
+};
+
+// References: Ben-Or, "Probabilistic algorithms in finite fields" (1981);
+// Rabin, "Probabilistic algorithms in finite fields" (1980); Gao and
+// Panario, "Tests and constructions of irreducible polynomials over finite
+// fields" (1997).
+bool is_irreducible(uint64_t polynomial, int degree, IrreducibilityTest = IrreducibilityTest::BenOr);
+
+// Irreducible, and x generates the multiplicative group of the field, so
+// every nonzero element is a power of x.
+bool is_primitive(uint64_t polynomial, int degree);
+
+// All the irreducible (or primitive) polynomials of a degree, in increasing
+// order, stopping after max_count of them. There are roughly 2^n / n of each,
+// so for large degrees you want a small max_count. Given a pool, candidates
+// are tested in parallel, a thousand or so per thread at a time; the result is
+// exactly the same either way.
+std::vector<uint64_t> enumerate_irreducible_polynomials(int degree, size_t max_count, ThreadPool* = nullptr);
+std::vector<uint64_t> enumerate_primitive_polynomials(int degree, size_t max_count, ThreadPool* = nullptr);
+
+// The irreducible (or primitive) polynomial with the fewest terms, and of
+// those the smallest: a trinomial if there is one, otherwise usually a
+// pentanomial. Sparse polynomials make reduction cheap, which is why
+// standards pick them: for degree 8 this finds AES's polynomial, and for 32
+// and 64 WideField's defaults.
+uint64_t find_irreducible_polynomial(int degree);
+uint64_t find_primitive_polynomial(int degree);
+
+// Everything worth knowing about one field GF(2^n), n <= 64, worked out once.
+//
+// Polynomial and WidePolynomial take it on faith that the polynomial you hand
+// them is irreducible, and if it isn't, you find out when
+// multiplicative_inverse() crashes. Looking the field up here first tells you
+// up front. Like FieldTables, descriptors are built on first use, shared by
+// everybody using the same field, and never freed.
+class FieldDescriptor {
+  public:
+    // Returns the descriptor for the field defined by x^characteristic +
+    // polynomial, or nullptr if that isn't irreducible.
+    static const FieldDescriptor* get(uint64_t polynomial, int characteristic);
+
+    // Without its leading term, as above.
+    uint64_t irreducible_polynomial() const { return m_irreducible_polynomial; }
+    int characteristic() const { return m_characteristic; }
+    // The number of nonzero elements, 2^n - 1.
+    uint64_t order() const { return m_order; }
+    // The prime factorization of order().
+    const std::vector<PrimePower>& order_factors() const { return m_order_factors; }
+    // Whether x is a generator, i.e. whether the polynomial is primitive.
+    bool primitive() const { return m_primitive; }
+    // The smallest element that generates the multiplicative group.
+    uint64_t generator() const { return m_generator; }
+
+    uint64_t multiply(uint64_t a, uint64_t b) const;
+    uint64_t power(uint64_t a, uint64_t exponent) const;
+
+    // The smallest k > 0 with a^k = 1. Always divides order(). a must be
+    // nonzero.
+    uint64_t element_order(uint64_t a) const;
+    bool is_generator(uint64_t a) const;
+
+    // log_generator()(a): the k < order() with generator()^k = a. a must be
+    // nonzero.
+    //
+    // Pohlig-Hellman: the logarithm modulo each prime power p^e dividing
+    // order() is found one base-p digit at a time, each digit by baby-step
+    // giant-step in the subgroup of order p, and the Chinese remainder
+    // theorem puts them together. The baby steps are tabulated on first use
+    // and kept, so after that a logarithm costs a few times sqrt(p)
+    // multiplications for the largest p. Past a million baby steps (24 MB of
+    // table), the giant steps take up the slack instead. So it depends
+    // on how 2^n - 1 factors: GF(2^64) takes tens of microseconds, GF(2^49),
+    // with a 43-bit prime factor, a fifth of a second, and GF(2^61), whose
+    // order is prime, more than a day.
+    uint64_t discrete_log(uint64_t a) const;
+    // log_base(a): the smallest k >= 0 with base^k = a. Returns false if
+    // there isn't one, which is when a isn't in the subgroup generated by
+    // base. a and base must be nonzero.
+    bool discrete_log(uint64_t a, uint64_t base, uint64_t& log) const;
+
+  private:
+    FieldDescriptor(uint64_t polynomial, int characteristic);
+    ~FieldDescriptor();
+
+    struct DiscreteLogTables;
+    const DiscreteLogTables& discrete_log_tables() const;
+
+    uint64_t m_irreducible_polynomial;
+    int m_characteristic;
+    uint64_t m_order;
+    uint64_t m_barrett_constant;
+    std::vector<PrimePower> m_order_factors;
+    bool m_primitive;
+    uint64_t m_generator;
+
+    mutable std::once_flag m_discrete_log_tables_built;
+    mutable std::unique_ptr<DiscreteLogTables> m_discrete_log_tables;
+};
+
+}
@@ -28,8 +28,16 @@
  */
 
 #include "polynomial.h"
+#include "instrumentation.h"
+#include "stream.h"
+#include <cerrno>
 #include <cstdint>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <getopt.h>
+#include <unistd.h>
 
 using namespace multinv;
 
@@ -37,15 +45,15 @@ using namespace multinv;
  * defines GF(2^n) and any f(x) in GF(2^n), returns the multiplicative inverse
  * of f(x).
  *
- * To make life simple, we're not yet going to bother with silly things like
- * "user input." Put your input here and recompile the file.
+ * Run without options, this prints the answers to the homework problems
+ * below. Given --operation, it turns into a filter that applies the operation
+ * to every element of its input instead.
  *
  * Reference: https://en.wikipedia.org/wiki/Finite_field_arithmetic
  */
-int main() {
-    // TODO: Implement division?
-    // * Cannot do problem 1 without it
-    // * Required for complete answers to problem 2 and problem 4
+static void homework() {
+    // TODO: Homework 3 problem 1. Division was what it was waiting for, but
+    // the problem itself never made it into this file.
 
     // Homework 3 problem 2
     // Default characteristic and IP are large enough to avoid mod operations.
@@ -56,6 +64,7 @@ int main() {
         std::printf("%x + %x = %x\n", p1.value(), p2.value(), (p1 + p2).value());
         std::printf("%x - %x = %x\n", p1.value(), p2.value(), (p1 - p2).value());
         std::printf("%x * %x = %x\n", p1.value(), p2.value(), (p1 * p2).value());
+        std::printf("%x / %x = %x\n", p1.value(), p2.value(), (p1 / p2).value());
         std::printf("\n");
     }
 
@@ -85,10 +94,12 @@ int main() {
         std::printf("%x + %x = %x\n", p1.value(), p2.value(), (p1 + p2).value());
         std::printf("%x - %x = %x\n", p1.value(), p2.value(), (p1 - p2).value());
         std::printf("%x * %x = %x\n", p1.value(), p2.value(), (p1 * p2).value());
+        std::printf("%x / %x = %x\n", p1.value(), p2.value(), (p1 / p2).value());
         std::printf("With irreducible polynomial 1101:\n");
         std::printf("%x + %x = %x\n", p3.value(), p4.value(), (p3 + p4).value());
         std::printf("%x - %x = %x\n", p3.value(), p4.value(), (p3 - p4).value());
         std::printf("%x * %x = %x\n", p3.value(), p4.value(), (p3 * p4).value());
+        std::printf("%x / %x = %x\n", p3.value(), p4.value(), (p3 / p4).value());
         std::printf("\n");
     }
 
@@ -102,3 +113,214 @@ int main() {
         std::printf("\n");
     }
 }
+
+static void usage(FILE* stream) {
+    std::fprintf(stream,
+                 "Usage: multinv [OPTION]...\n"
+                 "Apply a finite field operation to every element of the input.\n"
+                 "With no options, print the answers to the homework problems.\n"
+                 "\n"
+                 "  -o, --operation=OP        inv, mul, add, div or pow\n"
+                 "  -c, --operand=VALUE       the other operand of mul, add and div, or the\n"
+                 "                            exponent for pow\n"
+                 "  -p, --ip=POLYNOMIAL       irreducible polynomial (default 0b100011011)\n"
+                 "  -n, --characteristic=N    degree of the irreducible polynomial (default 8)\n"
+                 "  -f, --format=FORMAT       binary (one element per byte, the default) or hex\n"
+                 "                            (whitespace-separated hexadecimal numbers)\n"
+                 "  -i, --input=FILE          read from FILE rather than standard input\n"
+                 "  -O, --output=FILE         write to FILE rather than standard output\n"
+                 "  -j, --threads=N           process each chunk with N threads\n"
+                 "  -s, --stats               afterwards, print counts of the field operations\n"
+                 "                            performed to standard error (needs a library built\n"
+                 "                            with --enable-instrumentation)\n"
+                 "  -h, --help                display this help and exit\n"
+                 "\n"
+                 "Numbers may be given in decimal, or with a 0x or 0b prefix.\n");
+}
+
+// Like strtoul(..., 0), plus 0b for binary since that's how polynomials are
+// usually written.
+static bool parse_number(const char* text, unsigned long& value) {
+    int base = 0;
+    if (text[0] == '0' && (text[1] == 'b' || text[1] == 'B')) {
+        text += 2;
+        base = 2;
+    }
+    if (*text == '\0' || *text == '-')
+        return false;
+
+    char* end;
+    errno = 0;
+    value = std::strtoul(text, &end, base);
+    return errno == 0 && *end == '\0';
+}
+
+static bool parse_operation(const char* text, StreamOperation& operation) {
+    static const struct {
+        const char* name;
+        StreamOperation operation;
+    } operations[] = {
+        { "inv", StreamOperation::Inverse },
+        { "mul", StreamOperation::Multiply },
+        { "add", StreamOperation::Add },
+        { "div", StreamOperation::Divide },
+        { "pow", StreamOperation::Power },
+    };
+    for (const auto& entry : operations) {
+        if (std::strcmp(text, entry.name) == 0) {
+            operation = entry.operation;
+            return true;
+        }
+    }
+    return false;
+}
+
+int main(int argc, char** argv) {
+    static const struct option long_options[] = {
+        { "operation", required_argument, nullptr, 'o' },
+        { "operand", required_argument, nullptr, 'c' },
+        { "ip", required_argument, nullptr, 'p' },
+        { "characteristic", required_argument, nullptr, 'n' },
+        { "format", required_argument, nullptr, 'f' },
+        { "input", required_argument, nullptr, 'i' },
+        { "output", required_argument, nullptr, 'O' },
+        { "threads", required_argument, nullptr, 'j' },
+        { "stats", no_argument, nullptr, 's' },
+        { "help", no_argument, nullptr, 'h' },
+        { nullptr, 0, nullptr, 0 },
+    };
+
+    StreamOptions options;
+    bool have_operation = false;
+    bool have_operand = false;
+    const char* input_path = nullptr;
+    const char* output_path = nullptr;
+    bool stats = false;
+    // Whether anything but --stats was given, which means streaming was
+    // wanted rather than the homework answers.
+    bool have_stream_options = false;
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "o:c:p:n:f:i:O:j:sh", long_options, nullptr)) != -1) {
+        unsigned long number;
+        if (opt != 's')
+            have_stream_options = true;
+        switch (opt) {
+        case 'o':
+            if (!parse_operation(optarg, options.operation)) {
+                std::fprintf(stderr, "multinv: unknown operation '%s'\n", optarg);
+                return EXIT_FAILURE;
+            }
+            have_operation = true;
+            break;
+        case 'c':
+            if (!parse_number(optarg, options.operand)) {
+                std::fprintf(stderr, "multinv: invalid operand '%s'\n", optarg);
+                return EXIT_FAILURE;
+            }
+            have_operand = true;
+            break;
+        case 'p':
+            if (!parse_number(optarg, number) || number > 0x1ff) {
+                std::fprintf(stderr, "multinv: invalid irreducible polynomial '%s'\n", optarg);
+                return EXIT_FAILURE;
+            }
+            options.irreducible_polynomial = static_cast<uint16_t>(number);
+            break;
+        case 'n':
+            if (!parse_number(optarg, number) || number < 1 || number > 8) {
+                std::fprintf(stderr, "multinv: characteristic must be between 1 and 8\n");
+                return EXIT_FAILURE;
+            }
+            options.characteristic = static_cast<int>(number);
+            break;
+        case 'f':
+            if (std::strcmp(optarg, "binary") == 0)
+                options.format = StreamFormat::Binary;
+            else if (std::strcmp(optarg, "hex") == 0)
+                options.format = StreamFormat::Hex;
+            else {
+                std::fprintf(stderr, "multinv: unknown format '%s'\n", optarg);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'i':
+            input_path = optarg;
+            break;
+        case 'O':
+            output_path = optarg;
+            break;
+        case 'j':
+            if (!parse_number(optarg, number) || number < 1 || number > 1024) {
+                std::fprintf(stderr, "multinv: invalid thread count '%s'\n", optarg);
+                return EXIT_FAILURE;
+            }
+            options.threads = static_cast<unsigned int>(number);
+            break;
+        case 's':
+            stats = true;
+            break;
+        case 'h':
+            usage(stdout);
+            return EXIT_SUCCESS;
+        default:
+            usage(stderr);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (optind < argc) {
+        std::fprintf(stderr, "multinv: unexpected argument '%s'\n", argv[optind]);
+        usage(stderr);
+        return EXIT_FAILURE;
+    }
+
+    if (!have_operation) {
+        if (have_stream_options) {
+            std::fprintf(stderr, "multinv: --operation is required\n");
+            return EXIT_FAILURE;
+        }
+        homework();
+        if (stats)
+            print_instrumentation_stats(stderr);
+        return EXIT_SUCCESS;
+    }
+
+    bool needs_operand = options.operation != StreamOperation::Inverse;
+    if (needs_operand && !have_operand) {
+        std::fprintf(stderr, "multinv: this operation needs --operand\n");
+        return EXIT_FAILURE;
+    }
+
+    int input_fd = STDIN_FILENO;
+    if (input_path && std::strcmp(input_path, "-") != 0) {
+        input_fd = open(input_path, O_RDONLY | O_CLOEXEC);
+        if (input_fd < 0) {
+            std::fprintf(stderr, "multinv: %s: %s\n", input_path, std::strerror(errno));
+            return EXIT_FAILURE;
+        }
+    }
+
+    int output_fd = STDOUT_FILENO;
+    if (output_path && std::strcmp(output_path, "-") != 0) {
+        output_fd = open(output_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+        if (output_fd < 0) {
+            std::fprintf(stderr, "multinv: %s: %s\n", output_path, std::strerror(errno));
+            return EXIT_FAILURE;
+        }
+    }
+
+    bool success = process_stream(input_fd, output_fd, options);
+
+    if (output_fd != STDOUT_FILENO && close(output_fd) != 0) {
+        std::fprintf(stderr, "multinv: %s: %s\n", output_path, std::strerror(errno));
+        success = false;
+    }
+    if (input_fd != STDIN_FILENO)
+        close(input_fd);
+
+    if (stats)
+        print_instrumentation_stats(stderr);
+
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,108 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2016 Michael Catanzaro <michael.catanzaro@mst.edu>
+ * Copyright (c) 2016 Jacob Fischer <jtf3m8@mst.edu>
+ * Copyright (c) 2016 Christian Storer <cs9yb@mst.edu>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "parallel.h"
+
+#include "field-tables.h"
+#include "region.h"
+
+#include <algorithm>
+#include <atomic>
+
+namespace multinv {
+
+void parallel_mul_region(ThreadPool& pool, uint8_t* dst, const uint8_t* src, uint8_t constant, size_t len,
+                         uint16_t irreducible_polynomial, int characteristic) {
+    pool.parallel_for(len, parallel_grain_bytes, [=](size_t begin, size_t end) {
+        gf_mul_region(dst + begin, src + begin, constant, end - begin, irreducible_polynomial, characteristic);
+    });
+}
+
+void parallel_mul_add_region(ThreadPool& pool, uint8_t* dst, const uint8_t* src, uint8_t constant, size_t len,
+                             uint16_t irreducible_polynomial, int characteristic) {
+    pool.parallel_for(len, parallel_grain_bytes, [=](size_t begin, size_t end) {
+        gf_mul_add_region(dst + begin, src + begin, constant, end - begin, irreducible_polynomial, characteristic);
+    });
+}
+
+void parallel_inverse_region(ThreadPool& pool, uint8_t* dst, const uint8_t* src, size_t len,
+                             uint16_t irreducible_polynomial, int characteristic) {
+    pool.parallel_for(len, parallel_grain_bytes, [=](size_t begin, size_t end) {
+        gf_inverse_region(dst + begin, src + begin, end - begin, irreducible_polynomial, characteristic);
+    });
+}
+
+template <typename Element>
+static size_t parallel_inverse_batch_impl(ThreadPool& pool, const Element* in, Element* out, size_t count) {
+    std::atomic<size_t> zeros(0);
+    size_t grain = std::max<size_t>(1, parallel_grain_bytes / sizeof(Element));
+    pool.parallel_for(count, grain, [&](size_t begin, size_t end) {
+        zeros += multiplicative_inverse_batch(in + begin, out + begin, end - begin);
+    });
+    return zeros;
+}
+
+size_t parallel_inverse_batch(ThreadPool& pool, const Polynomial* in, Polynomial* out, size_t count) {
+    return parallel_inverse_batch_impl(pool, in, out, count);
+}
+
+template <typename Word>
+size_t parallel_inverse_batch(ThreadPool& pool, const WidePolynomial<Word>* in, WidePolynomial<Word>* out, size_t count) {
+    return parallel_inverse_batch_impl(pool, in, out, count);
+}
+
+template size_t parallel_inverse_batch(ThreadPool&, const WidePolynomial<uint16_t>*, WidePolynomial<uint16_t>*, size_t);
+template size_t parallel_inverse_batch(ThreadPool&, const WidePolynomial<uint32_t>*, WidePolynomial<uint32_t>*, size_t);
+template size_t parallel_inverse_batch(ThreadPool&, const WidePolynomial<uint64_t>*, WidePolynomial<uint64_t>*, size_t);
+template size_t parallel_inverse_batch(ThreadPool&, const WidePolynomial<uint128_t>*, WidePolynomial<uint128_t>*, size_t);
+
+static uint8_t dot_product(const uint8_t* a, const uint8_t* b, size_t len,
+                           uint16_t irreducible_polynomial, int characteristic) {
+    uint8_t sum = 0;
+    if (const FieldTables* tables = FieldTables::get(irreducible_polynomial, characteristic)) {
+        for (size_t i = 0; i < len; ++i)
+            sum ^= tables->multiply(a[i], b[i]);
+    } else {
+        for (size_t i = 0; i < len; ++i)
+            sum ^= multiply_bitwise(a[i], b[i], irreducible_polynomial, characteristic);
+    }
+    return sum;
+}
+
+void parallel_matrix_vector(ThreadPool& pool, const uint8_t* matrix, size_t rows, size_t columns,
+                            const uint8_t* x, uint8_t* y,
+                            uint16_t irreducible_polynomial, int characteristic) {
+    size_t grain = std::max<size_t>(1, parallel_grain_bytes / std::max<size_t>(1, columns));
+    pool.parallel_for(rows, grain, [=](size_t begin, size_t end) {
+        for (size_t row = begin; row < end; ++row)
+            y[row] = dot_product(matrix + row * columns, x, columns, irreducible_polynomial, characteristic);
+    });
+}
+
+}
@@ -0,0 +1,74 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2016 Michael Catanzaro <michael.catanzaro@mst.edu>
+ * Copyright (c) 2016 Jacob Fischer <jtf3m8@mst.edu>
+ * Copyright (c) 2016 Christian Storer <cs9yb@mst.edu>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "batch-inverse.h"
+#include "polynomial.h"
+#include "thread-pool.h"
+#include "wide-polynomial.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace multinv {
+
+// Multithreaded versions of the bulk operations. Work is split into chunks of
+// about parallel_grain_bytes, small enough to stay in cache and numerous
+// enough to balance across threads. Inputs of a chunk or less are processed
+// inline on the calling thread.
+const size_t parallel_grain_bytes = 64 * 1024;
+
+// gf_mul_region(), gf_mul_add_region() and gf_inverse_region(), in parallel.
+void parallel_mul_region(ThreadPool&, uint8_t* dst, const uint8_t* src, uint8_t constant, size_t len,
+                         uint16_t irreducible_polynomial = Polynomial::aes_irreducible_polynomial,
+                         int characteristic = 8);
+void parallel_mul_add_region(ThreadPool&, uint8_t* dst, const uint8_t* src, uint8_t constant, size_t len,
+                             uint16_t irreducible_polynomial = Polynomial::aes_irreducible_polynomial,
+                             int characteristic = 8);
+void parallel_inverse_region(ThreadPool&, uint8_t* dst, const uint8_t* src, size_t len,
+                             uint16_t irreducible_polynomial = Polynomial::aes_irreducible_polynomial,
+                             int characteristic = 8);
+
+// multiplicative_inverse_batch(), in parallel. Each chunk gets its own
+// Montgomery batch, so this costs one inversion per chunk rather than one
+// overall.
+size_t parallel_inverse_batch(ThreadPool&, const Polynomial* in, Polynomial* out, size_t count);
+template <typename Word>
+size_t parallel_inverse_batch(ThreadPool&, const WidePolynomial<Word>* in, WidePolynomial<Word>* out, size_t count);
+
+// y = A * x, where A is a rows x columns matrix stored row by row, and x and
+// y are vectors of columns and rows elements respectively. y must not overlap
+// A or x.
+void parallel_matrix_vector(ThreadPool&, const uint8_t* matrix, size_t rows, size_t columns,
+                            const uint8_t* x, uint8_t* y,
+                            uint16_t irreducible_polynomial = Polynomial::aes_irreducible_polynomial,
+                            int characteristic = 8);
+
+}
@@ -29,9 +29,13 @@
 
 #include "polynomial.h"
 
+#include "factor.h"
+#include "field-tables.h"
+#include "instrumentation.h"
+
 #include <cassert>
-#include <cmath>
 #include <cstdlib>
+#include <utility>
 
 namespace multinv {
 
@@ -53,6 +57,11 @@ Polynomial::Polynomial(uint8_t value,
     uint8_t characteristic_mask = 0b11111111;
     characteristic_mask >>= (8 - characteristic);
     assert((value & ~characteristic_mask) == 0);
+
+    // And that there's a field here at all. Otherwise we'd only find out
+    // when multiplicative_inverse() crashes. This is cached, so it's cheap
+    // after the first time.
+    assert(FieldTables::get(irreducible_polynomial, characteristic));
 #endif
 }
 
@@ -68,45 +77,60 @@ Polynomial& Polynomial::operator-=(const Polynomial& rhs) {
     return *this;
 }
 
-// Based on https://en.wikipedia.org/wiki/Finite_field_arithmetic#Rijndael.27s_finite_field
-// Generalized to work with any characteristic.
 Polynomial& Polynomial::operator*=(const Polynomial& rhs) {
-    // FIXME: Consider turning this into a template class with the irreducible
-    // polynomial and characteristic as template parameters, to prevent attempts
-    // to multiply polynomials with different fields at compile time.
+    MULTINV_INSTRUMENT(Multiply, m_irreducible_polynomial, m_characteristic, 1);
+
+    // If you know your field at compile time, use GF<IP, N> instead, and
+    // attempts to multiply polynomials with different fields won't compile.
     assert(m_irreducible_polynomial == rhs.m_irreducible_polynomial);
     assert(m_irreducible_polynomial != 0);
     assert(m_characteristic == rhs.m_characteristic);
     assert(m_characteristic != 0);
 
-    uint8_t leftmost_bit_mask = 1 << (m_characteristic - 1);
-    uint8_t truncate_mask = ~(leftmost_bit_mask << 1);
-
-    uint8_t a = m_value;
-    uint8_t b = rhs.m_value;
-
-    m_value = 0;
-
-    while (a != 0 && b != 0) {
-        // Polynomial addition
-        if (b & 0b00000001)
-            m_value ^= a;
+#ifdef MULTINV_CONSTANT_TIME
+    m_value = multiply_constant_time(m_value, rhs.m_value, m_irreducible_polynomial, m_characteristic);
+#else
+    if (const FieldTables* tables = FieldTables::get(m_irreducible_polynomial, m_characteristic))
+        m_value = tables->multiply(m_value, rhs.m_value);
+    else
+        m_value = multiply_bitwise(m_value, rhs.m_value, m_irreducible_polynomial, m_characteristic);
+#endif
 
-        // Divide by x
-        b >>= 1;
+    return *this;
+}
 
-        // Multiply by x
-        bool carry = (a & leftmost_bit_mask);
-        a <<= 1;
-        a &= truncate_mask;
+Polynomial& Polynomial::operator/=(const Polynomial& rhs) {
+    assert(m_irreducible_polynomial == rhs.m_irreducible_polynomial);
+    assert(m_characteristic == rhs.m_characteristic);
 
-        if (carry)
-            a ^= (m_irreducible_polynomial & truncate_mask);
+#ifdef MULTINV_CONSTANT_TIME
+    // Can't check for zero without branching on it, so division by zero
+    // gives zero here, same as InverseStrategy::ConstantTime.
+    *this *= multiplicative_inverse(rhs);
+#else
+    // One lookup: a / b = g^(log a - log b). No inverse required.
+    if (const FieldTables* tables = FieldTables::get(m_irreducible_polynomial, m_characteristic)) {
+        if (rhs.m_value == 0) {
+            MULTINV_INSTRUMENT_EVENT(InverseOfZero, m_irreducible_polynomial, m_characteristic, 1);
+            std::abort();
+        }
+        m_value = tables->divide(m_value, rhs.m_value);
+    } else {
+        *this *= multiplicative_inverse(rhs, InverseStrategy::ExtendedEuclid);
     }
+#endif
 
     return *this;
 }
 
+Polynomial multiply_constant_time(const Polynomial& lhs, const Polynomial& rhs) {
+    assert(lhs.irreducible_polynomial() == rhs.irreducible_polynomial());
+    assert(lhs.characteristic() == rhs.characteristic());
+
+    uint8_t value = multiply_constant_time(lhs.value(), rhs.value(), lhs.irreducible_polynomial(), lhs.characteristic());
+    return Polynomial(value, lhs.irreducible_polynomial(), lhs.characteristic());
+}
+
 Polynomial operator+(Polynomial lhs, const Polynomial& rhs) {
     lhs += rhs;
     return lhs;
@@ -117,11 +141,117 @@ Polynomial operator-(Polynomial lhs, const Polynomial& rhs) {
     return lhs;
 }
 
-Polynomial operator*(Polynomial lhs, const Polynomial& rhs) {
-    lhs *= rhs;
+const CarrylessNibbleTable carryless_nibble_table = make_carryless_nibble_table();
+
+Polynomial UnreducedPolynomial::reduce() const {
+    uint8_t value;
+#ifdef MULTINV_CONSTANT_TIME
+    value = reduce_constant_time(m_bits, m_irreducible_polynomial, m_characteristic);
+#else
+    if (const FieldTables* tables = FieldTables::get(m_irreducible_polynomial, m_characteristic))
+        value = tables->reduce(m_bits);
+    else
+        value = reduce_constant_time(m_bits, m_irreducible_polynomial, m_characteristic);
+#endif
+    return Polynomial(value, m_irreducible_polynomial, m_characteristic);
+}
+
+UnreducedPolynomial& UnreducedPolynomial::operator*=(const Polynomial& rhs) {
+    *this = reduce() * rhs;
+    return *this;
+}
+
+UnreducedPolynomial& UnreducedPolynomial::operator/=(const Polynomial& rhs) {
+    *this = UnreducedPolynomial(reduce() / rhs);
+    return *this;
+}
+
+Polynomial operator/(Polynomial lhs, const Polynomial& rhs) {
+    lhs /= rhs;
     return lhs;
 }
 
+// Right-to-left square-and-multiply, for when there are no tables to do it in
+// one step. The exponent isn't secret, so this is fine for the constant-time
+// build too.
+static Polynomial pow_square_and_multiply(Polynomial base, unsigned int exponent) {
+    Polynomial result{1, base.irreducible_polynomial(), base.characteristic()};
+    while (exponent) {
+        if (exponent & 1)
+            result *= base;
+        base *= base;
+        exponent >>= 1;
+    }
+    return result;
+}
+
+Polynomial pow(const Polynomial& p, unsigned int exponent) {
+#ifndef MULTINV_CONSTANT_TIME
+    if (const FieldTables* tables = FieldTables::get(p.irreducible_polynomial(), p.characteristic()))
+        return Polynomial(tables->power(p.value(), exponent), p.irreducible_polynomial(), p.characteristic());
+#endif
+    return pow_square_and_multiply(p, exponent);
+}
+
+Polynomial square(const Polynomial& p) {
+#ifndef MULTINV_CONSTANT_TIME
+    if (const FieldTables* tables = FieldTables::get(p.irreducible_polynomial(), p.characteristic()))
+        return Polynomial(tables->square(p.value()), p.irreducible_polynomial(), p.characteristic());
+#endif
+    return p * p;
+}
+
+Polynomial sqrt(const Polynomial& p) {
+#ifndef MULTINV_CONSTANT_TIME
+    if (const FieldTables* tables = FieldTables::get(p.irreducible_polynomial(), p.characteristic()))
+        return Polynomial(tables->sqrt(p.value()), p.irreducible_polynomial(), p.characteristic());
+#endif
+    // Squaring n times gets back where we started, so n - 1 times gets the
+    // square root.
+    Polynomial result = p;
+    for (int i = 1; i < p.characteristic(); ++i)
+        result *= result;
+    return result;
+}
+
+static unsigned int gcd(unsigned int a, unsigned int b) {
+    while (b != 0) {
+        unsigned int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// With p = g^log(p), p^k == 1 exactly when order() divides k * log(p).
+// Orders and logarithms aren't secret, so these use the log tables even in
+// the constant-time build. If there are no tables, there's no field.
+unsigned int element_order(const Polynomial& p) {
+    if (p.value() == 0)
+        std::abort();
+    const FieldTables& tables = FieldTables::require(p.irreducible_polynomial(), p.characteristic());
+    return tables.order() / gcd(tables.log(p.value()), tables.order());
+}
+
+bool is_generator(const Polynomial& p) {
+    const FieldTables& tables = FieldTables::require(p.irreducible_polynomial(), p.characteristic());
+    return p.value() != 0 && element_order(p) == tables.order();
+}
+
+bool discrete_log(const Polynomial& p, const Polynomial& base, unsigned int& log) {
+    assert(p.irreducible_polynomial() == base.irreducible_polynomial());
+    assert(p.characteristic() == base.characteristic());
+    if (p.value() == 0 || base.value() == 0)
+        std::abort();
+
+    const FieldTables& tables = FieldTables::require(p.irreducible_polynomial(), p.characteristic());
+    uint64_t k;
+    if (!solve_linear_congruence(tables.log(base.value()), tables.log(p.value()), tables.order(), k))
+        return false;
+    log = static_cast<unsigned int>(k);
+    return true;
+}
+
 bool operator==(const Polynomial& lhs, const Polynomial& rhs) {
     return lhs.value() == rhs.value();
 }
@@ -146,12 +276,14 @@ bool operator>=(const Polynomial& lhs, const Polynomial& rhs) {
     return !(lhs < rhs);
 }
 
-Polynomial multiplicative_inverse(const Polynomial& p) {
+// The original implementation, kept around so the benchmark has something to
+// feel good about.
+static Polynomial inverse_brute_force(const Polynomial& p) {
     // We're supposed to extend the extended Euclidean algorithm to cover
     // polynomials and use that here. That would be smart, but I'm not smart.
     // I think there's an easier way... test every polynomial in the field!
     // (Efficiency is obviously not a goal here.)
-    for (uint8_t i = 1; i < std::pow(2, p.characteristic()); ++i) {
+    for (unsigned int i = 1; i < (1u << p.characteristic()); ++i) {
         Polynomial candidate(i, p.irreducible_polynomial(), p.characteristic());
         Polynomial result = p * candidate;
         if (result.value() == 1)
@@ -163,4 +295,127 @@ Polynomial multiplicative_inverse(const Polynomial& p) {
     std::abort();
 }
 
+// Degree of a nonzero polynomial over GF(2).
+static int degree(unsigned int p) {
+    assert(p != 0);
+    return 31 - __builtin_clz(p);
+}
+
+// Guide to Elliptic Curve Cryptography (Hankerson, Menezes, Vanstone),
+// algorithm 2.48: the extended Euclidean algorithm specialized to GF(2)[x].
+// Turns out I was smart enough after all.
+static Polynomial inverse_extended_euclid(const Polynomial& p) {
+    // Invariants: p * g1 == u and p * g2 == v, modulo the irreducible polynomial.
+    unsigned int u = p.value();
+    unsigned int v = p.irreducible_polynomial();
+    unsigned int g1 = 1;
+    unsigned int g2 = 0;
+
+    while (u != 1) {
+        // gcd(p, irreducible polynomial) != 1, so there is no inverse. Either
+        // p is zero or the "irreducible" polynomial is lying to us.
+        if (u == 0)
+            std::abort();
+
+        int j = degree(u) - degree(v);
+        if (j < 0) {
+            std::swap(u, v);
+            std::swap(g1, g2);
+            j = -j;
+        }
+        u ^= v << j;
+        g1 ^= g2 << j;
+    }
+
+    return Polynomial(g1, p.irreducible_polynomial(), p.characteristic());
+}
+
+// Fermat: a^(2^n - 1) == 1, so a^-1 == a^(2^n - 2) == (a^(2^(n-1) - 1))^2.
+// Itoh and Tsujii observed that b_k = a^(2^k - 1) satisfies
+// b_(j+k) = b_j^(2^k) * b_k, which gets us to b_(n-1) in O(log n)
+// multiplications by walking the bits of n - 1, much like square-and-multiply.
+static Polynomial inverse_itoh_tsujii(const Polynomial& p) {
+    if (p.value() == 0)
+        std::abort();
+
+    Polynomial b{1, p.irreducible_polynomial(), p.characteristic()};
+    int m = p.characteristic() - 1;
+    if (m > 0) {
+        b = p;
+        int k = 1;
+        for (int bit = degree(m) - 1; bit >= 0; --bit) {
+            Polynomial t = b;
+            for (int i = 0; i < k; ++i)
+                t *= t;
+            b *= t;
+            k *= 2;
+
+            if (m & (1 << bit)) {
+                b *= b;
+                b *= p;
+                ++k;
+            }
+        }
+    }
+
+    return b * b;
+}
+
+// a^(2^n - 2) = a^2 * a^4 * ... * a^(2^(n-1)). The exponent is public, so
+// plain square-and-multiply is fine, and since 0^anything is 0, zero comes out
+// as zero without anybody having to look at it. Except in GF(2), where the
+// exponent is 0; there the answer is a itself.
+static Polynomial inverse_constant_time(const Polynomial& p) {
+    uint16_t ip = p.irreducible_polynomial();
+    int n = p.characteristic();
+    uint8_t a = p.value();
+
+    if (n == 1)
+        return p;
+
+    uint8_t result = 1;
+    uint8_t square = a;
+    for (int i = 1; i < n; ++i) {
+        square = multiply_constant_time(square, square, ip, n);
+        result = multiply_constant_time(result, square, ip, n);
+    }
+
+    return Polynomial(result, ip, n);
+}
+
+static Polynomial inverse_table(const Polynomial& p) {
+    const FieldTables* tables = FieldTables::get(p.irreducible_polynomial(), p.characteristic());
+    if (!tables)
+        return inverse_extended_euclid(p);
+
+    if (p.value() == 0)
+        std::abort();
+
+    return Polynomial(tables->inverse(p.value()), p.irreducible_polynomial(), p.characteristic());
+}
+
+Polynomial multiplicative_inverse(const Polynomial& p, InverseStrategy strategy) {
+    MULTINV_INSTRUMENT(Inverse, p.irreducible_polynomial(), p.characteristic(), 1);
+#ifndef MULTINV_CONSTANT_TIME
+    // Not in the constant-time build, where even this branch would leak.
+    if (p.value() == 0)
+        MULTINV_INSTRUMENT_EVENT(InverseOfZero, p.irreducible_polynomial(), p.characteristic(), 1);
+#endif
+
+    switch (strategy) {
+    case InverseStrategy::Table:
+        return inverse_table(p);
+    case InverseStrategy::BruteForce:
+        return inverse_brute_force(p);
+    case InverseStrategy::ExtendedEuclid:
+        return inverse_extended_euclid(p);
+    case InverseStrategy::ItohTsujii:
+        return inverse_itoh_tsujii(p);
+    case InverseStrategy::ConstantTime:
+        return inverse_constant_time(p);
+    default:
+        std::abort();
+    }
+}
+
 }
@@ -29,6 +29,9 @@
 
 #pragma once
 
+#include "instrumentation.h"
+
+#include <cassert>
 #include <cstdint>
 
 namespace multinv {
@@ -54,6 +57,10 @@ class Polynomial {
     Polynomial& operator+=(const Polynomial&);
     Polynomial& operator-=(const Polynomial&);
     Polynomial& operator*=(const Polynomial&);
+    // Division by zero crashes, like multiplicative_inverse(). Except with
+    // --enable-constant-time, where it gives zero instead, like
+    // InverseStrategy::ConstantTime, because checking would be a branch.
+    Polynomial& operator/=(const Polynomial&);
 
     static const uint16_t aes_irreducible_polynomial = 0b100011011;
 
@@ -63,12 +70,268 @@ class Polynomial {
     int m_characteristic;
 };
 
+// Ways to compute a multiplicative inverse. They all give the same answer;
+// they differ only in how long it takes to get there.
+enum class InverseStrategy {
+    // Look it up in the field's FieldTables. O(1), once the tables are built.
+    Table,
+    // Try every element of the field until one works. O(2^n) multiplications.
+    BruteForce,
+    // Extended Euclidean algorithm over GF(2)[x]. O(n) shifts and XORs.
+    ExtendedEuclid,
+    // Fermat's little theorem, a^-1 = a^(2^n - 2), evaluated with the
+    // Itoh-Tsujii addition chain. O(log n) multiplications plus squarings.
+    ItohTsujii,
+    // Fermat again, but with a fixed sequence of n - 1 squarings and n - 1
+    // multiplications done by multiply_constant_time(), so the time taken
+    // doesn't depend on the input. Unlike the others, this maps zero to zero
+    // rather than crashing, because checking for zero would be a branch.
+    ConstantTime,
+};
+
+// What multiplicative_inverse() uses if you don't say. Configuring with
+// --enable-constant-time makes Polynomial constant-time throughout.
+#ifdef MULTINV_CONSTANT_TIME
+constexpr InverseStrategy default_inverse_strategy = InverseStrategy::ConstantTime;
+#else
+constexpr InverseStrategy default_inverse_strategy = InverseStrategy::Table;
+#endif
+
+// Shift-and-reduce multiplication of the raw bit representations of two
+// polynomials in the field defined by irreducible_polynomial. This is the slow
+// path: Polynomial::operator*= uses FieldTables instead whenever it can.
+//
+// Based on https://en.wikipedia.org/wiki/Finite_field_arithmetic#Rijndael.27s_finite_field
+// Generalized to work with any characteristic. It's constexpr so GF<> can
+// build its tables at compile time.
+constexpr uint8_t multiply_bitwise(uint8_t a, uint8_t b, uint16_t irreducible_polynomial, int characteristic) {
+    uint8_t leftmost_bit_mask = 1 << (characteristic - 1);
+    uint8_t truncate_mask = ~(leftmost_bit_mask << 1);
+
+    uint8_t result = 0;
+
+    while (a != 0 && b != 0) {
+        // Polynomial addition
+        if (b & 0b00000001)
+            result ^= a;
+
+        // Divide by x
+        b >>= 1;
+
+        // Multiply by x
+        bool carry = (a & leftmost_bit_mask);
+        a <<= 1;
+        a &= truncate_mask;
+
+        if (carry)
+            a ^= (irreducible_polynomial & truncate_mask);
+    }
+
+    return result;
+}
+
+// Hides x from the optimizer, so it can't notice that a mask is always 0x00
+// or 0xff and turn the arithmetic on it back into a branch.
+inline uint8_t value_barrier(uint8_t x) {
+    __asm__("" : "+r"(x));
+    return x;
+}
+
+// multiply_bitwise() without the early exit or the branches: always exactly
+// characteristic iterations, with the conditional XORs done by masking. The
+// time taken depends only on the field, never on a or b. No tables, either,
+// so there's nothing for a cache-timing attack to look at.
+inline uint8_t multiply_constant_time(uint8_t a, uint8_t b, uint16_t irreducible_polynomial, int characteristic) {
+    unsigned int truncate_mask = (1u << characteristic) - 1;
+    unsigned int reduction = irreducible_polynomial & truncate_mask;
+
+    unsigned int result = 0;
+    for (int i = 0; i < characteristic; ++i) {
+        // 0xff if the low bit of b is set, else 0.
+        uint8_t add = value_barrier(static_cast<uint8_t>(0u - (b & 1u)));
+        result ^= a & add;
+        b >>= 1;
+
+        uint8_t carry = value_barrier(static_cast<uint8_t>(0u - ((a >> (characteristic - 1)) & 1u)));
+        a = static_cast<uint8_t>(((a << 1) & truncate_mask) ^ (reduction & carry));
+    }
+
+    return static_cast<uint8_t>(result);
+}
+
+// Carry-less products of every pair of polynomials of degree less than four.
+struct CarrylessNibbleTable {
+    uint8_t products[16][16];
+};
+
+constexpr CarrylessNibbleTable make_carryless_nibble_table() {
+    CarrylessNibbleTable table{};
+    for (unsigned int a = 0; a < 16; ++a) {
+        for (unsigned int b = 0; b < 16; ++b) {
+            unsigned int product = 0;
+            for (int i = 0; i < 4; ++i) {
+                if (b & (1u << i))
+                    product ^= a << i;
+            }
+            table.products[a][b] = static_cast<uint8_t>(product);
+        }
+    }
+    return table;
+}
+
+extern const CarrylessNibbleTable carryless_nibble_table;
+
+// The product of a and b as polynomials over GF(2), not reduced modulo
+// anything, so up to 15 bits. Schoolbook multiplication of the nibbles, out of
+// a table small enough to stay in cache. The constant-time build can't look
+// anything up, so it shifts and masks a bit at a time instead, like
+// multiply_constant_time() but without the reduction.
+inline __attribute__((always_inline)) uint16_t multiply_carryless(uint8_t a, uint8_t b) {
+#ifdef MULTINV_CONSTANT_TIME
+    unsigned int result = 0;
+    for (int i = 0; i < 8; ++i) {
+        uint8_t add = value_barrier(static_cast<uint8_t>(0u - ((b >> i) & 1u)));
+        result ^= static_cast<unsigned int>(a & add) << i;
+    }
+    return static_cast<uint16_t>(result);
+#else
+    const auto& products = carryless_nibble_table.products;
+    unsigned int low = products[a & 0xf][b & 0xf];
+    unsigned int middle = products[a >> 4][b & 0xf] ^ products[a & 0xf][b >> 4];
+    unsigned int high = products[a >> 4][b >> 4];
+    return static_cast<uint16_t>(low ^ (middle << 4) ^ (high << 8));
+#endif
+}
+
+// value modulo irreducible_polynomial, where value has degree at most
+// 2 * characteristic - 2: a multiply_carryless() product, or a sum of them.
+// Clears the high bits one at a time from the top, by masking, so the time
+// taken depends only on the field.
+inline uint8_t reduce_constant_time(uint16_t value, uint16_t irreducible_polynomial, int characteristic) {
+    unsigned int result = value;
+    for (int bit = 2 * characteristic - 2; bit >= characteristic; --bit) {
+        // 0xffff if the bit is set, else 0.
+        unsigned int mask = value_barrier(static_cast<uint8_t>(0u - ((result >> bit) & 1u))) * 0x101u;
+        result ^= (static_cast<unsigned int>(irreducible_polynomial) << (bit - characteristic)) & mask;
+    }
+    return static_cast<uint8_t>(result);
+}
+
+// Per-call version of the --enable-constant-time multiplication.
+Polynomial multiply_constant_time(const Polynomial&, const Polynomial&);
+
+// A sum of products of Polynomials that hasn't been reduced modulo the
+// irreducible polynomial yet. This is what Polynomial's operator* returns, so
+// that in a * b + c * d + e * f each product is just a carry-less multiply,
+// the sums are XORs of those, and the reduction happens once, when the result
+// turns back into a Polynomial. It does that implicitly, and has value(),
+// operator*= and operator/= of its own, so code written for operator*
+// returning Polynomial still works, and gets the same answers.
+//
+// If you're summing a lot of products, say for a dot product, accumulate them
+// in one of these and convert at the end:
+//
+//   UnreducedPolynomial sum{0, ip, n};
+//   for (size_t i = 0; i < count; ++i)
+//       sum += a[i] * b[i];
+//   Polynomial result = sum;
+//
+// What doesn't work is a template that wants both arguments to be the same
+// type: std::max(a * b, c) can't decide between UnreducedPolynomial and
+// Polynomial. Say std::max<Polynomial>(a * b, c), or convert first. The same
+// goes for auto: auto p = a * b makes p an UnreducedPolynomial, which is fine
+// for arithmetic but isn't a Polynomial if you need one.
+//
+// The bits never need more than 15 bits, however many products are summed.
+class UnreducedPolynomial {
+  public:
+    explicit UnreducedPolynomial(uint16_t bits,
+                                 uint16_t irreducible_polynomial = Polynomial::aes_irreducible_polynomial,
+                                 int characteristic = 8)
+        : m_bits(bits)
+        , m_irreducible_polynomial(irreducible_polynomial)
+        , m_characteristic(characteristic)
+    {
+        assert((bits >> (2 * characteristic - 1)) == 0);
+    }
+
+    explicit UnreducedPolynomial(const Polynomial& p)
+        : UnreducedPolynomial(p.value(), p.irreducible_polynomial(), p.characteristic())
+    {
+    }
+
+    // The representation as a polynomial over GF(2), degree at most 2n - 2.
+    uint16_t bits() const { return m_bits; }
+    uint16_t irreducible_polynomial() const { return m_irreducible_polynomial; }
+    int characteristic() const { return m_characteristic; }
+
+    Polynomial reduce() const;
+    operator Polynomial() const { return reduce(); }
+    // Same as Polynomial's, so (a * b).value() keeps working.
+    uint8_t value() const { return reduce().value(); }
+
+    UnreducedPolynomial& operator+=(const UnreducedPolynomial& rhs) {
+        assert(m_irreducible_polynomial == rhs.m_irreducible_polynomial);
+        assert(m_characteristic == rhs.m_characteristic);
+        m_bits ^= rhs.m_bits;
+        return *this;
+    }
+    UnreducedPolynomial& operator+=(const Polynomial& rhs) { return *this += UnreducedPolynomial(rhs); }
+    UnreducedPolynomial& operator-=(const UnreducedPolynomial& rhs) { return *this += rhs; }
+    UnreducedPolynomial& operator-=(const Polynomial& rhs) { return *this += rhs; }
+    // These have to reduce first, but the product stays unreduced.
+    UnreducedPolynomial& operator*=(const Polynomial&);
+    UnreducedPolynomial& operator/=(const Polynomial&);
+
+  private:
+    uint16_t m_bits;
+    uint16_t m_irreducible_polynomial;
+    int m_characteristic;
+};
+
 // The one! The only! Our reason for being! MULTINV!
-Polynomial multiplicative_inverse(const Polynomial&);
+Polynomial multiplicative_inverse(const Polynomial&,
+                                  InverseStrategy = default_inverse_strategy);
 
 Polynomial operator+(Polynomial, const Polynomial&);
 Polynomial operator-(Polynomial, const Polynomial&);
-Polynomial operator*(Polynomial, const Polynomial&);
+Polynomial operator/(Polynomial, const Polynomial&);
+
+// lhs * rhs, left unreduced; see UnreducedPolynomial. Always inlined, even
+// into cold code, since a call would cost more than the multiplication.
+inline __attribute__((always_inline))
+UnreducedPolynomial operator*(const Polynomial& lhs, const Polynomial& rhs) {
+    assert(lhs.irreducible_polynomial() == rhs.irreducible_polynomial());
+    assert(lhs.characteristic() == rhs.characteristic());
+    MULTINV_INSTRUMENT_EVENT(Multiply, lhs.irreducible_polynomial(), lhs.characteristic(), 1);
+    return UnreducedPolynomial(multiply_carryless(lhs.value(), rhs.value()),
+                               lhs.irreducible_polynomial(), lhs.characteristic());
+}
+
+// Sums involving an unreduced product stay unreduced too.
+inline UnreducedPolynomial operator+(UnreducedPolynomial lhs, const UnreducedPolynomial& rhs) { return lhs += rhs; }
+inline UnreducedPolynomial operator+(UnreducedPolynomial lhs, const Polynomial& rhs) { return lhs += rhs; }
+inline UnreducedPolynomial operator+(const Polynomial& lhs, UnreducedPolynomial rhs) { return rhs += lhs; }
+inline UnreducedPolynomial operator-(UnreducedPolynomial lhs, const UnreducedPolynomial& rhs) { return lhs -= rhs; }
+inline UnreducedPolynomial operator-(UnreducedPolynomial lhs, const Polynomial& rhs) { return lhs -= rhs; }
+inline UnreducedPolynomial operator-(const Polynomial& lhs, UnreducedPolynomial rhs) { return rhs -= lhs; }
+
+// p^exponent. 0^0 is 1.
+Polynomial pow(const Polynomial&, unsigned int exponent);
+// p * p.
+Polynomial square(const Polynomial&);
+// The unique q with q * q == p, i.e. p^(2^(n-1)).
+Polynomial sqrt(const Polynomial&);
+
+// The smallest k > 0 with p^k == 1. Always divides 2^n - 1. Zero has no
+// order; don't ask.
+unsigned int element_order(const Polynomial&);
+// Whether every nonzero element of the field is a power of p.
+bool is_generator(const Polynomial&);
+// log_base(p): the smallest k >= 0 with pow(base, k) == p. Returns false if
+// there isn't one. p and base must be nonzero. These come straight out of
+// the log tables; FieldDescriptor does the same for fields up to GF(2^64).
+bool discrete_log(const Polynomial& p, const Polynomial& base, unsigned int& log);
 
 bool operator==(const Polynomial&, const Polynomial&);
 bool operator!=(const Polynomial&, const Polynomial&);
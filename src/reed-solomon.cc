@@ -0,0 +1,184 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2016 Michael Catanzaro <michael.catanzaro@mst.edu>
+ * Copyright (c) 2016 Jacob Fischer <jtf3m8@mst.edu>
+ * Copyright (c) 2016 Christian Storer <cs9yb@mst.edu>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "reed-solomon.h"
+
+#include "field-matrix.h"
+#include "field-tables.h"
+
+#include <cstdlib>
+#include <utility>
+
+namespace multinv {
+
+// There are a lot of possible erasure patterns, but real systems only ever
+// see a few of them. If we somehow see more than this, start over.
+static const size_t decode_cache_size = 1024;
+
+struct ReedSolomon::DecodePlan {
+    // The first data_shards surviving shards, which everything is rebuilt from.
+    std::vector<size_t> sources;
+    std::vector<size_t> missing_data;
+    std::vector<size_t> missing_parity;
+    // Rows of the inverse of the generator rows for sources, one per missing
+    // data shard.
+    std::unique_ptr<RegionMatrix> recover_data;
+    // Rows of the Cauchy matrix, one per missing parity shard, applied to the
+    // (by then complete) data.
+    std::unique_ptr<RegionMatrix> recover_parity;
+};
+
+static std::vector<uint8_t> cauchy_matrix(size_t rows, size_t columns, const FieldTables& tables) {
+    // x_i = columns + i and y_j = j never collide.
+    std::vector<uint8_t> matrix(rows * columns);
+    for (size_t i = 0; i < rows; ++i) {
+        for (size_t j = 0; j < columns; ++j)
+            matrix[i * columns + j] = tables.inverse(static_cast<uint8_t>((columns + i) ^ j));
+    }
+    return matrix;
+}
+
+// Called from the first member initializer, so that nonsense gets rejected
+// before the rest of them go building matrices out of it. Checks the field
+// first, since the shard limit depends on its size.
+static size_t checked_data_shards(size_t data_shards, size_t parity_shards,
+                                  uint16_t irreducible_polynomial, int characteristic) {
+    FieldTables::require(irreducible_polynomial, characteristic);
+    if (data_shards == 0 || data_shards + parity_shards > (size_t{1} << characteristic))
+        std::abort();
+    return data_shards;
+}
+
+ReedSolomon::ReedSolomon(size_t data_shards, size_t parity_shards,
+                         uint16_t irreducible_polynomial, int characteristic)
+    : m_data_shards(checked_data_shards(data_shards, parity_shards, irreducible_polynomial, characteristic))
+    , m_parity_shards(parity_shards)
+    , m_irreducible_polynomial(irreducible_polynomial)
+    , m_characteristic(characteristic)
+    , m_cauchy(cauchy_matrix(parity_shards, data_shards, FieldTables::require(irreducible_polynomial, characteristic)))
+    , m_encode(m_cauchy.data(), parity_shards, data_shards, irreducible_polynomial, characteristic)
+{
+}
+
+ReedSolomon::~ReedSolomon() = default;
+
+void ReedSolomon::encode(const uint8_t* const* data, uint8_t* const* parity, size_t stripe_size) const {
+    gf_matrix_region(parity, data, m_encode, stripe_size);
+}
+
+std::shared_ptr<const ReedSolomon::DecodePlan> ReedSolomon::decode_plan(const std::vector<bool>& present) const {
+    {
+        std::lock_guard<std::mutex> lock(m_cache_mutex);
+        auto it = m_cache.find(present);
+        if (it != m_cache.end())
+            return it->second;
+    }
+
+    size_t k = m_data_shards;
+    auto plan = std::make_shared<DecodePlan>();
+
+    for (size_t i = 0; i < total_shards(); ++i) {
+        if (present[i]) {
+            if (plan->sources.size() < k)
+                plan->sources.push_back(i);
+        } else if (i < k) {
+            plan->missing_data.push_back(i);
+        } else {
+            plan->missing_parity.push_back(i);
+        }
+    }
+
+    if (!plan->missing_data.empty()) {
+        // The generator rows of the sources: identity rows for data shards,
+        // Cauchy rows for parity shards.
+        FieldMatrix matrix(k, k, m_irreducible_polynomial, m_characteristic);
+        for (size_t r = 0; r < k; ++r) {
+            size_t shard = plan->sources[r];
+            for (size_t c = 0; c < k; ++c)
+                matrix.set(r, c, shard < k ? (shard == c) : m_cauchy[(shard - k) * k + c]);
+        }
+        // Any k rows of the generator are invertible.
+        if (!invert(matrix))
+            std::abort();
+
+        std::vector<uint8_t> rows;
+        for (size_t shard : plan->missing_data)
+            rows.insert(rows.end(), matrix.row(shard), matrix.row(shard) + k);
+        plan->recover_data.reset(new RegionMatrix(rows.data(), plan->missing_data.size(), k,
+                                                  m_irreducible_polynomial, m_characteristic));
+    }
+
+    if (!plan->missing_parity.empty()) {
+        std::vector<uint8_t> rows;
+        for (size_t shard : plan->missing_parity)
+            rows.insert(rows.end(), m_cauchy.begin() + (shard - k) * k, m_cauchy.begin() + (shard - k + 1) * k);
+        plan->recover_parity.reset(new RegionMatrix(rows.data(), plan->missing_parity.size(), k,
+                                                    m_irreducible_polynomial, m_characteristic));
+    }
+
+    std::lock_guard<std::mutex> lock(m_cache_mutex);
+    if (m_cache.size() >= decode_cache_size)
+        m_cache.clear();
+    // If another thread got here first, use its plan; they're identical.
+    return m_cache.emplace(present, std::move(plan)).first->second;
+}
+
+bool ReedSolomon::decode(uint8_t* const* shards, const bool* present, size_t stripe_size) const {
+    std::vector<bool> pattern(present, present + total_shards());
+    size_t surviving = 0;
+    for (bool p : pattern)
+        surviving += p;
+    if (surviving < m_data_shards)
+        return false;
+    if (surviving == total_shards())
+        return true;
+
+    std::shared_ptr<const DecodePlan> plan = decode_plan(pattern);
+
+    if (plan->recover_data) {
+        std::vector<const uint8_t*> sources;
+        for (size_t shard : plan->sources)
+            sources.push_back(shards[shard]);
+        std::vector<uint8_t*> outputs;
+        for (size_t shard : plan->missing_data)
+            outputs.push_back(shards[shard]);
+        gf_matrix_region(outputs.data(), sources.data(), *plan->recover_data, stripe_size);
+    }
+
+    if (plan->recover_parity) {
+        std::vector<uint8_t*> outputs;
+        for (size_t shard : plan->missing_parity)
+            outputs.push_back(shards[shard]);
+        gf_matrix_region(outputs.data(), shards, *plan->recover_parity, stripe_size);
+    }
+
+    return true;
+}
+
+}
@@ -0,0 +1,102 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2016 Michael Catanzaro <michael.catanzaro@mst.edu>
+ * Copyright (c) 2016 Jacob Fischer <jtf3m8@mst.edu>
+ * Copyright (c) 2016 Christian Storer <cs9yb@mst.edu>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "polynomial.h"
+#include "region.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace multinv {
+
+// Systematic Reed-Solomon erasure coding: data_shards stripes of data plus
+// parity_shards stripes of parity, any data_shards of which are enough to get
+// everything back.
+//
+// The generator matrix is the identity on top of a Cauchy matrix,
+// C[i][j] = 1 / (x_i + y_j) with all the x_i and y_j distinct. Every square
+// submatrix of a Cauchy matrix is invertible, which is exactly what makes any
+// data_shards rows of the generator invertible, so there's no need to go
+// hunting for a Vandermonde matrix that happens to work.
+// Reference: J. Blomer et al., "An XOR-Based Erasure-Resilient Coding
+// Scheme", ICSI TR-95-048, 1995.
+class ReedSolomon {
+  public:
+    // data_shards + parity_shards must be at most 2^characteristic, since
+    // the x_i and y_j have to be distinct elements of the field.
+    ReedSolomon(size_t data_shards, size_t parity_shards,
+                uint16_t irreducible_polynomial = Polynomial::aes_irreducible_polynomial,
+                int characteristic = 8);
+    ~ReedSolomon();
+
+    ReedSolomon(const ReedSolomon&) = delete;
+    ReedSolomon& operator=(const ReedSolomon&) = delete;
+
+    size_t data_shards() const { return m_data_shards; }
+    size_t parity_shards() const { return m_parity_shards; }
+    size_t total_shards() const { return m_data_shards + m_parity_shards; }
+
+    // Computes parity[0..parity_shards) from data[0..data_shards), each
+    // stripe_size bytes.
+    void encode(const uint8_t* const* data, uint8_t* const* parity, size_t stripe_size) const;
+
+    // shards has total_shards() buffers of stripe_size bytes, data first,
+    // then parity; present[i] says whether shards[i] survived. Rebuilds every
+    // missing shard in place. Returns false, without touching anything, if
+    // fewer than data_shards() survived.
+    //
+    // The matrix needed for each pattern of erasures is computed the first
+    // time that pattern is seen and cached. Safe to call from several threads
+    // at once.
+    bool decode(uint8_t* const* shards, const bool* present, size_t stripe_size) const;
+
+  private:
+    struct DecodePlan;
+
+    std::shared_ptr<const DecodePlan> decode_plan(const std::vector<bool>& present) const;
+
+    size_t m_data_shards;
+    size_t m_parity_shards;
+    uint16_t m_irreducible_polynomial;
+    int m_characteristic;
+    // parity_shards x data_shards, row-major.
+    std::vector<uint8_t> m_cauchy;
+    RegionMatrix m_encode;
+
+    mutable std::mutex m_cache_mutex;
+    mutable std::map<std::vector<bool>, std::shared_ptr<const DecodePlan>> m_cache;
+};
+
+}
@@ -0,0 +1,537 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2016 Michael Catanzaro <michael.catanzaro@mst.edu>
+ * Copyright (c) 2016 Jacob Fischer <jtf3m8@mst.edu>
+ * Copyright (c) 2016 Christian Storer <cs9yb@mst.edu>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "region.h"
+
+#include "field-tables.h"
+#include "instrumentation.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HAVE_X86_KERNELS 1
+#include <immintrin.h>
+#else
+#define HAVE_X86_KERNELS 0
+#endif
+
+namespace multinv {
+
+// Products of the constant with every possible low nibble and high nibble.
+// Since multiplication distributes over addition, c * x == c * (x & 0x0f) +
+// c * (x & 0xf0), which is two lookups in 16-entry tables: small enough to
+// fit in a SIMD register.
+struct NibbleTables {
+    uint8_t low[16];
+    uint8_t high[16];
+};
+
+// constant * x^j in byte j, for each bit j, which is all it takes to multiply
+// by constant: the rest is XOR. Zero for bits beyond the field. Kept in a
+// register rather than an array, since building the tables below is the
+// bulk of the work of preparing a RegionMatrix.
+static uint64_t basis_products(uint8_t constant, uint16_t irreducible_polynomial, int characteristic) {
+    uint64_t columns = 0;
+    unsigned int product = constant;
+    for (int j = 0; j < characteristic; ++j) {
+        columns |= static_cast<uint64_t>(product) << (8 * j);
+        product <<= 1;
+        // Without a branch, since it's taken half the time at random.
+        product ^= irreducible_polynomial & -((product >> characteristic) & 1);
+    }
+    return columns;
+}
+
+// Builds 8 entries at a time in a 64-bit word from the four columns in the
+// low bytes of columns: entry k is the XOR of the columns for the bits set
+// in k, and byte k of 0xff00ff00ff00ff00 is set exactly when bit 0 of k is,
+// and so on. Nibbles that don't fit in the field can't appear in valid
+// input, so it doesn't matter what they get.
+static inline void nibble_table_from_columns(uint64_t columns, uint8_t* table) {
+    const uint64_t bytes = 0x0101010101010101;
+    uint64_t low = (((columns & 0xff) * bytes) & 0xff00ff00ff00ff00) ^
+                   ((((columns >> 8) & 0xff) * bytes) & 0xffff0000ffff0000) ^
+                   ((((columns >> 16) & 0xff) * bytes) & 0xffffffff00000000);
+    uint64_t high = low ^ (((columns >> 24) & 0xff) * bytes);
+    // Unrolled, so the compiler can merge these into two 8-byte stores.
+#pragma GCC unroll 8
+    for (int k = 0; k < 8; ++k) {
+        table[k] = static_cast<uint8_t>(low >> (8 * k));
+        table[k + 8] = static_cast<uint8_t>(high >> (8 * k));
+    }
+}
+
+static NibbleTables nibble_tables_from_columns(uint64_t columns) {
+    NibbleTables tables;
+    nibble_table_from_columns(columns, tables.low);
+    nibble_table_from_columns(columns >> 32, tables.high);
+    return tables;
+}
+
+static NibbleTables make_nibble_tables(uint8_t constant, uint16_t irreducible_polynomial, int characteristic) {
+    return nibble_tables_from_columns(basis_products(constant, irreducible_polynomial, characteristic));
+}
+
+static void mul_region_scalar(uint8_t* dst, const uint8_t* src, size_t len, const NibbleTables& tables, bool add) {
+    if (add) {
+        for (size_t i = 0; i < len; ++i)
+            dst[i] ^= tables.low[src[i] & 0x0f] ^ tables.high[src[i] >> 4];
+    } else {
+        for (size_t i = 0; i < len; ++i)
+            dst[i] = tables.low[src[i] & 0x0f] ^ tables.high[src[i] >> 4];
+    }
+}
+
+// Plain addition, which needs no tables: gf_add_region(), and multiplying by
+// one and adding. Going through memcpy'd words rather than bytes: the
+// compiler can't vectorize the byte loop, since dst and src may be the same
+// buffer.
+static void add_region_scalar(uint8_t* dst, const uint8_t* src, size_t len) {
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t a, b;
+        std::memcpy(&a, dst + i, 8);
+        std::memcpy(&b, src + i, 8);
+        a ^= b;
+        std::memcpy(dst + i, &a, 8);
+    }
+    for (; i < len; ++i)
+        dst[i] ^= src[i];
+}
+
+#if HAVE_X86_KERNELS
+
+__attribute__((target("ssse3")))
+static size_t add_region_ssse3(uint8_t* dst, const uint8_t* src, size_t len) {
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_xor_si128(x, y));
+    }
+    return i;
+}
+
+// Also used for GFNI, which has nothing to add for plain XOR.
+__attribute__((target("avx2")))
+static size_t add_region_avx2(uint8_t* dst, const uint8_t* src, size_t len) {
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_xor_si256(x, y));
+    }
+    return i;
+}
+
+__attribute__((target("ssse3")))
+static size_t mul_region_ssse3(uint8_t* dst, const uint8_t* src, size_t len, const NibbleTables& tables, bool add) {
+    const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tables.low));
+    const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tables.high));
+    const __m128i mask = _mm_set1_epi8(0x0f);
+
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i product = _mm_xor_si128(_mm_shuffle_epi8(low, _mm_and_si128(x, mask)),
+                                        _mm_shuffle_epi8(high, _mm_and_si128(_mm_srli_epi64(x, 4), mask)));
+        if (add)
+            product = _mm_xor_si128(product, _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), product);
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t mul_region_avx2(uint8_t* dst, const uint8_t* src, size_t len, const NibbleTables& tables, bool add) {
+    const __m256i low = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(tables.low)));
+    const __m256i high = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(tables.high)));
+    const __m256i mask = _mm256_set1_epi8(0x0f);
+
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        __m256i product = _mm256_xor_si256(_mm256_shuffle_epi8(low, _mm256_and_si256(x, mask)),
+                                           _mm256_shuffle_epi8(high, _mm256_and_si256(_mm256_srli_epi64(x, 4), mask)));
+        if (add)
+            product = _mm256_xor_si256(product, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), product);
+    }
+    return i;
+}
+
+// GF2P8AFFINEQB computes, for each byte x, the bit vector A * x over GF(2),
+// where row i of the 8x8 matrix A lives in byte 7 - i of a 64-bit word.
+// Column j of the matrix for multiplication by c is just c * x^j.
+static uint64_t affine_matrix_from_columns(uint64_t matrix) {
+    // Columns in bytes 0-7, transposed into rows in bytes 0-7 (Hacker's
+    // Delight, section 7-3), then reversed.
+    uint64_t t = (matrix ^ (matrix >> 7)) & 0x00aa00aa00aa00aa;
+    matrix ^= t ^ (t << 7);
+    t = (matrix ^ (matrix >> 14)) & 0x0000cccc0000cccc;
+    matrix ^= t ^ (t << 14);
+    t = (matrix ^ (matrix >> 28)) & 0x00000000f0f0f0f0;
+    matrix ^= t ^ (t << 28);
+    return __builtin_bswap64(matrix);
+}
+
+static uint64_t make_affine_matrix(uint8_t constant, uint16_t irreducible_polynomial, int characteristic) {
+    return affine_matrix_from_columns(basis_products(constant, irreducible_polynomial, characteristic));
+}
+
+__attribute__((target("gfni,avx2")))
+static size_t mul_region_gfni(uint8_t* dst, const uint8_t* src, size_t len, uint64_t matrix, bool add) {
+    const __m256i a = _mm256_set1_epi64x(static_cast<long long>(matrix));
+
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        __m256i product = _mm256_gf2p8affine_epi64_epi8(x, a, 0);
+        if (add)
+            product = _mm256_xor_si256(product, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), product);
+    }
+    return i;
+}
+
+__attribute__((target("gfni,avx2")))
+static size_t inverse_region_gfni(uint8_t* dst, const uint8_t* src, size_t len) {
+    // The identity matrix: invert, then don't transform at all.
+    const __m256i identity = _mm256_set1_epi64x(0x0102040810204080);
+
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_gf2p8affineinv_epi64_epi8(x, identity, 0));
+    }
+    return i;
+}
+
+// The gf_matrix_region() kernels: for each row, one accumulator per vector
+// of output, with every source multiplied in before it's stored. They all
+// return how far they got; the scalar kernel does the rest.
+
+__attribute__((target("ssse3")))
+static size_t matrix_region_ssse3(uint8_t* const* dst, const uint8_t* const* src, const uint8_t* nibble_tables,
+                                  size_t rows, size_t columns, size_t begin, size_t end) {
+    const __m128i mask = _mm_set1_epi8(0x0f);
+
+    size_t i = begin;
+    for (size_t r = 0; r < rows; ++r) {
+        const uint8_t* row_tables = nibble_tables + r * columns * 32;
+        for (i = begin; i + 16 <= end; i += 16) {
+            __m128i sum = _mm_setzero_si128();
+            for (size_t c = 0; c < columns; ++c) {
+                const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row_tables + 32 * c));
+                const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row_tables + 32 * c + 16));
+                __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src[c] + i));
+                sum = _mm_xor_si128(sum, _mm_shuffle_epi8(low, _mm_and_si128(x, mask)));
+                sum = _mm_xor_si128(sum, _mm_shuffle_epi8(high, _mm_and_si128(_mm_srli_epi64(x, 4), mask)));
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst[r] + i), sum);
+        }
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t matrix_region_avx2(uint8_t* const* dst, const uint8_t* const* src, const uint8_t* nibble_tables,
+                                 size_t rows, size_t columns, size_t begin, size_t end) {
+    const __m256i mask = _mm256_set1_epi8(0x0f);
+
+    size_t i = begin;
+    for (size_t r = 0; r < rows; ++r) {
+        const uint8_t* row_tables = nibble_tables + r * columns * 32;
+        for (i = begin; i + 32 <= end; i += 32) {
+            __m256i sum = _mm256_setzero_si256();
+            for (size_t c = 0; c < columns; ++c) {
+                const __m256i low = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row_tables + 32 * c)));
+                const __m256i high = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row_tables + 32 * c + 16)));
+                __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src[c] + i));
+                sum = _mm256_xor_si256(sum, _mm256_shuffle_epi8(low, _mm256_and_si256(x, mask)));
+                sum = _mm256_xor_si256(sum, _mm256_shuffle_epi8(high, _mm256_and_si256(_mm256_srli_epi64(x, 4), mask)));
+            }
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst[r] + i), sum);
+        }
+    }
+    return i;
+}
+
+__attribute__((target("gfni,avx2")))
+static size_t matrix_region_gfni(uint8_t* const* dst, const uint8_t* const* src, const uint64_t* affine_matrices,
+                                 size_t rows, size_t columns, size_t begin, size_t end) {
+    size_t i = begin;
+    for (size_t r = 0; r < rows; ++r) {
+        const uint64_t* row_matrices = affine_matrices + r * columns;
+        for (i = begin; i + 32 <= end; i += 32) {
+            __m256i sum = _mm256_setzero_si256();
+            for (size_t c = 0; c < columns; ++c) {
+                const __m256i a = _mm256_set1_epi64x(static_cast<long long>(row_matrices[c]));
+                __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src[c] + i));
+                sum = _mm256_xor_si256(sum, _mm256_gf2p8affine_epi64_epi8(x, a, 0));
+            }
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst[r] + i), sum);
+        }
+    }
+    return i;
+}
+
+#endif
+
+static void matrix_region_scalar(uint8_t* const* dst, const uint8_t* const* src, const uint8_t* nibble_tables,
+                                 size_t rows, size_t columns, size_t begin, size_t end) {
+    for (size_t r = 0; r < rows; ++r) {
+        const uint8_t* row_tables = nibble_tables + r * columns * 32;
+        for (size_t i = begin; i < end; ++i) {
+            uint8_t sum = 0;
+            for (size_t c = 0; c < columns; ++c) {
+                const uint8_t* tables = row_tables + 32 * c;
+                sum ^= tables[src[c][i] & 0x0f] ^ tables[16 + (src[c][i] >> 4)];
+            }
+            dst[r][i] = sum;
+        }
+    }
+}
+
+static RegionKernel best_region_kernel() {
+    if (region_kernel_supported(RegionKernel::GFNI))
+        return RegionKernel::GFNI;
+    if (region_kernel_supported(RegionKernel::AVX2))
+        return RegionKernel::AVX2;
+    if (region_kernel_supported(RegionKernel::SSSE3))
+        return RegionKernel::SSSE3;
+    return RegionKernel::Scalar;
+}
+
+static RegionKernel current_kernel = best_region_kernel();
+
+RegionKernel region_kernel() {
+    return current_kernel;
+}
+
+bool region_kernel_supported(RegionKernel kernel) {
+#if HAVE_X86_KERNELS
+    // Needed because we're called during static initialization.
+    __builtin_cpu_init();
+#endif
+
+    switch (kernel) {
+    case RegionKernel::Scalar:
+        return true;
+#if HAVE_X86_KERNELS
+    case RegionKernel::SSSE3:
+        return __builtin_cpu_supports("ssse3");
+    case RegionKernel::AVX2:
+        return __builtin_cpu_supports("avx2");
+    case RegionKernel::GFNI:
+        return __builtin_cpu_supports("gfni") && __builtin_cpu_supports("avx2");
+#else
+    case RegionKernel::SSSE3:
+    case RegionKernel::AVX2:
+    case RegionKernel::GFNI:
+        return false;
+#endif
+    default:
+        return false;
+    }
+}
+
+bool set_region_kernel(RegionKernel kernel) {
+    if (!region_kernel_supported(kernel))
+        return false;
+    current_kernel = kernel;
+    return true;
+}
+
+void gf_add_region(uint8_t* dst, const uint8_t* src, size_t len) {
+    size_t done = 0;
+#if HAVE_X86_KERNELS
+    switch (current_kernel) {
+    case RegionKernel::GFNI:
+    case RegionKernel::AVX2:
+        done = add_region_avx2(dst, src, len);
+        break;
+    case RegionKernel::SSSE3:
+        done = add_region_ssse3(dst, src, len);
+        break;
+    case RegionKernel::Scalar:
+    default:
+        break;
+    }
+#endif
+
+    if (done < len)
+        add_region_scalar(dst + done, src + done, len - done);
+}
+
+static void mul_region(uint8_t* dst, const uint8_t* src, uint8_t constant, size_t len,
+                       uint16_t irreducible_polynomial, int characteristic, bool add) {
+    assert(characteristic > 0);
+    assert(characteristic <= 8);
+    assert((constant >> characteristic) == 0);
+
+    // Empty regions may come with null pointers, which memset() and memcpy()
+    // don't accept even for zero lengths.
+    if (len == 0)
+        return;
+
+    // Multiplication by zero and one are common enough in practice (think
+    // sparse or identity-like matrices) to be worth skipping the tables.
+    if (constant == 0) {
+        if (!add)
+            std::memset(dst, 0, len);
+        return;
+    }
+    if (constant == 1) {
+        if (add)
+            gf_add_region(dst, src, len);
+        else if (dst != src)
+            std::memcpy(dst, src, len);
+        return;
+    }
+
+    size_t done = 0;
+#if HAVE_X86_KERNELS
+    switch (current_kernel) {
+    case RegionKernel::GFNI:
+        done = mul_region_gfni(dst, src, len, make_affine_matrix(constant, irreducible_polynomial, characteristic), add);
+        break;
+    case RegionKernel::AVX2:
+        done = mul_region_avx2(dst, src, len, make_nibble_tables(constant, irreducible_polynomial, characteristic), add);
+        break;
+    case RegionKernel::SSSE3:
+        done = mul_region_ssse3(dst, src, len, make_nibble_tables(constant, irreducible_polynomial, characteristic), add);
+        break;
+    case RegionKernel::Scalar:
+    default:
+        break;
+    }
+#endif
+
+    if (done < len)
+        mul_region_scalar(dst + done, src + done, len - done, make_nibble_tables(constant, irreducible_polynomial, characteristic), add);
+}
+
+void gf_mul_region(uint8_t* dst, const uint8_t* src, uint8_t constant, size_t len,
+                   uint16_t irreducible_polynomial, int characteristic) {
+    MULTINV_INSTRUMENT(MulRegion, irreducible_polynomial, characteristic, len);
+    mul_region(dst, src, constant, len, irreducible_polynomial, characteristic, false);
+}
+
+void gf_mul_add_region(uint8_t* dst, const uint8_t* src, uint8_t constant, size_t len,
+                       uint16_t irreducible_polynomial, int characteristic) {
+    MULTINV_INSTRUMENT(MulAddRegion, irreducible_polynomial, characteristic, len);
+    mul_region(dst, src, constant, len, irreducible_polynomial, characteristic, true);
+}
+
+RegionMatrix::RegionMatrix(const uint8_t* elements, size_t rows, size_t columns,
+                           uint16_t irreducible_polynomial, int characteristic)
+    : m_rows(rows)
+    , m_columns(columns)
+    , m_irreducible_polynomial(irreducible_polynomial)
+    , m_characteristic(characteristic)
+    , m_elements(elements, elements + rows * columns)
+    , m_nibble_tables(32 * rows * columns)
+{
+    assert(characteristic > 0);
+    assert(characteristic <= 8);
+
+#if HAVE_X86_KERNELS
+    m_affine_matrices.resize(m_elements.size());
+#endif
+
+    for (size_t i = 0; i < m_elements.size(); ++i) {
+        assert((m_elements[i] >> characteristic) == 0);
+        uint64_t products = basis_products(m_elements[i], irreducible_polynomial, characteristic);
+        nibble_table_from_columns(products, &m_nibble_tables[32 * i]);
+        nibble_table_from_columns(products >> 32, &m_nibble_tables[32 * i + 16]);
+#if HAVE_X86_KERNELS
+        m_affine_matrices[i] = affine_matrix_from_columns(products);
+#endif
+    }
+}
+
+RegionMatrix::~RegionMatrix() = default;
+
+void gf_matrix_region(uint8_t* const* dst, const uint8_t* const* src, const RegionMatrix& matrix, size_t len) {
+    MULTINV_INSTRUMENT(MatrixRegion, matrix.m_irreducible_polynomial, matrix.m_characteristic, len * matrix.m_columns);
+    size_t rows = matrix.m_rows;
+    size_t columns = matrix.m_columns;
+
+    // Small enough that the sources for one block stay in L1 while every row
+    // is computed from them.
+    size_t block = std::max<size_t>(256, std::min<size_t>(64 * 1024, (32 * 1024 / std::max<size_t>(columns, 1)) & ~size_t{31}));
+
+    for (size_t begin = 0; begin < len; begin += block) {
+        size_t end = std::min(len, begin + block);
+        size_t done = begin;
+#if HAVE_X86_KERNELS
+        switch (current_kernel) {
+        case RegionKernel::GFNI:
+            done = matrix_region_gfni(dst, src, matrix.m_affine_matrices.data(), rows, columns, begin, end);
+            break;
+        case RegionKernel::AVX2:
+            done = matrix_region_avx2(dst, src, matrix.m_nibble_tables.data(), rows, columns, begin, end);
+            break;
+        case RegionKernel::SSSE3:
+            done = matrix_region_ssse3(dst, src, matrix.m_nibble_tables.data(), rows, columns, begin, end);
+            break;
+        case RegionKernel::Scalar:
+        default:
+            break;
+        }
+#endif
+        if (done < end)
+            matrix_region_scalar(dst, src, matrix.m_nibble_tables.data(), rows, columns, done, end);
+    }
+}
+
+void gf_inverse_region(uint8_t* dst, const uint8_t* src, size_t len,
+                       uint16_t irreducible_polynomial, int characteristic) {
+    MULTINV_INSTRUMENT(InverseRegion, irreducible_polynomial, characteristic, len);
+    size_t done = 0;
+#if HAVE_X86_KERNELS
+    if (current_kernel == RegionKernel::GFNI
+        && irreducible_polynomial == Polynomial::aes_irreducible_polynomial
+        && characteristic == 8)
+        done = inverse_region_gfni(dst, src, len);
+#endif
+
+    if (done == len)
+        return;
+
+    // Not a field, so no inverses. Crash now rather than partway through.
+    const FieldTables& tables = FieldTables::require(irreducible_polynomial, characteristic);
+    for (size_t i = done; i < len; ++i)
+        dst[i] = tables.inverse(src[i]);
+}
+
+}
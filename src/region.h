@@ -0,0 +1,129 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2016 Michael Catanzaro <michael.catanzaro@mst.edu>
+ * Copyright (c) 2016 Jacob Fischer <jtf3m8@mst.edu>
+ * Copyright (c) 2016 Christian Storer <cs9yb@mst.edu>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "polynomial.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace multinv {
+
+// Bulk operations over contiguous buffers of field elements, one element per
+// byte, in the field defined by irreducible_polynomial and characteristic
+// (the same pair you would pass to Polynomial's constructor). Every element
+// must fit in characteristic bits. dst and src may be the same buffer, but
+// must not otherwise overlap.
+//
+// Calling Polynomial::operator*= once per byte is a fine way to multiply a
+// few elements, but a terrible way to multiply a few million. These use SIMD
+// kernels where the CPU has them, and always produce exactly the same result
+// as Polynomial would have.
+
+// dst[i] += src[i]. Addition is XOR in every one of these fields, so this
+// doesn't need to know which one, and isn't counted by instrumentation.
+void gf_add_region(uint8_t* dst, const uint8_t* src, size_t len);
+
+// dst[i] = constant * src[i]
+void gf_mul_region(uint8_t* dst, const uint8_t* src, uint8_t constant, size_t len,
+                   uint16_t irreducible_polynomial = Polynomial::aes_irreducible_polynomial,
+                   int characteristic = 8);
+
+// dst[i] += constant * src[i]
+void gf_mul_add_region(uint8_t* dst, const uint8_t* src, uint8_t constant, size_t len,
+                       uint16_t irreducible_polynomial = Polynomial::aes_irreducible_polynomial,
+                       int characteristic = 8);
+
+// dst[i] = multiplicative_inverse(src[i]), except that zero maps to zero
+// rather than crashing. Crashes up front if irreducible_polynomial isn't.
+void gf_inverse_region(uint8_t* dst, const uint8_t* src, size_t len,
+                       uint16_t irreducible_polynomial = Polynomial::aes_irreducible_polynomial,
+                       int characteristic = 8);
+
+// A rows x columns matrix of constants, prepared once for gf_matrix_region()
+// so that applying it to many buffers doesn't mean rebuilding the kernels'
+// tables every time. elements is in row-major order.
+class RegionMatrix {
+  public:
+    RegionMatrix(const uint8_t* elements, size_t rows, size_t columns,
+                 uint16_t irreducible_polynomial = Polynomial::aes_irreducible_polynomial,
+                 int characteristic = 8);
+    ~RegionMatrix();
+
+    size_t rows() const { return m_rows; }
+    size_t columns() const { return m_columns; }
+    uint8_t at(size_t row, size_t column) const { return m_elements[row * m_columns + column]; }
+
+  private:
+    friend void gf_matrix_region(uint8_t* const*, const uint8_t* const*, const RegionMatrix&, size_t);
+
+    size_t m_rows;
+    size_t m_columns;
+    uint16_t m_irreducible_polynomial;
+    int m_characteristic;
+    std::vector<uint8_t> m_elements;
+    // 32 bytes per element: its products with every low nibble, then every
+    // high nibble.
+    std::vector<uint8_t> m_nibble_tables;
+    // One GF2P8AFFINEQB matrix per element.
+    std::vector<uint64_t> m_affine_matrices;
+};
+
+// dst[r][i] = sum over c of matrix.at(r, c) * src[c][i], for every row r of
+// the matrix and i < len: a matrix times a vector of buffers. The buffers are
+// processed a cache-sized block at a time, so each source is read from memory
+// once no matter how many rows there are. This is the inner loop of erasure
+// coding. dst buffers must not overlap src buffers.
+void gf_matrix_region(uint8_t* const* dst, const uint8_t* const* src, const RegionMatrix& matrix, size_t len);
+
+// The implementations of the functions above. The fastest one the CPU
+// supports is selected automatically.
+enum class RegionKernel {
+    // Plain C++. Works everywhere.
+    Scalar,
+    // 16 bytes at a time, using PSHUFB to look up each half of each byte in
+    // a 16-entry table of products.
+    SSSE3,
+    // Same thing, but 32 bytes at a time.
+    AVX2,
+    // Multiplication by a constant is a linear map over GF(2), so GF2P8AFFINEQB
+    // can do it in any field in a single instruction. GF2P8AFFINEINVQB
+    // additionally provides inverses, but only in the AES field.
+    GFNI,
+};
+
+RegionKernel region_kernel();
+bool region_kernel_supported(RegionKernel);
+// Switches to a different kernel, if the CPU supports it. Mostly useful for
+// tests and benchmarks. Not thread safe.
+bool set_region_kernel(RegionKernel);
+
+}
@@ -0,0 +1,199 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2016 Michael Catanzaro <michael.catanzaro@mst.edu>
+ * Copyright (c) 2016 Jacob Fischer <jtf3m8@mst.edu>
+ * Copyright (c) 2016 Christian Storer <cs9yb@mst.edu>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "shamir.h"
+
+#include "batch-inverse.h"
+#include "field-tables.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <utility>
+
+namespace multinv {
+
+// Bytes of secret per block. Splitting needs threshold - 1 blocks of random
+// coefficients alongside each one, so this bounds its memory use.
+static const size_t block_size = 16 * 1024;
+
+// The xs have to be distinct, nonzero elements of the field.
+static std::vector<uint8_t> checked_xs(std::vector<uint8_t> xs, int characteristic) {
+    bool seen[256] = {};
+    for (uint8_t x : xs) {
+        if (x == 0 || (x >> characteristic) != 0 || seen[x])
+            std::abort();
+        seen[x] = true;
+    }
+    return xs;
+}
+
+static std::vector<uint8_t> share_numbers(size_t shares) {
+    std::vector<uint8_t> xs(shares);
+    for (size_t i = 0; i < shares; ++i)
+        xs[i] = static_cast<uint8_t>(i + 1);
+    return xs;
+}
+
+static std::vector<uint8_t> vandermonde_matrix(size_t threshold, const std::vector<uint8_t>& xs,
+                                               const FieldTables& tables) {
+    if (threshold == 0 || threshold > xs.size())
+        std::abort();
+    std::vector<uint8_t> matrix(xs.size() * threshold);
+    for (size_t i = 0; i < xs.size(); ++i) {
+        uint8_t power = 1;
+        for (size_t j = 0; j < threshold; ++j) {
+            matrix[i * threshold + j] = power;
+            power = tables.multiply(power, xs[i]);
+        }
+    }
+    return matrix;
+}
+
+// Calls body(begin, end) on blocks of [0, len), on the pool if there is one.
+template <typename Body>
+static void for_each_block(ThreadPool* pool, size_t len, Body&& body) {
+    if (pool) {
+        pool->parallel_for(len, block_size, body);
+        return;
+    }
+    for (size_t begin = 0; begin < len; begin += block_size)
+        body(begin, std::min(len, begin + block_size));
+}
+
+void system_random(uint8_t* buffer, size_t len) {
+    int fd = open("/dev/urandom", O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+        std::abort();
+    while (len > 0) {
+        ssize_t result = read(fd, buffer, len);
+        if (result <= 0) {
+            if (result < 0 && errno == EINTR)
+                continue;
+            std::abort();
+        }
+        buffer += result;
+        len -= result;
+    }
+    close(fd);
+}
+
+ShamirSplitter::ShamirSplitter(size_t threshold, size_t shares, uint16_t irreducible_polynomial, int characteristic)
+    : ShamirSplitter(threshold, share_numbers(shares), irreducible_polynomial, characteristic)
+{
+}
+
+ShamirSplitter::ShamirSplitter(size_t threshold, std::vector<uint8_t> xs,
+                               uint16_t irreducible_polynomial, int characteristic)
+    : m_threshold(threshold)
+    , m_xs(checked_xs(std::move(xs), characteristic))
+    , m_characteristic(characteristic)
+    , m_vandermonde(vandermonde_matrix(threshold, m_xs, FieldTables::require(irreducible_polynomial, characteristic)).data(),
+                    m_xs.size(), threshold, irreducible_polynomial, characteristic)
+{
+}
+
+ShamirSplitter::~ShamirSplitter() = default;
+
+void ShamirSplitter::split(const uint8_t* secret, uint8_t* const* shares, size_t len,
+                           const RandomSource& random, ThreadPool* pool) const {
+    const uint8_t mask = static_cast<uint8_t>((1u << m_characteristic) - 1);
+    for_each_block(pool, len, [&](size_t begin, size_t end) {
+        size_t block_len = end - begin;
+        // The polynomials' coefficients, one buffer per power of x: the secret
+        // itself, then fresh randomness for the rest.
+        std::vector<uint8_t> coefficients((m_threshold - 1) * block_len);
+        if (!coefficients.empty())
+            random(coefficients.data(), coefficients.size());
+        if (mask != 0xff) {
+            for (uint8_t& c : coefficients)
+                c &= mask;
+        }
+
+        std::vector<const uint8_t*> sources(m_threshold);
+        sources[0] = secret + begin;
+        for (size_t j = 1; j < m_threshold; ++j)
+            sources[j] = coefficients.data() + (j - 1) * block_len;
+        std::vector<uint8_t*> outputs(m_xs.size());
+        for (size_t i = 0; i < m_xs.size(); ++i)
+            outputs[i] = shares[i] + begin;
+        gf_matrix_region(outputs.data(), sources.data(), m_vandermonde, block_len);
+    });
+}
+
+// The Lagrange basis polynomial for x_i, evaluated at zero, is the product
+// over j != i of x_j / (x_j - x_i). Subtraction is addition, and the
+// denominators are all inverted in one batch.
+static std::vector<uint8_t> lagrange_coefficients(const std::vector<uint8_t>& xs, const FieldTables& tables) {
+    size_t count = xs.size();
+    if (count == 0)
+        std::abort();
+    std::vector<uint8_t> numerators(count, 1);
+    std::vector<uint8_t> denominators(count, 1);
+    for (size_t i = 0; i < count; ++i) {
+        for (size_t j = 0; j < count; ++j) {
+            if (j == i)
+                continue;
+            numerators[i] = tables.multiply(numerators[i], xs[j]);
+            denominators[i] = tables.multiply(denominators[i], xs[i] ^ xs[j]);
+        }
+    }
+
+    // The xs are distinct, so no denominator is zero.
+    size_t zeros = multiplicative_inverse_batch(denominators.data(), denominators.data(), count,
+                                                tables.irreducible_polynomial(), tables.characteristic());
+    if (zeros != 0)
+        std::abort();
+    for (size_t i = 0; i < count; ++i)
+        numerators[i] = tables.multiply(numerators[i], denominators[i]);
+    return numerators;
+}
+
+ShamirCombiner::ShamirCombiner(std::vector<uint8_t> xs, uint16_t irreducible_polynomial, int characteristic)
+    : m_xs(checked_xs(std::move(xs), characteristic))
+    , m_coefficients(lagrange_coefficients(m_xs, FieldTables::require(irreducible_polynomial, characteristic)))
+    , m_lagrange(m_coefficients.data(), 1, m_coefficients.size(), irreducible_polynomial, characteristic)
+{
+}
+
+ShamirCombiner::~ShamirCombiner() = default;
+
+void ShamirCombiner::combine(const uint8_t* const* shares, uint8_t* secret, size_t len, ThreadPool* pool) const {
+    for_each_block(pool, len, [&](size_t begin, size_t end) {
+        std::vector<const uint8_t*> sources(m_xs.size());
+        for (size_t i = 0; i < m_xs.size(); ++i)
+            sources[i] = shares[i] + begin;
+        uint8_t* output = secret + begin;
+        gf_matrix_region(&output, sources.data(), m_lagrange, end - begin);
+    });
+}
+
+}
@@ -0,0 +1,121 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2016 Michael Catanzaro <michael.catanzaro@mst.edu>
+ * Copyright (c) 2016 Jacob Fischer <jtf3m8@mst.edu>
+ * Copyright (c) 2016 Christian Storer <cs9yb@mst.edu>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "polynomial.h"
+#include "region.h"
+#include "thread-pool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace multinv {
+
+// Shamir secret sharing over GF(2^n), n<=8, a whole buffer at a time.
+//
+// Every element of the secret gets its own random polynomial of degree
+// threshold - 1, whose constant term is that element, and share i holds its
+// value at x_i. Any threshold shares determine the polynomial, and with it the
+// secret, by Lagrange interpolation at zero; fewer say nothing at all.
+//
+// The x_i are the same for every element, so both directions are a matrix
+// times a vector of buffers: a Vandermonde matrix applied to the secret and
+// the random coefficients to split, and one row of Lagrange coefficients
+// applied to the shares to combine. Both go through gf_matrix_region().
+// Reference: A. Shamir, "How to Share a Secret", CACM 22(11), 1979.
+
+// Fills buffer with len random bytes. Whatever you use for splitting needs to
+// be cryptographically secure, or the shares give the secret away.
+using RandomSource = std::function<void(uint8_t* buffer, size_t len)>;
+
+// The kernel's random number generator. Crashes if it can't be read.
+void system_random(uint8_t* buffer, size_t len);
+
+class ShamirSplitter {
+  public:
+    // Shares at x = 1, 2, ... shares. shares must be less than 2^characteristic,
+    // since zero is taken by the secret.
+    ShamirSplitter(size_t threshold, size_t shares,
+                   uint16_t irreducible_polynomial = Polynomial::aes_irreducible_polynomial,
+                   int characteristic = 8);
+    // Shares at the given x coordinates, which must be nonzero and distinct.
+    ShamirSplitter(size_t threshold, std::vector<uint8_t> xs,
+                   uint16_t irreducible_polynomial = Polynomial::aes_irreducible_polynomial,
+                   int characteristic = 8);
+    ~ShamirSplitter();
+
+    size_t threshold() const { return m_threshold; }
+    size_t shares() const { return m_xs.size(); }
+    const std::vector<uint8_t>& xs() const { return m_xs; }
+
+    // Writes len bytes to each of shares[0..shares()), from the len byte
+    // secret. With a pool, the secret is split a block at a time on several
+    // threads, so random has to be safe to call from all of them at once.
+    void split(const uint8_t* secret, uint8_t* const* shares, size_t len,
+               const RandomSource& random = system_random, ThreadPool* = nullptr) const;
+
+  private:
+    size_t m_threshold;
+    std::vector<uint8_t> m_xs;
+    int m_characteristic;
+    // shares() x threshold: x_i^j.
+    RegionMatrix m_vandermonde;
+};
+
+// Recovers secrets from one particular set of shares. The Lagrange
+// coefficients depend only on the x_i, so they're worked out once, up front,
+// with a single batch inversion, and every byte after that costs a
+// multiply-accumulate per share.
+class ShamirCombiner {
+  public:
+    // The x coordinates of the shares to be combined, which must be nonzero
+    // and distinct. There must be at least as many as the threshold the
+    // secret was split with, or combine() returns garbage.
+    explicit ShamirCombiner(std::vector<uint8_t> xs,
+                            uint16_t irreducible_polynomial = Polynomial::aes_irreducible_polynomial,
+                            int characteristic = 8);
+    ~ShamirCombiner();
+
+    const std::vector<uint8_t>& xs() const { return m_xs; }
+    // The Lagrange basis polynomials for the xs, evaluated at zero.
+    const std::vector<uint8_t>& coefficients() const { return m_coefficients; }
+
+    // shares[i] is the len byte share at xs()[i]. Writes the len byte secret.
+    void combine(const uint8_t* const* shares, uint8_t* secret, size_t len, ThreadPool* = nullptr) const;
+
+  private:
+    std::vector<uint8_t> m_xs;
+    std::vector<uint8_t> m_coefficients;
+    RegionMatrix m_lagrange;
+};
+
+}
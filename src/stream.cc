@@ -0,0 +1,429 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2016 Michael Catanzaro <michael.catanzaro@mst.edu>
+ * Copyright (c) 2016 Jacob Fischer <jtf3m8@mst.edu>
+ * Copyright (c) 2016 Christian Storer <cs9yb@mst.edu>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "stream.h"
+
+#include "field-tables.h"
+#include "parallel.h"
+#include "region.h"
+#include "thread-pool.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace multinv {
+
+// Elements are processed this many at a time (per thread).
+static const size_t chunk_size = 1024 * 1024;
+
+// Collects output and hands it to write() a chunk at a time, rather than
+// going through stdio one element at a time.
+class OutputBuffer {
+  public:
+    OutputBuffer(int fd, size_t capacity)
+        : m_fd(fd)
+        , m_buffer(capacity)
+        , m_used(0)
+        , m_failed(false)
+    {
+    }
+
+    // Space for at least len more bytes, flushing first if necessary.
+    uint8_t* reserve(size_t len) {
+        if (m_buffer.size() - m_used < len)
+            flush();
+        if (m_buffer.size() < len)
+            m_buffer.resize(len);
+        return m_buffer.data() + m_used;
+    }
+
+    void commit(size_t len) { m_used += len; }
+
+    bool flush() {
+        const uint8_t* data = m_buffer.data();
+        size_t remaining = m_used;
+        while (remaining > 0 && !m_failed) {
+            ssize_t written = write(m_fd, data, remaining);
+            if (written < 0) {
+                if (errno == EINTR)
+                    continue;
+                std::fprintf(stderr, "multinv: write failed: %s\n", std::strerror(errno));
+                m_failed = true;
+                break;
+            }
+            data += written;
+            remaining -= written;
+        }
+        m_used = 0;
+        return !m_failed;
+    }
+
+  private:
+    int m_fd;
+    std::vector<uint8_t> m_buffer;
+    size_t m_used;
+    bool m_failed;
+};
+
+// Applies the operation to a buffer of elements.
+class Transform {
+  public:
+    Transform(const StreamOptions& options, ThreadPool* pool)
+        : m_options(options)
+        , m_pool(pool)
+        , m_constant(0)
+        , m_table()
+    {
+    }
+
+    bool prepare() {
+        uint16_t ip = m_options.irreducible_polynomial;
+        int n = m_options.characteristic;
+        if (n < 1 || n > 8) {
+            std::fprintf(stderr, "multinv: characteristic must be between 1 and 8\n");
+            return false;
+        }
+        const FieldTables* tables = FieldTables::get(ip, n);
+        if (!tables) {
+            std::fprintf(stderr, "multinv: %x is not an irreducible polynomial of degree %d\n", ip, n);
+            return false;
+        }
+
+        if (m_options.operation != StreamOperation::Power && m_options.operation != StreamOperation::Inverse
+            && (m_options.operand >> n) != 0) {
+            std::fprintf(stderr, "multinv: operand %lx is not an element of GF(2^%d)\n", m_options.operand, n);
+            return false;
+        }
+        m_constant = static_cast<uint8_t>(m_options.operand);
+
+        switch (m_options.operation) {
+        case StreamOperation::Divide:
+            if (m_constant == 0) {
+                std::fprintf(stderr, "multinv: division by zero\n");
+                return false;
+            }
+            m_constant = tables->inverse(m_constant);
+            break;
+        case StreamOperation::Power: {
+            // The exponent can be reduced mod the order of the multiplicative
+            // group, as long as a nonzero exponent stays nonzero: 0^0 is 1 but
+            // 0^order is 0.
+            unsigned int exponent = m_options.operand % tables->order();
+            if (exponent == 0 && m_options.operand != 0)
+                exponent = tables->order();
+            // Only 2^n possible inputs, so just tabulate the answers.
+            for (unsigned int i = 0; i < (1u << n); ++i)
+                m_table[i] = tables->power(static_cast<uint8_t>(i), exponent);
+            break;
+        }
+        case StreamOperation::Inverse:
+        case StreamOperation::Multiply:
+        case StreamOperation::Add:
+        default:
+            break;
+        }
+
+        return true;
+    }
+
+    // Returns false if any input element doesn't belong to the field.
+    bool apply(uint8_t* dst, const uint8_t* src, size_t len) const {
+        uint8_t all_bits = 0;
+        for (size_t i = 0; i < len; ++i)
+            all_bits |= src[i];
+        if (all_bits >> m_options.characteristic) {
+            std::fprintf(stderr, "multinv: input contains elements that are not in GF(2^%d)\n", m_options.characteristic);
+            return false;
+        }
+
+        uint16_t ip = m_options.irreducible_polynomial;
+        int n = m_options.characteristic;
+        switch (m_options.operation) {
+        case StreamOperation::Inverse:
+            if (m_pool)
+                parallel_inverse_region(*m_pool, dst, src, len, ip, n);
+            else
+                gf_inverse_region(dst, src, len, ip, n);
+            break;
+        case StreamOperation::Multiply:
+        case StreamOperation::Divide:
+            if (m_pool)
+                parallel_mul_region(*m_pool, dst, src, m_constant, len, ip, n);
+            else
+                gf_mul_region(dst, src, m_constant, len, ip, n);
+            break;
+        case StreamOperation::Add:
+            for (size_t i = 0; i < len; ++i)
+                dst[i] = src[i] ^ m_constant;
+            break;
+        case StreamOperation::Power:
+            for (size_t i = 0; i < len; ++i)
+                dst[i] = m_table[src[i]];
+            break;
+        default:
+            break;
+        }
+        return true;
+    }
+
+  private:
+    const StreamOptions& m_options;
+    ThreadPool* m_pool;
+    uint8_t m_constant;
+    uint8_t m_table[256];
+};
+
+// Hands out the input a chunk at a time: straight out of a memory mapping for
+// regular files, or through a buffer for pipes and terminals. Either way it
+// starts from the file's current position and leaves the position after
+// whatever it handed out, the way read() would, so (head -c 2; multinv) <
+// file works the same as with a pipe.
+class InputSource {
+  public:
+    explicit InputSource(int fd)
+        : m_fd(fd)
+        , m_mapping(nullptr)
+        , m_mapping_start(0)
+        , m_mapping_size(0)
+        , m_offset(0)
+        , m_failed(false)
+    {
+        struct stat st;
+        off_t position = lseek(fd, 0, SEEK_CUR);
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && position >= 0 && position < st.st_size) {
+            // Mappings have to start on a page boundary, so start at the one
+            // before the current position and skip the slack.
+            off_t page_size = sysconf(_SC_PAGESIZE);
+            off_t start = position - position % page_size;
+            void* mapping = mmap(nullptr, st.st_size - start, PROT_READ, MAP_PRIVATE, fd, start);
+            if (mapping != MAP_FAILED) {
+                m_mapping = static_cast<const uint8_t*>(mapping);
+                m_mapping_start = start;
+                m_mapping_size = st.st_size - start;
+                m_offset = position - start;
+                madvise(mapping, m_mapping_size, MADV_SEQUENTIAL);
+            }
+        }
+    }
+
+    ~InputSource() {
+        if (m_mapping)
+            munmap(const_cast<uint8_t*>(m_mapping), m_mapping_size);
+    }
+
+    InputSource(const InputSource&) = delete;
+    InputSource& operator=(const InputSource&) = delete;
+
+    // Returns the next chunk of at most max_len bytes, or zero bytes at the
+    // end of the input or on error.
+    size_t next(size_t max_len, const uint8_t*& data) {
+        if (m_mapping) {
+            size_t len = std::min(max_len, m_mapping_size - m_offset);
+            data = m_mapping + m_offset;
+            m_offset += len;
+            lseek(m_fd, m_mapping_start + m_offset, SEEK_SET);
+            return len;
+        }
+
+        if (m_buffer.size() < max_len)
+            m_buffer.resize(max_len);
+        size_t len = 0;
+        while (len < max_len) {
+            ssize_t result = read(m_fd, m_buffer.data() + len, max_len - len);
+            if (result < 0) {
+                if (errno == EINTR)
+                    continue;
+                std::fprintf(stderr, "multinv: read failed: %s\n", std::strerror(errno));
+                m_failed = true;
+                return 0;
+            }
+            if (result == 0)
+                break;
+            len += result;
+        }
+        data = m_buffer.data();
+        return len;
+    }
+
+    bool failed() const { return m_failed; }
+
+  private:
+    int m_fd;
+    const uint8_t* m_mapping;
+    // Where the mapping starts in the file.
+    off_t m_mapping_start;
+    size_t m_mapping_size;
+    size_t m_offset;
+    std::vector<uint8_t> m_buffer;
+    bool m_failed;
+};
+
+static bool process_binary(InputSource& input, OutputBuffer& output, const Transform& transform, size_t chunk) {
+    const uint8_t* data;
+    while (size_t len = input.next(chunk, data)) {
+        uint8_t* out = output.reserve(len);
+        if (!transform.apply(out, data, len))
+            return false;
+        output.commit(len);
+    }
+    return !input.failed() && output.flush();
+}
+
+static const char hex_digits[] = "0123456789abcdef";
+
+static size_t format_hex(uint8_t* out, const uint8_t* elements, size_t count) {
+    uint8_t* start = out;
+    for (size_t i = 0; i < count; ++i) {
+        uint8_t element = elements[i];
+        if (element >> 4)
+            *out++ = hex_digits[element >> 4];
+        *out++ = hex_digits[element & 0x0f];
+        *out++ = '\n';
+    }
+    return out - start;
+}
+
+static int hex_value(uint8_t c) {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+static bool process_hex(InputSource& input, OutputBuffer& output, const Transform& transform, size_t chunk) {
+    std::vector<uint8_t> elements;
+    elements.reserve(chunk);
+    std::vector<uint8_t> results(chunk);
+
+    auto flush_elements = [&] {
+        if (!transform.apply(results.data(), elements.data(), elements.size()))
+            return false;
+        // Three bytes per element at most: two digits and a newline.
+        uint8_t* out = output.reserve(3 * elements.size());
+        output.commit(format_hex(out, results.data(), elements.size()));
+        elements.clear();
+        return true;
+    };
+
+    // A number can straddle two chunks, so the parser state lives out here.
+    unsigned int value = 0;
+    int digits = 0;
+    bool prefixed = false;
+
+    const uint8_t* data;
+    while (size_t len = input.next(chunk, data)) {
+        for (size_t i = 0; i < len; ++i) {
+            uint8_t c = data[i];
+            int digit = hex_value(c);
+            if (digit >= 0) {
+                value = value * 16 + digit;
+                if (value > 0xff) {
+                    std::fprintf(stderr, "multinv: input contains a number larger than ff\n");
+                    return false;
+                }
+                ++digits;
+                continue;
+            }
+
+            // Allow an optional 0x prefix.
+            if ((c == 'x' || c == 'X') && digits == 1 && value == 0 && !prefixed) {
+                prefixed = true;
+                digits = 0;
+                continue;
+            }
+
+            if (c != ' ' && c != '\n' && c != '\t' && c != '\r' && c != ',') {
+                std::fprintf(stderr, "multinv: unexpected character '%c' in input\n", c);
+                return false;
+            }
+            if (prefixed && !digits) {
+                std::fprintf(stderr, "multinv: expected hexadecimal digits after 0x\n");
+                return false;
+            }
+
+            if (digits) {
+                elements.push_back(static_cast<uint8_t>(value));
+                value = 0;
+                digits = 0;
+                prefixed = false;
+                if (elements.size() == chunk && !flush_elements())
+                    return false;
+            }
+        }
+    }
+    if (input.failed())
+        return false;
+
+    if (prefixed && !digits) {
+        std::fprintf(stderr, "multinv: expected hexadecimal digits after 0x\n");
+        return false;
+    }
+    if (digits)
+        elements.push_back(static_cast<uint8_t>(value));
+    if (!elements.empty() && !flush_elements())
+        return false;
+
+    return output.flush();
+}
+
+bool process_stream(int input_fd, int output_fd, const StreamOptions& options) {
+    std::unique_ptr<ThreadPool> pool;
+    if (options.threads > 1)
+        pool.reset(new ThreadPool(options.threads));
+    size_t chunk = chunk_size * std::max(1u, options.threads);
+
+    Transform transform(options, pool.get());
+    if (!transform.prepare())
+        return false;
+
+    InputSource input(input_fd);
+    OutputBuffer output(output_fd, options.format == StreamFormat::Hex ? 3 * chunk : chunk);
+
+    switch (options.format) {
+    case StreamFormat::Binary:
+        return process_binary(input, output, transform, chunk);
+    case StreamFormat::Hex:
+        return process_hex(input, output, transform, chunk);
+    default:
+        return false;
+    }
+}
+
+}
@@ -0,0 +1,71 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2016 Michael Catanzaro <michael.catanzaro@mst.edu>
+ * Copyright (c) 2016 Jacob Fischer <jtf3m8@mst.edu>
+ * Copyright (c) 2016 Christian Storer <cs9yb@mst.edu>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "polynomial.h"
+
+#include <cstdint>
+
+namespace multinv {
+
+enum class StreamOperation {
+    Inverse,
+    Multiply,
+    Add,
+    Divide,
+    Power,
+};
+
+enum class StreamFormat {
+    // One element per byte.
+    Binary,
+    // Whitespace-separated hexadecimal numbers on input, one per line on
+    // output.
+    Hex,
+};
+
+struct StreamOptions {
+    uint16_t irreducible_polynomial = Polynomial::aes_irreducible_polynomial;
+    int characteristic = 8;
+    StreamOperation operation = StreamOperation::Inverse;
+    // The other operand of Multiply, Add and Divide, or the exponent for Power.
+    unsigned long operand = 0;
+    StreamFormat format = StreamFormat::Binary;
+    // Threads to process each chunk with. One means don't bother.
+    unsigned int threads = 1;
+};
+
+// Reads field elements from input_fd, applies the operation to each of them,
+// and writes the results to output_fd, a large chunk at a time. Regular files
+// are mapped into memory rather than read. On failure, prints an error message
+// to stderr and returns false.
+bool process_stream(int input_fd, int output_fd, const StreamOptions&);
+
+}
@@ -0,0 +1,173 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2016 Michael Catanzaro <michael.catanzaro@mst.edu>
+ * Copyright (c) 2016 Jacob Fischer <jtf3m8@mst.edu>
+ * Copyright (c) 2016 Christian Storer <cs9yb@mst.edu>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "thread-pool.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace multinv {
+
+struct ThreadPool::Job {
+    const std::function<void(size_t, size_t)>* body;
+
+    // Protected by mutex, which also keeps the Job alive until the last
+    // chunk has finished touching it.
+    std::mutex mutex;
+    std::condition_variable done;
+    size_t remaining_chunks;
+};
+
+ThreadPool::ThreadPool(unsigned int threads)
+    : m_queued_chunks(0)
+    , m_stopping(false)
+{
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (unsigned int i = 0; i < threads; ++i)
+        m_queues.emplace_back(new Queue);
+    for (unsigned int i = 1; i < threads; ++i)
+        m_workers.emplace_back(&ThreadPool::worker_main, this, i - 1);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+
+    for (std::thread& worker : m_workers)
+        worker.join();
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool* pool = [] {
+        unsigned int threads = 0;
+        if (const char* env = std::getenv("MULTINV_THREADS"))
+            threads = static_cast<unsigned int>(std::strtoul(env, nullptr, 10));
+        return new ThreadPool(threads);
+    }();
+    return *pool;
+}
+
+bool ThreadPool::take_chunk(size_t preferred_queue, Chunk& chunk) {
+    {
+        Queue& queue = *m_queues[preferred_queue];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.chunks.empty()) {
+            chunk = queue.chunks.back();
+            queue.chunks.pop_back();
+            return true;
+        }
+    }
+
+    for (size_t i = 1; i < m_queues.size(); ++i) {
+        Queue& victim = *m_queues[(preferred_queue + i) % m_queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.chunks.empty()) {
+            chunk = victim.chunks.front();
+            victim.chunks.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::run_chunk(const Chunk& chunk) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        --m_queued_chunks;
+    }
+
+    (*chunk.job->body)(chunk.begin, chunk.end);
+
+    std::lock_guard<std::mutex> lock(chunk.job->mutex);
+    if (--chunk.job->remaining_chunks == 0)
+        chunk.job->done.notify_all();
+}
+
+void ThreadPool::worker_main(size_t index) {
+    while (true) {
+        Chunk chunk;
+        if (take_chunk(index, chunk)) {
+            run_chunk(chunk);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_wake.wait(lock, [this] { return m_stopping || m_queued_chunks > 0; });
+        if (m_stopping)
+            return;
+    }
+}
+
+void ThreadPool::parallel_for(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body) {
+    if (grain == 0)
+        grain = 1;
+    if (count <= grain || m_workers.empty()) {
+        for (size_t begin = 0; begin < count; begin += grain)
+            body(begin, std::min(count, begin + grain));
+        return;
+    }
+
+    Job job;
+    job.body = &body;
+    job.remaining_chunks = (count + grain - 1) / grain;
+
+    // Deal the chunks out round-robin. The last queue belongs to whoever
+    // isn't a worker, which is usually us.
+    size_t chunks = job.remaining_chunks;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queued_chunks += chunks;
+    }
+    for (size_t i = 0; i < chunks; ++i) {
+        size_t begin = i * grain;
+        size_t end = std::min(count, begin + grain);
+        Queue& queue = *m_queues[i % m_queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.chunks.push_back({ &job, begin, end });
+    }
+    m_wake.notify_all();
+
+    // Help out until there's nothing left to take, then wait for the
+    // stragglers.
+    const size_t our_queue = m_queues.size() - 1;
+    Chunk chunk;
+    while (take_chunk(our_queue, chunk))
+        run_chunk(chunk);
+
+    std::unique_lock<std::mutex> lock(job.mutex);
+    job.done.wait(lock, [&job] { return job.remaining_chunks == 0; });
+}
+
+}
@@ -0,0 +1,102 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2016 Michael Catanzaro <michael.catanzaro@mst.edu>
+ * Copyright (c) 2016 Jacob Fischer <jtf3m8@mst.edu>
+ * Copyright (c) 2016 Christian Storer <cs9yb@mst.edu>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace multinv {
+
+// A fixed set of worker threads that split up loops for us.
+//
+// Each worker has its own queue of chunks. Workers take chunks from the back
+// of their own queue, and when that runs dry they steal from the front of
+// everybody else's, so a worker stuck with slow chunks doesn't hold up the
+// whole loop. The thread calling parallel_for() pitches in too, so it's safe
+// to call parallel_for() from inside a chunk.
+class ThreadPool {
+  public:
+    // threads counts the calling thread, so ThreadPool{1} starts no workers
+    // and runs everything inline. Zero means one thread per CPU.
+    explicit ThreadPool(unsigned int threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // The number of threads that can work on a loop at once, including the
+    // calling thread.
+    unsigned int size() const { return static_cast<unsigned int>(m_workers.size() + 1); }
+
+    // Calls body(begin, end) on disjoint ranges covering [0, count), each at
+    // most grain long, and returns once all of them have finished. Loops that
+    // fit in one grain run inline without touching the other threads.
+    void parallel_for(size_t count, size_t grain, const std::function<void(size_t begin, size_t end)>& body);
+
+    // A pool shared by everybody who doesn't care to make their own. Its size
+    // comes from the MULTINV_THREADS environment variable, if set, or else
+    // the number of CPUs.
+    static ThreadPool& shared();
+
+  private:
+    struct Job;
+
+    struct Chunk {
+        Job* job;
+        size_t begin;
+        size_t end;
+    };
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Chunk> chunks;
+    };
+
+    void worker_main(size_t index);
+    bool take_chunk(size_t preferred_queue, Chunk&);
+    void run_chunk(const Chunk&);
+
+    std::vector<std::thread> m_workers;
+    // One per worker, plus one for threads that aren't workers.
+    std::vector<std::unique_ptr<Queue>> m_queues;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    size_t m_queued_chunks;
+    bool m_stopping;
+};
+
+}
@@ -0,0 +1,278 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2016 Michael Catanzaro <michael.catanzaro@mst.edu>
+ * Copyright (c) 2016 Jacob Fischer <jtf3m8@mst.edu>
+ * Copyright (c) 2016 Christian Storer <cs9yb@mst.edu>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "wide-polynomial.h"
+
+#include <cstdlib>
+
+#if defined(__x86_64__)
+#define HAVE_PCLMULQDQ 1
+#include <immintrin.h>
+#else
+#define HAVE_PCLMULQDQ 0
+#endif
+
+namespace multinv {
+
+template class WidePolynomial<uint16_t>;
+template class WidePolynomial<uint32_t>;
+template class WidePolynomial<uint64_t>;
+template class WidePolynomial<uint128_t>;
+
+// 64x64 -> 128 bit carry-less multiplication, one bit at a time.
+struct PortableClmul {
+    static uint128_t multiply(uint64_t a, uint64_t b) {
+        uint128_t result = 0;
+        uint128_t shifted = a;
+        for (; b != 0; b >>= 1, shifted <<= 1) {
+            if (b & 1)
+                result ^= shifted;
+        }
+        return result;
+    }
+};
+
+#if HAVE_PCLMULQDQ
+struct HardwareClmul {
+    __attribute__((target("pclmul")))
+    static uint128_t multiply(uint64_t a, uint64_t b) {
+        __m128i product = _mm_clmulepi64_si128(_mm_cvtsi64_si128(static_cast<long long>(a)),
+                                               _mm_cvtsi64_si128(static_cast<long long>(b)), 0);
+        uint64_t low = static_cast<uint64_t>(_mm_cvtsi128_si64(product));
+        uint64_t high = static_cast<uint64_t>(_mm_cvtsi128_si64(_mm_unpackhi_epi64(product, product)));
+        return (static_cast<uint128_t>(high) << 64) | low;
+    }
+};
+#endif
+
+// The full double-width product of two words, split into high and low words.
+template <typename Clmul, typename Word>
+static void clmul(Word a, Word b, Word& high, Word& low) {
+    // Fits in 128 bits (or fewer) without any help.
+    uint128_t product = Clmul::multiply(a, b);
+    low = static_cast<Word>(product);
+    high = static_cast<Word>(product >> WidePolynomial<Word>::characteristic());
+}
+
+template <typename Clmul>
+static void clmul(uint128_t a, uint128_t b, uint128_t& high, uint128_t& low) {
+    // Karatsuba: three 64-bit multiplications rather than four.
+    uint64_t a0 = static_cast<uint64_t>(a);
+    uint64_t a1 = static_cast<uint64_t>(a >> 64);
+    uint64_t b0 = static_cast<uint64_t>(b);
+    uint64_t b1 = static_cast<uint64_t>(b >> 64);
+
+    uint128_t low_product = Clmul::multiply(a0, b0);
+    uint128_t high_product = Clmul::multiply(a1, b1);
+    uint128_t middle = Clmul::multiply(a0 ^ a1, b0 ^ b1) ^ low_product ^ high_product;
+
+    low = low_product ^ (middle << 64);
+    high = high_product ^ (middle >> 64);
+}
+
+// floor(x^2n / P) without its leading x^n term, where P = x^n +
+// irreducible_polynomial. This is ordinary long division, one quotient bit at
+// a time, keeping only the n bits of the remainder that can still matter.
+template <typename Word>
+static Word compute_barrett_constant(Word irreducible_polynomial) {
+    const Word top_bit = Word{1} << (WidePolynomial<Word>::characteristic() - 1);
+    Word remainder = irreducible_polynomial;
+    Word quotient = 0;
+    for (int i = WidePolynomial<Word>::characteristic() - 1; i >= 0; --i) {
+        bool bit = remainder & top_bit;
+        remainder <<= 1;
+        if (bit) {
+            quotient |= Word{1} << i;
+            remainder ^= irreducible_polynomial;
+        }
+    }
+    return quotient;
+}
+
+template <typename Word>
+static Word barrett_constant(Word irreducible_polynomial) {
+    // Almost everybody uses one field at a time, so one entry is plenty.
+    static thread_local Word cached_polynomial = 0;
+    static thread_local Word cached_constant = 0;
+    if (cached_polynomial != irreducible_polynomial || cached_polynomial == 0) {
+        cached_constant = compute_barrett_constant(irreducible_polynomial);
+        cached_polynomial = irreducible_polynomial;
+    }
+    return cached_constant;
+}
+
+// The product is high * x^n + low, and we need it modulo P = x^n +
+// irreducible_polynomial.
+template <typename Clmul, typename Word>
+static Word multiply(Word a, Word b, Word irreducible_polynomial) {
+    const int n = WidePolynomial<Word>::characteristic();
+
+    Word high;
+    Word low;
+    clmul<Clmul>(a, b, high, low);
+
+    if ((irreducible_polynomial >> (n / 2)) == 0) {
+        // x^n == irreducible_polynomial, so high * x^n == high *
+        // irreducible_polynomial, whose own high word has degree less than
+        // that of irreducible_polynomial. Since that's less than n/2, folding
+        // the high word down a second time leaves nothing left over, and
+        // often the first fold is enough. All the default polynomials except
+        // the 16-bit one qualify.
+        while (high != 0) {
+            Word folded_high;
+            Word folded_low;
+            clmul<Clmul>(high, irreducible_polynomial, folded_high, folded_low);
+            low ^= folded_low;
+            high = folded_high;
+        }
+        return low;
+    }
+
+    // Otherwise, Barrett reduction: the quotient of the product by P is
+    // exactly high + floor(high * barrett_constant / x^n) in GF(2)[x], and
+    // the remainder is low - (quotient * P mod x^n). Always two more
+    // multiplications, no matter what P looks like.
+    Word quotient_high;
+    Word unused;
+    clmul<Clmul>(high, barrett_constant(irreducible_polynomial), quotient_high, unused);
+    Word quotient = high ^ quotient_high;
+
+    Word product_low;
+    clmul<Clmul>(quotient, irreducible_polynomial, unused, product_low);
+    return low ^ product_low;
+}
+
+#if HAVE_PCLMULQDQ
+// flatten, so HardwareClmul::multiply is inlined all the way down despite
+// its target attribute.
+template <typename Word>
+__attribute__((target("pclmul"), flatten))
+static Word multiply_pclmulqdq(Word a, Word b, Word irreducible_polynomial) {
+    return multiply<HardwareClmul>(a, b, irreducible_polynomial);
+}
+
+__attribute__((target("pclmul"), flatten))
+static uint128_t clmul_pclmulqdq(uint64_t a, uint64_t b) {
+    return HardwareClmul::multiply(a, b);
+}
+#endif
+
+static ClmulKernel best_clmul_kernel() {
+    if (clmul_kernel_supported(ClmulKernel::PCLMULQDQ))
+        return ClmulKernel::PCLMULQDQ;
+    return ClmulKernel::Portable;
+}
+
+static ClmulKernel current_kernel = best_clmul_kernel();
+
+ClmulKernel clmul_kernel() {
+    return current_kernel;
+}
+
+bool clmul_kernel_supported(ClmulKernel kernel) {
+#if HAVE_PCLMULQDQ
+    // Needed because we're called during static initialization.
+    __builtin_cpu_init();
+#endif
+
+    switch (kernel) {
+    case ClmulKernel::Portable:
+        return true;
+    case ClmulKernel::PCLMULQDQ:
+#if HAVE_PCLMULQDQ
+        return __builtin_cpu_supports("pclmul");
+#else
+        return false;
+#endif
+    default:
+        return false;
+    }
+}
+
+bool set_clmul_kernel(ClmulKernel kernel) {
+    if (!clmul_kernel_supported(kernel))
+        return false;
+    current_kernel = kernel;
+    return true;
+}
+
+uint128_t carryless_multiply(uint64_t a, uint64_t b) {
+#if HAVE_PCLMULQDQ
+    if (current_kernel == ClmulKernel::PCLMULQDQ)
+        return clmul_pclmulqdq(a, b);
+#endif
+    return PortableClmul::multiply(a, b);
+}
+
+template <typename Word>
+WidePolynomial<Word>& WidePolynomial<Word>::operator*=(const WidePolynomial& rhs) {
+#if HAVE_PCLMULQDQ
+    if (current_kernel == ClmulKernel::PCLMULQDQ) {
+        m_value = multiply_pclmulqdq(m_value, rhs.m_value, m_irreducible_polynomial);
+        return *this;
+    }
+#endif
+    m_value = multiply<PortableClmul>(m_value, rhs.m_value, m_irreducible_polynomial);
+    return *this;
+}
+
+// Same as inverse_itoh_tsujii() in polynomial.cc: with b_k = a^(2^k - 1),
+// b_(j+k) = b_j^(2^k) * b_k and a^-1 = b_(n-1)^2.
+template <typename Word>
+WidePolynomial<Word> multiplicative_inverse(const WidePolynomial<Word>& p) {
+    if (p.value() == 0)
+        std::abort();
+
+    const int m = WidePolynomial<Word>::characteristic() - 1;
+    WidePolynomial<Word> b = p;
+    int k = 1;
+    int top = 31 - __builtin_clz(m);
+    for (int bit = top - 1; bit >= 0; --bit) {
+        WidePolynomial<Word> t = b;
+        for (int i = 0; i < k; ++i)
+            t *= t;
+        b *= t;
+        k *= 2;
+
+        if (m & (1 << bit)) {
+            b *= b;
+            b *= p;
+            ++k;
+        }
+    }
+
+    return b * b;
+}
+
+template WidePolynomial<uint16_t> multiplicative_inverse(const WidePolynomial<uint16_t>&);
+template WidePolynomial<uint32_t> multiplicative_inverse(const WidePolynomial<uint32_t>&);
+template WidePolynomial<uint64_t> multiplicative_inverse(const WidePolynomial<uint64_t>&);
+template WidePolynomial<uint128_t> multiplicative_inverse(const WidePolynomial<uint128_t>&);
+
+}
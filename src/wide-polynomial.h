@@ -0,0 +1,182 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ *
+ * Copyright (c) 2016 Michael Catanzaro <michael.catanzaro@mst.edu>
+ * Copyright (c) 2016 Jacob Fischer <jtf3m8@mst.edu>
+ * Copyright (c) 2016 Christian Storer <cs9yb@mst.edu>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace multinv {
+
+__extension__ typedef unsigned __int128 uint128_t;
+
+// Default irreducible polynomials for each width, with the leading x^n term
+// (which doesn't fit in an n-bit word) left implicit. All are from Seroussi's
+// table of low-weight irreducible polynomials, and the 128-bit one is GHASH's.
+template <typename Word> struct WideField;
+template <> struct WideField<uint16_t> {
+    // x^16 + x^12 + x^3 + x + 1
+    static constexpr uint16_t default_irreducible_polynomial = 0x100b;
+};
+template <> struct WideField<uint32_t> {
+    // x^32 + x^7 + x^3 + x^2 + 1
+    static constexpr uint32_t default_irreducible_polynomial = 0x8d;
+};
+template <> struct WideField<uint64_t> {
+    // x^64 + x^4 + x^3 + x + 1
+    static constexpr uint64_t default_irreducible_polynomial = 0x1b;
+};
+template <> struct WideField<uint128_t> {
+    // x^128 + x^7 + x^2 + x + 1
+    static constexpr uint128_t default_irreducible_polynomial = 0x87;
+};
+
+// Represents a polynomial in a finite field GF(2^n), where n is the number of
+// bits in Word: 16, 32, 64 or 128.
+//
+// Polynomial stops at GF(2^8), where everything fits in a table. Past that we
+// multiply the hard way: a carry-less multiplication (PCLMULQDQ, if we've got
+// it) followed by folding the high half of the product back down using
+// x^n == irreducible_polynomial.
+template <typename Word>
+class WidePolynomial {
+  public:
+    // irreducible_polynomial excludes the leading x^n term, so it must be
+    // irreducible once x^n is added back.
+    explicit WidePolynomial(Word value,
+                            Word irreducible_polynomial = WideField<Word>::default_irreducible_polynomial)
+        : m_value(value)
+        , m_irreducible_polynomial(irreducible_polynomial)
+    {
+    }
+
+    // The bit representation of this polynomial.
+    Word value() const { return m_value; }
+    // The irreducible polynomial that defines the field this polynomial
+    // exists in, without its leading term.
+    Word irreducible_polynomial() const { return m_irreducible_polynomial; }
+    // The n in GF(2^n).
+    static constexpr int characteristic() { return sizeof(Word) * 8; }
+
+    WidePolynomial& operator+=(const WidePolynomial& rhs) {
+        m_value ^= rhs.m_value;
+        return *this;
+    }
+
+    WidePolynomial& operator-=(const WidePolynomial& rhs) {
+        return *this += rhs;
+    }
+
+    WidePolynomial& operator*=(const WidePolynomial&);
+
+  private:
+    Word m_value;
+    Word m_irreducible_polynomial;
+};
+
+using Polynomial16 = WidePolynomial<uint16_t>;
+using Polynomial32 = WidePolynomial<uint32_t>;
+using Polynomial64 = WidePolynomial<uint64_t>;
+using Polynomial128 = WidePolynomial<uint128_t>;
+
+extern template class WidePolynomial<uint16_t>;
+extern template class WidePolynomial<uint32_t>;
+extern template class WidePolynomial<uint64_t>;
+extern template class WidePolynomial<uint128_t>;
+
+// Computed with the Itoh-Tsujii algorithm. Zero has no inverse; don't ask.
+template <typename Word>
+WidePolynomial<Word> multiplicative_inverse(const WidePolynomial<Word>&);
+
+template <typename Word>
+WidePolynomial<Word> operator+(WidePolynomial<Word> lhs, const WidePolynomial<Word>& rhs) {
+    lhs += rhs;
+    return lhs;
+}
+
+template <typename Word>
+WidePolynomial<Word> operator-(WidePolynomial<Word> lhs, const WidePolynomial<Word>& rhs) {
+    lhs -= rhs;
+    return lhs;
+}
+
+template <typename Word>
+WidePolynomial<Word> operator*(WidePolynomial<Word> lhs, const WidePolynomial<Word>& rhs) {
+    lhs *= rhs;
+    return lhs;
+}
+
+template <typename Word>
+bool operator==(const WidePolynomial<Word>& lhs, const WidePolynomial<Word>& rhs) {
+    return lhs.value() == rhs.value();
+}
+
+template <typename Word>
+bool operator!=(const WidePolynomial<Word>& lhs, const WidePolynomial<Word>& rhs) {
+    return !(lhs == rhs);
+}
+
+template <typename Word>
+bool operator<(const WidePolynomial<Word>& lhs, const WidePolynomial<Word>& rhs) {
+    return lhs.value() < rhs.value();
+}
+
+template <typename Word>
+bool operator>(const WidePolynomial<Word>& lhs, const WidePolynomial<Word>& rhs) {
+    return rhs < lhs;
+}
+
+template <typename Word>
+bool operator<=(const WidePolynomial<Word>& lhs, const WidePolynomial<Word>& rhs) {
+    return !(lhs > rhs);
+}
+
+template <typename Word>
+bool operator>=(const WidePolynomial<Word>& lhs, const WidePolynomial<Word>& rhs) {
+    return !(lhs < rhs);
+}
+
+// The carry-less multiplication used by WidePolynomial. Like RegionKernel,
+// the fastest supported one is selected automatically.
+enum class ClmulKernel {
+    // Shift and XOR, one bit at a time.
+    Portable,
+    // 64x64 -> 128 bit carry-less multiplication in one instruction.
+    PCLMULQDQ,
+};
+
+ClmulKernel clmul_kernel();
+bool clmul_kernel_supported(ClmulKernel);
+// Not thread safe.
+bool set_clmul_kernel(ClmulKernel);
+
+// The full 128-bit carry-less product of a and b, using clmul_kernel(). For
+// arithmetic modulo polynomials WidePolynomial doesn't handle.
+uint128_t carryless_multiply(uint64_t a, uint64_t b);
+
+}
@@ -0,0 +1,53 @@
+#!/bin/sh
+# Tests for the src/multinv command line itself: option handling, and
+# standard input that is a regular file already partly read by somebody
+# else. multinv maps such files rather than reading them, and has to pick up
+# where the file position says, not from the start.
+#
+# Run by make check, with MULTINV set to the multinv binary.
+
+set -e
+
+: "${MULTINV:=../src/multinv}"
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+fail() {
+    echo "FAIL: $1" >&2
+    exit 1
+}
+
+# --stats on its own, however many times, still means the homework answers;
+# anything else means streaming, which needs --operation.
+"$MULTINV" --stats -s > "$tmp/out" 2> /dev/null || fail "--stats -s"
+grep -q "^Homework" "$tmp/out" || fail "no homework answers for --stats -s"
+if "$MULTINV" -s -n 8 > /dev/null 2>&1; then
+    fail "-s -n 8 without --operation"
+fi
+
+# Four bytes, two of them already consumed.
+printf '\001\002\003\004' > "$tmp/small"
+(dd bs=1 count=2 of=/dev/null 2>/dev/null; "$MULTINV" --operation=inv) < "$tmp/small" > "$tmp/out"
+tail -c 2 "$tmp/small" | "$MULTINV" --operation=inv > "$tmp/expected"
+cmp -s "$tmp/out" "$tmp/expected" || fail "stdin at offset 2"
+
+# Past the first page, at an offset that isn't a multiple of the page size.
+i=0
+while [ $i -lt 100 ]; do
+    printf '0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ!@#$%%^&*()_+-=[]{};:,.<>/?|~` \t\n' >> "$tmp/large"
+    i=$((i + 1))
+done
+(dd bs=5001 count=1 of=/dev/null 2>/dev/null; "$MULTINV" --operation=inv) < "$tmp/large" > "$tmp/out"
+tail -c +5002 "$tmp/large" | "$MULTINV" --operation=inv > "$tmp/expected"
+test -s "$tmp/expected" || fail "no output for the large file"
+cmp -s "$tmp/out" "$tmp/expected" || fail "stdin at offset 5001"
+
+# And it leaves the position at the end, like reading would have.
+(dd bs=1 count=1 of=/dev/null 2>/dev/null; "$MULTINV" --operation=inv > /dev/null; cat) < "$tmp/small" > "$tmp/out"
+test ! -s "$tmp/out" || fail "position not left at the end of the input"
+
+# At the very end already, there's nothing to do.
+(cat > /dev/null; "$MULTINV" --operation=inv) < "$tmp/small" > "$tmp/out"
+test ! -s "$tmp/out" || fail "stdin at end of file"
+
+exit 0
@@ -29,8 +29,34 @@
 
 #include "polynomial.h"
 
+#include "aes-sbox.h"
+#include "batch-inverse.h"
+#include "crc.h"
+#include "factor.h"
+#include "field-matrix.h"
+#include "field-polynomial.h"
+#include "field-tables.h"
+#include "field-vector.h"
+#include "gf.h"
+#include "instrumentation.h"
+#include "irreducible.h"
+#include "parallel.h"
+#include "reed-solomon.h"
+#include "region.h"
+#include "shamir.h"
+#include "thread-pool.h"
+#include "wide-polynomial.h"
+
 #include <glib.h>
+#include <algorithm>
+#include <atomic>
+#include <fcntl.h>
 #include <locale.h>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <unistd.h>
+#include <vector>
 
 using namespace multinv;
 
@@ -184,6 +210,1663 @@ static void multiplication_table() {
     g_assert_cmpuint((Polynomial{0b111, ip, 3} * Polynomial{0b111, ip, 3}).value(), ==, 0b011);
 }
 
+static void inverse1() {
+    // https://en.wikipedia.org/wiki/Finite_field_arithmetic#Rijndael.27s_finite_field
+    Polynomial p1{0x53};
+
+    g_assert_cmpuint(multiplicative_inverse(p1, InverseStrategy::Table).value(), ==, 0xca);
+    g_assert_cmpuint(multiplicative_inverse(p1, InverseStrategy::BruteForce).value(), ==, 0xca);
+    g_assert_cmpuint(multiplicative_inverse(p1, InverseStrategy::ExtendedEuclid).value(), ==, 0xca);
+    g_assert_cmpuint(multiplicative_inverse(p1, InverseStrategy::ItohTsujii).value(), ==, 0xca);
+}
+
+static void inverse2() {
+    // Stinson example 6.6
+    uint8_t ip = 0b1011;
+    Polynomial p1{0b010, ip, 3};
+    Polynomial p2{0b111, ip, 3};
+
+    g_assert_cmpuint(multiplicative_inverse(p1).value(), ==, 0b101);
+    g_assert_cmpuint(multiplicative_inverse(p2).value(), ==, 0b100);
+}
+
+// One irreducible polynomial for each characteristic we support.
+static const uint16_t irreducible_polynomials[] = {
+    0, 0b11, 0b111, 0b1011, 0b10011, 0b100101, 0b1000011, 0b10000011, 0b100011011
+};
+
+static void inverse_strategies() {
+    // Every strategy must agree with every other strategy on every element of
+    // every field.
+    for (int n = 1; n <= 8; ++n) {
+        uint16_t ip = irreducible_polynomials[n];
+        for (unsigned int i = 1; i < (1u << n); ++i) {
+            Polynomial p{static_cast<uint8_t>(i), ip, n};
+            Polynomial r = multiplicative_inverse(p, InverseStrategy::BruteForce);
+
+            g_assert_cmpuint((p * r).value(), ==, 1);
+            g_assert_cmpuint(multiplicative_inverse(p, InverseStrategy::Table).value(), ==, r.value());
+            g_assert_cmpuint(multiplicative_inverse(p, InverseStrategy::ExtendedEuclid).value(), ==, r.value());
+            g_assert_cmpuint(multiplicative_inverse(p, InverseStrategy::ItohTsujii).value(), ==, r.value());
+            g_assert_cmpuint(multiplicative_inverse(p, InverseStrategy::ConstantTime).value(), ==, r.value());
+        }
+    }
+}
+
+static void multiply_constant_time_matches_bitwise() {
+    for (int n = 1; n <= 8; ++n) {
+        uint16_t ip = irreducible_polynomials[n];
+        for (unsigned int a = 0; a < (1u << n); ++a) {
+            for (unsigned int b = 0; b < (1u << n); ++b)
+                g_assert_cmpuint(multiply_constant_time(a, b, ip, n), ==, multiply_bitwise(a, b, ip, n));
+        }
+
+        Polynomial p{static_cast<uint8_t>((1u << n) - 1), ip, n};
+        g_assert_cmpuint(multiply_constant_time(p, p).value(), ==, (p * p).value());
+    }
+}
+
+static void inverse_constant_time_zero() {
+    // Zero comes out as zero, rather than crashing.
+    for (int n = 1; n <= 8; ++n) {
+        Polynomial zero{0, irreducible_polynomials[n], n};
+        g_assert_cmpuint(multiplicative_inverse(zero, InverseStrategy::ConstantTime).value(), ==, 0);
+    }
+}
+
+static void divide() {
+    // Stinson example 6.6 again: 1/010 is 101, so 111/010 is 111 * 101.
+    g_assert_cmpuint((Polynomial{0b111, 0b1011, 3} / Polynomial{0b010, 0b1011, 3}).value(), ==, 0b110);
+
+    for (int n = 1; n <= 8; ++n) {
+        uint16_t ip = irreducible_polynomials[n];
+        for (unsigned int b = 1; b < (1u << n); ++b) {
+            Polynomial q{static_cast<uint8_t>(b), ip, n};
+            Polynomial inverse = multiplicative_inverse(q, InverseStrategy::BruteForce);
+            for (unsigned int a = 0; a < (1u << n); ++a) {
+                Polynomial p{static_cast<uint8_t>(a), ip, n};
+                Polynomial quotient = p / q;
+                g_assert_cmpuint(quotient.value(), ==, (p * inverse).value());
+
+                p /= q;
+                g_assert_cmpuint(p.value(), ==, quotient.value());
+            }
+        }
+    }
+}
+
+static void pow_square_sqrt() {
+    for (int n = 1; n <= 8; ++n) {
+        uint16_t ip = irreducible_polynomials[n];
+        for (unsigned int a = 0; a < (1u << n); ++a) {
+            Polynomial p{static_cast<uint8_t>(a), ip, n};
+
+            // Go past the order of the group to check the exponent wraps.
+            Polynomial expected{1, ip, n};
+            for (unsigned int e = 0; e < (2u << n) + 3; ++e) {
+                g_assert_cmpuint(pow(p, e).value(), ==, expected.value());
+                expected *= p;
+            }
+
+            g_assert_cmpuint(square(p).value(), ==, (p * p).value());
+            g_assert_cmpuint(square(sqrt(p)).value(), ==, a);
+            g_assert_cmpuint(sqrt(square(p)).value(), ==, a);
+        }
+    }
+}
+
+static void field_tables_cached() {
+    const FieldTables* tables = FieldTables::get(Polynomial::aes_irreducible_polynomial, 8);
+
+    g_assert_nonnull(tables);
+    g_assert_true(FieldTables::get(Polynomial::aes_irreducible_polynomial, 8) == tables);
+    g_assert_cmpuint(tables->order(), ==, 255);
+}
+
+static void field_tables_not_a_field() {
+    // x^2 + 1 == (x + 1)^2
+    g_assert_null(FieldTables::get(0b101, 2));
+    // x^8 + x^4 + x^3 + x^2 + 1 is fine, but not as a degree 3 polynomial.
+    g_assert_null(FieldTables::get(0b100011101, 3));
+    g_assert_null(FieldTables::get(0b1011, 9));
+}
+
+static void field_tables_arithmetic() {
+    // Everything the tables compute had better match the slow way.
+    for (int n = 1; n <= 8; ++n) {
+        uint16_t ip = irreducible_polynomials[n];
+        const FieldTables* tables = FieldTables::get(ip, n);
+        g_assert_nonnull(tables);
+
+        for (unsigned int a = 0; a < (1u << n); ++a) {
+            uint8_t power = 1;
+            for (unsigned int e = 0; e < 300; ++e) {
+                g_assert_cmpuint(tables->power(a, e), ==, power);
+                power = multiply_bitwise(power, a, ip, n);
+            }
+
+            for (unsigned int b = 0; b < (1u << n); ++b) {
+                uint8_t product = multiply_bitwise(a, b, ip, n);
+                g_assert_cmpuint(tables->multiply(a, b), ==, product);
+                if (b != 0)
+                    g_assert_cmpuint(tables->divide(product, b), ==, a);
+            }
+
+            if (a != 0)
+                g_assert_cmpuint(multiply_bitwise(a, tables->inverse(a), ip, n), ==, 1);
+        }
+    }
+}
+
+// Most of GF's job is done at compile time, so check it at compile time.
+static_assert(sizeof(GF256) == 1, "GF should be as small as its value");
+static_assert((GF256{0x57} * GF256{0x83}).value() == 0xc1, "FIPS 197 section 4.2");
+static_assert(multiplicative_inverse(GF256{0x53}).value() == 0xca, "Wikipedia");
+static_assert((GF<0b1011, 3>{0b101} * GF<0b1011, 3>{0b111}).value() == 0b110, "Stinson example 6.6");
+
+template <uint16_t IP, int N>
+static void check_gf_matches_polynomial() {
+    for (unsigned int a = 0; a < (1u << N); ++a) {
+        GF<IP, N> x{static_cast<uint8_t>(a)};
+        Polynomial p{static_cast<uint8_t>(a), IP, N};
+
+        if (a != 0)
+            g_assert_cmpuint(multiplicative_inverse(x).value(), ==, multiplicative_inverse(p).value());
+
+        for (unsigned int b = 0; b < (1u << N); ++b) {
+            GF<IP, N> y{static_cast<uint8_t>(b)};
+            Polynomial q{static_cast<uint8_t>(b), IP, N};
+
+            g_assert_cmpuint((x + y).value(), ==, (p + q).value());
+            g_assert_cmpuint((x * y).value(), ==, (p * q).value());
+            g_assert_cmpuint((x * y).polynomial().value(), ==, (p * q).value());
+            if (b != 0)
+                g_assert_cmpuint(((x * y) / y).value(), ==, a);
+        }
+    }
+}
+
+static void gf_matches_polynomial() {
+    check_gf_matches_polynomial<0b11, 1>();
+    check_gf_matches_polynomial<0b1011, 3>();
+    check_gf_matches_polynomial<0b1101, 3>();
+    check_gf_matches_polynomial<0b10011, 4>();
+    check_gf_matches_polynomial<0b10000011, 7>();
+    check_gf_matches_polynomial<Polynomial::aes_irreducible_polynomial, 8>();
+}
+
+static const RegionKernel region_kernels[] = {
+    RegionKernel::Scalar, RegionKernel::SSSE3, RegionKernel::AVX2, RegionKernel::GFNI
+};
+
+// Random elements of GF(2^n), with a few extra bytes on either side to catch
+// kernels that write where they shouldn't.
+static std::vector<uint8_t> random_elements(size_t len, int characteristic) {
+    std::vector<uint8_t> elements(len);
+    for (uint8_t& element : elements)
+        element = g_test_rand_int() & ((1u << characteristic) - 1);
+    return elements;
+}
+
+// Lazily reduced products and sums of them have to come out exactly as if
+// every product had been reduced on the spot.
+static void unreduced_products() {
+    for (int n = 1; n <= 8; ++n) {
+        uint16_t ip = irreducible_polynomials[n];
+        const FieldTables* tables = FieldTables::get(ip, n);
+        g_assert_nonnull(tables);
+        for (unsigned int a = 0; a < (1u << n); ++a) {
+            for (unsigned int b = 0; b < (1u << n); ++b) {
+                uint16_t product = multiply_carryless(a, b);
+                uint8_t expected = multiply_bitwise(a, b, ip, n);
+                g_assert_cmpuint(reduce_constant_time(product, ip, n), ==, expected);
+                g_assert_cmpuint(tables->reduce(product), ==, expected);
+
+                Polynomial x{static_cast<uint8_t>(a), ip, n};
+                Polynomial y{static_cast<uint8_t>(b), ip, n};
+                UnreducedPolynomial lazy = x * y;
+                g_assert_cmpuint(lazy.bits(), ==, product);
+                g_assert_cmpuint(lazy.reduce().value(), ==, expected);
+                g_assert_cmpuint((x * y).value(), ==, expected);
+            }
+        }
+
+        // a * b + c * d + e * f, and every other mixture of products and
+        // Polynomials, against the same with every product reduced first.
+        for (int i = 0; i < 1000; ++i) {
+            std::vector<uint8_t> v = random_elements(6, n);
+            Polynomial a{v[0], ip, n}, b{v[1], ip, n}, c{v[2], ip, n};
+            Polynomial d{v[3], ip, n}, e{v[4], ip, n}, f{v[5], ip, n};
+            Polynomial ab = a, cd = c, ef = e;
+            ab *= b;
+            cd *= d;
+            ef *= f;
+
+            Polynomial sum = a * b + c * d + e * f;
+            g_assert_true(sum == ab + cd + ef);
+            static_assert(std::is_same<decltype(a * b + c * d + e * f), UnreducedPolynomial>::value,
+                          "sums of products stay unreduced");
+            g_assert_true(a * b - c * d == ab - cd);
+            g_assert_true(a * b + c == ab + c);
+            g_assert_true(c + a * b == c + ab);
+            g_assert_true(a - c * d == a - cd);
+
+            // Code written for operator* returning Polynomial still works.
+            auto p = a * b;
+            p *= c;
+            g_assert_true(p == ab * c);
+            if (v[2] != 0) {
+                p /= c;
+                g_assert_cmpuint(p.value(), ==, ab.value());
+            }
+            g_assert_true((a * b != ab + Polynomial{1, ip, n}));
+            g_assert_true((a * b < c) == (ab < c));
+            // std::max(a * b, c) can't deduce one type; see UnreducedPolynomial.
+            g_assert_true((std::max<Polynomial>(a * b, c) == std::max(ab, c)));
+            auto times = [](const Polynomial& lhs, const Polynomial& rhs) { return lhs * rhs; };
+            g_assert_true(times(a, b) == ab);
+            Polynomial q = c;
+            q = a * b;
+            q *= c * d;
+            g_assert_true(q == ab * cd);
+            g_assert_true(a * b * (c * d) == ab * cd);
+            if (v[5] != 0)
+                g_assert_true(a * b / f == ab / f);
+            g_assert_true(square(a) == a * a);
+        }
+
+        // A long dot product in one accumulator.
+        std::vector<uint8_t> xs = random_elements(1000, n);
+        std::vector<uint8_t> ys = random_elements(1000, n);
+        UnreducedPolynomial accumulator{0, ip, n};
+        Polynomial expected{0, ip, n};
+        for (size_t i = 0; i < xs.size(); ++i) {
+            Polynomial x{xs[i], ip, n};
+            Polynomial y{ys[i], ip, n};
+            accumulator += x * y;
+            Polynomial product = x;
+            product *= y;
+            expected += product;
+        }
+        g_assert_true(accumulator.reduce() == expected);
+    }
+}
+
+static void check_regions(uint16_t ip, int n) {
+    // Odd lengths and offsets, so every kernel has to handle a ragged tail.
+    const size_t len = 237;
+    const size_t offset = 3;
+    std::vector<uint8_t> src = random_elements(len + 2 * offset, n);
+    std::vector<uint8_t> original = random_elements(len + 2 * offset, n);
+
+    for (unsigned int c = 0; c < (1u << n); ++c) {
+        Polynomial constant{static_cast<uint8_t>(c), ip, n};
+
+        std::vector<uint8_t> product = original;
+        gf_mul_region(&product[offset], &src[offset], constant.value(), len, ip, n);
+        std::vector<uint8_t> sum = original;
+        gf_mul_add_region(&sum[offset], &src[offset], constant.value(), len, ip, n);
+
+        for (size_t i = 0; i < len + 2 * offset; ++i) {
+            if (i < offset || i >= offset + len) {
+                g_assert_cmpuint(product[i], ==, original[i]);
+                g_assert_cmpuint(sum[i], ==, original[i]);
+                continue;
+            }
+
+            Polynomial expected = Polynomial{src[i], ip, n} * constant;
+            g_assert_cmpuint(product[i], ==, expected.value());
+            g_assert_cmpuint(sum[i], ==, (Polynomial{original[i], ip, n} + expected).value());
+        }
+    }
+
+    std::vector<uint8_t> added = original;
+    gf_add_region(&added[offset], &src[offset], len);
+    for (size_t i = 0; i < len + 2 * offset; ++i)
+        g_assert_cmpuint(added[i], ==, i < offset || i >= offset + len ? original[i] : original[i] ^ src[i]);
+
+    std::vector<uint8_t> inverses = original;
+    gf_inverse_region(&inverses[offset], &src[offset], len, ip, n);
+    for (size_t i = offset; i < offset + len; ++i) {
+        uint8_t expected = src[i] ? multiplicative_inverse(Polynomial{src[i], ip, n}).value() : 0;
+        g_assert_cmpuint(inverses[i], ==, expected);
+    }
+
+    // In place works too.
+    std::vector<uint8_t> in_place = src;
+    gf_inverse_region(in_place.data(), in_place.data(), in_place.size(), ip, n);
+    gf_mul_region(in_place.data(), in_place.data(), 1, in_place.size(), ip, n);
+    for (size_t i = 0; i < src.size(); ++i)
+        g_assert_cmpuint(in_place[i], ==, src[i] ? multiplicative_inverse(Polynomial{src[i], ip, n}).value() : 0);
+
+    // Adding a region to itself clears it.
+    gf_mul_add_region(in_place.data(), in_place.data(), 1, in_place.size(), ip, n);
+    for (size_t i = 0; i < in_place.size(); ++i)
+        g_assert_cmpuint(in_place[i], ==, 0);
+
+    // Empty regions can be null.
+    for (unsigned int c = 0; c < 3 && c < (1u << n); ++c) {
+        gf_mul_region(nullptr, nullptr, static_cast<uint8_t>(c), 0, ip, n);
+        gf_mul_add_region(nullptr, nullptr, static_cast<uint8_t>(c), 0, ip, n);
+    }
+    gf_add_region(nullptr, nullptr, 0);
+    gf_inverse_region(nullptr, nullptr, 0, ip, n);
+}
+
+static void region_kernels_match_polynomial() {
+    RegionKernel original = region_kernel();
+
+    for (RegionKernel kernel : region_kernels) {
+        if (!set_region_kernel(kernel))
+            continue;
+
+        for (int n = 1; n <= 8; ++n)
+            check_regions(irreducible_polynomials[n], n);
+        // The other common GF(2^8), used by most Reed-Solomon implementations.
+        check_regions(0b100011101, 8);
+    }
+
+    set_region_kernel(original);
+}
+
+static void region_matrix_matches_polynomial() {
+    RegionKernel original = region_kernel();
+
+    for (RegionKernel kernel : region_kernels) {
+        if (!set_region_kernel(kernel))
+            continue;
+
+        for (int n : { 3, 8 }) {
+            uint16_t ip = irreducible_polynomials[n];
+            // Odd sizes, so every kernel has a tail for the scalar code, and
+            // one big enough to need several blocks.
+            for (size_t len : { 0, 1, 31, 33, 1000, 100000 }) {
+                const size_t rows = 3;
+                const size_t columns = 5;
+                std::vector<uint8_t> elements = random_elements(rows * columns, n);
+                RegionMatrix matrix(elements.data(), rows, columns, ip, n);
+
+                std::vector<std::vector<uint8_t>> src;
+                std::vector<const uint8_t*> src_pointers;
+                for (size_t c = 0; c < columns; ++c) {
+                    src.push_back(random_elements(len, n));
+                    src_pointers.push_back(src.back().data());
+                }
+                std::vector<std::vector<uint8_t>> dst(rows, std::vector<uint8_t>(len, 0xff));
+                std::vector<uint8_t*> dst_pointers;
+                for (auto& d : dst)
+                    dst_pointers.push_back(d.data());
+
+                gf_matrix_region(dst_pointers.data(), src_pointers.data(), matrix, len);
+
+                for (size_t r = 0; r < rows; ++r) {
+                    for (size_t i = 0; i < len; ++i) {
+                        Polynomial sum{0, ip, n};
+                        for (size_t c = 0; c < columns; ++c)
+                            sum += Polynomial{matrix.at(r, c), ip, n} * Polynomial{src[c][i], ip, n};
+                        g_assert_cmpuint(dst[r][i], ==, sum.value());
+                    }
+                }
+            }
+        }
+    }
+
+    set_region_kernel(original);
+}
+
+template <typename Word>
+static Word random_word() {
+    Word word = 0;
+    for (size_t i = 0; i < sizeof(Word); i += 4)
+        word = (word << 16 << 16) | static_cast<uint32_t>(g_test_rand_int());
+    return word;
+}
+
+// Polynomial's shift-and-reduce loop, widened.
+template <typename Word>
+static Word reference_multiply(Word a, Word b, Word irreducible_polynomial) {
+    const Word leftmost_bit_mask = Word{1} << (sizeof(Word) * 8 - 1);
+    Word result = 0;
+    while (a != 0 && b != 0) {
+        if (b & 1)
+            result ^= a;
+        b >>= 1;
+        bool carry = (a & leftmost_bit_mask);
+        a <<= 1;
+        if (carry)
+            a ^= irreducible_polynomial;
+    }
+    return result;
+}
+
+template <typename Word>
+static void check_wide_polynomial() {
+    using P = WidePolynomial<Word>;
+    const Word ip = WideField<Word>::default_irreducible_polynomial;
+
+    for (int i = 0; i < 1000; ++i) {
+        P a{random_word<Word>()};
+        P b{random_word<Word>()};
+
+        g_assert_true((a * b).value() == reference_multiply(a.value(), b.value(), ip));
+        g_assert_true((a * b) == (b * a));
+        g_assert_true((a + b).value() == (a.value() ^ b.value()));
+        g_assert_true((a - b) == (a + b));
+        g_assert_true((a * P{1}) == a);
+        g_assert_true((a * P{0}) == P{0});
+
+        if (a.value() != 0)
+            g_assert_true((a * multiplicative_inverse(a)) == P{1});
+    }
+
+    // Multiplication modulo a polynomial of high degree takes a different
+    // path, but is still well defined even if the polynomial is reducible.
+    for (int i = 0; i < 1000; ++i) {
+        Word dense_ip = random_word<Word>() | (Word{1} << (sizeof(Word) * 8 - 1));
+        P a{random_word<Word>(), dense_ip};
+        P b{random_word<Word>(), dense_ip};
+
+        g_assert_true((a * b).value() == reference_multiply(a.value(), b.value(), dense_ip));
+    }
+}
+
+static void wide_polynomial() {
+    ClmulKernel original = clmul_kernel();
+
+    for (ClmulKernel kernel : { ClmulKernel::Portable, ClmulKernel::PCLMULQDQ }) {
+        if (!set_clmul_kernel(kernel))
+            continue;
+
+        check_wide_polynomial<uint16_t>();
+        check_wide_polynomial<uint32_t>();
+        check_wide_polynomial<uint64_t>();
+        check_wide_polynomial<uint128_t>();
+    }
+
+    set_clmul_kernel(original);
+}
+
+static void wide_polynomial_inverse16() {
+    // Small enough to check every element.
+    for (unsigned int i = 1; i < 0x10000; ++i) {
+        Polynomial16 p{static_cast<uint16_t>(i)};
+        g_assert_cmpuint((p * multiplicative_inverse(p)).value(), ==, 1);
+    }
+}
+
+// The CRC model, straight from its definition: the register shifts left a
+// bit at a time, and the generator goes in whenever a one falls off the top.
+static uint64_t reference_crc(const CrcParameters& parameters, const uint8_t* data, size_t len) {
+    const int width = parameters.width;
+    const uint64_t mask = ~uint64_t{0} >> (64 - width);
+    const auto reflect = [](uint64_t value, int bits) {
+        uint64_t result = 0;
+        for (int i = 0; i < bits; ++i)
+            result |= ((value >> i) & 1) << (bits - 1 - i);
+        return result;
+    };
+
+    uint64_t reg = parameters.init;
+    for (size_t i = 0; i < len; ++i) {
+        uint64_t byte = parameters.reflect_input ? reflect(data[i], 8) : data[i];
+        for (int bit = 7; bit >= 0; --bit) {
+            bool carry = ((byte >> bit) & 1) ^ ((reg >> (width - 1)) & 1);
+            reg = (reg << 1) & mask;
+            if (carry)
+                reg ^= parameters.polynomial;
+        }
+    }
+    if (parameters.reflect_output)
+        reg = reflect(reg, width);
+    return reg ^ parameters.xor_output;
+}
+
+static const CrcKernel crc_kernels[] = {
+    CrcKernel::Bytewise, CrcKernel::Slicing8, CrcKernel::Slicing16, CrcKernel::PCLMULQDQ
+};
+
+static void crc_check_values() {
+    // From Greg Cook's catalogue of parametrised CRC algorithms: the CRC of
+    // "123456789" for each. Odd widths, and input and output reflected
+    // differently, included.
+    struct {
+        CrcParameters parameters;
+        uint64_t check;
+    } catalogue[] = {
+        { crc32_iso_hdlc, 0xcbf43926 },
+        { crc32_iscsi, 0xe3069283 },
+        { crc32_bzip2, 0xfc891918 },
+        { { 32, 0x04c11db7, 0xffffffff, false, false, 0 }, 0x0376e6e7 },           // CRC-32/MPEG-2
+        { crc64_xz, 0x995dc9bbdf1939fa },
+        { crc64_ecma_182, 0x6c40df5f0b497347 },
+        { { 3, 0x3, 0x7, true, true, 0 }, 0x6 },                                    // CRC-3/ROHC
+        { { 5, 0x05, 0x1f, true, true, 0x1f }, 0x19 },                              // CRC-5/USB
+        { { 8, 0x07, 0, false, false, 0 }, 0xf4 },                                  // CRC-8/SMBUS
+        { { 12, 0x80f, 0, false, true, 0 }, 0xdaf },                                // CRC-12/UMTS
+        { { 16, 0x1021, 0xffff, false, false, 0 }, 0x29b1 },                        // CRC-16/IBM-3740
+        { { 16, 0x1021, 0, true, true, 0 }, 0x2189 },                               // CRC-16/KERMIT
+        { { 16, 0x1021, 0xb2aa, true, true, 0 }, 0x63d0 },                          // CRC-16/RIELLO
+        { { 24, 0x864cfb, 0xb704ce, false, false, 0 }, 0x21cf02 },                  // CRC-24/OPENPGP
+        { { 40, 0x0004820009, 0, false, false, 0xffffffffff }, 0xd4164fc646 },      // CRC-40/GSM
+    };
+    const char* message = "123456789";
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(message);
+
+    CrcKernel original = crc_kernel();
+    for (CrcKernel kernel : crc_kernels) {
+        if (!set_crc_kernel(kernel))
+            continue;
+        for (const auto& entry : catalogue) {
+            Crc crc(entry.parameters);
+            g_assert_cmphex(reference_crc(entry.parameters, bytes, 9), ==, entry.check);
+            g_assert_cmphex(crc.compute(message, 9), ==, entry.check);
+        }
+    }
+    set_crc_kernel(original);
+}
+
+static void crc_kernels_agree() {
+    std::vector<uint8_t> data(3000);
+    for (uint8_t& byte : data)
+        byte = static_cast<uint8_t>(g_test_rand_int());
+
+    CrcKernel original = crc_kernel();
+    for (int width = 1; width <= 64; ++width) {
+        // Only the low width bits of each of these count.
+        CrcParameters parameters{width, random_word<uint64_t>() | 1, random_word<uint64_t>(),
+                                 (width & 1) != 0, (width & 2) != 0, random_word<uint64_t>()};
+        Crc crc(parameters);
+        parameters = crc.parameters();
+        const uint64_t empty = crc.compute(nullptr, 0);
+        g_assert_cmphex(empty, ==, reference_crc(parameters, nullptr, 0));
+
+        for (int i = 0; i < 10; ++i) {
+            // Odd starting points and lengths either side of each kernel's
+            // block size.
+            size_t offset = g_test_rand_int_range(0, 16);
+            size_t len = i < 5 ? g_test_rand_int_range(0, 300) : g_test_rand_int_range(0, data.size() - 16);
+            const uint8_t* bytes = data.data() + offset;
+            uint64_t expected = reference_crc(parameters, bytes, len);
+
+            for (CrcKernel kernel : crc_kernels) {
+                if (!set_crc_kernel(kernel))
+                    continue;
+                g_assert_cmphex(crc.compute(bytes, len), ==, expected);
+
+                size_t split = g_test_rand_int_range(0, len + 1);
+                uint64_t first = crc.compute(bytes, split);
+                g_assert_cmphex(crc.update(first, bytes + split, len - split), ==, expected);
+
+                uint64_t second = crc.compute(bytes + split, len - split);
+                g_assert_cmphex(crc.combine(first, second, len - split), ==, expected);
+            }
+        }
+
+        g_assert_cmphex(crc.combine(empty, empty, 0), ==, empty);
+    }
+    set_crc_kernel(original);
+}
+
+static void batch_inverse() {
+    for (int n = 1; n <= 8; ++n) {
+        uint16_t ip = irreducible_polynomials[n];
+        std::vector<Polynomial> in;
+        for (unsigned int i = 0; i < 3 * (1u << n); ++i)
+            in.emplace_back(static_cast<uint8_t>(i % (1u << n)), ip, n);
+        std::vector<Polynomial> out(in.size(), Polynomial{0, ip, n});
+
+        size_t zeros = multiplicative_inverse_batch(in.data(), out.data(), in.size());
+        g_assert_cmpuint(zeros, ==, 3);
+        for (size_t i = 0; i < in.size(); ++i) {
+            if (in[i].value() == 0)
+                g_assert_cmpuint(out[i].value(), ==, 0);
+            else
+                g_assert_cmpuint(out[i].value(), ==, multiplicative_inverse(in[i]).value());
+        }
+
+        std::vector<uint8_t> bytes;
+        for (const Polynomial& p : in)
+            bytes.push_back(p.value());
+        g_assert_cmpuint(multiplicative_inverse_batch(bytes.data(), bytes.data(), bytes.size(), ip, n), ==, 3);
+        for (size_t i = 0; i < in.size(); ++i)
+            g_assert_cmpuint(bytes[i], ==, out[i].value());
+    }
+
+    // Nothing much to do, but don't crash doing it.
+    g_assert_cmpuint(multiplicative_inverse_batch(static_cast<const Polynomial*>(nullptr), nullptr, 0), ==, 0);
+}
+
+template <typename Word>
+static void check_wide_batch_inverse() {
+    using P = WidePolynomial<Word>;
+    std::vector<P> in;
+    for (int i = 0; i < 100; ++i)
+        in.emplace_back(i % 10 ? random_word<Word>() | 1 : 0);
+    std::vector<P> out(in.size(), P{0});
+
+    g_assert_cmpuint(multiplicative_inverse_batch(in.data(), out.data(), in.size()), ==, 10);
+    for (size_t i = 0; i < in.size(); ++i) {
+        if (in[i].value() == 0)
+            g_assert_true(out[i].value() == 0);
+        else
+            g_assert_true(out[i] == multiplicative_inverse(in[i]));
+    }
+}
+
+static void wide_batch_inverse() {
+    check_wide_batch_inverse<uint16_t>();
+    check_wide_batch_inverse<uint32_t>();
+    check_wide_batch_inverse<uint64_t>();
+    check_wide_batch_inverse<uint128_t>();
+}
+
+static void thread_pool_parallel_for() {
+    for (unsigned int threads : { 1, 2, 4 }) {
+        ThreadPool pool{threads};
+        g_assert_cmpuint(pool.size(), ==, threads);
+
+        // Every index gets visited exactly once, even from nested loops.
+        std::vector<std::atomic<int>> visits(10000);
+        for (std::atomic<int>& count : visits)
+            count = 0;
+        pool.parallel_for(100, 7, [&](size_t begin, size_t end) {
+            g_assert_cmpuint(end - begin, <=, 7);
+            for (size_t i = begin; i < end; ++i) {
+                pool.parallel_for(100, 13, [&](size_t inner_begin, size_t inner_end) {
+                    for (size_t j = inner_begin; j < inner_end; ++j)
+                        ++visits[i * 100 + j];
+                });
+            }
+        });
+        for (const std::atomic<int>& count : visits)
+            g_assert_cmpint(count, ==, 1);
+
+        bool called = false;
+        pool.parallel_for(0, 10, [&](size_t, size_t) { called = true; });
+        g_assert_false(called);
+    }
+}
+
+static void parallel_bulk_operations() {
+    ThreadPool pool{3};
+    const size_t len = 5 * parallel_grain_bytes + 123;
+    std::vector<uint8_t> src = random_elements(len, 8);
+
+    std::vector<uint8_t> expected(len);
+    std::vector<uint8_t> actual(len);
+    gf_mul_region(expected.data(), src.data(), 0x53, len);
+    parallel_mul_region(pool, actual.data(), src.data(), 0x53, len);
+    g_assert_true(expected == actual);
+
+    gf_mul_add_region(expected.data(), src.data(), 0xca, len);
+    parallel_mul_add_region(pool, actual.data(), src.data(), 0xca, len);
+    g_assert_true(expected == actual);
+
+    gf_inverse_region(expected.data(), src.data(), len);
+    parallel_inverse_region(pool, actual.data(), src.data(), len);
+    g_assert_true(expected == actual);
+
+    std::vector<Polynomial64> in;
+    for (size_t i = 0; i < 20000; ++i)
+        in.emplace_back(i % 1000 ? random_word<uint64_t>() | 1 : 0);
+    std::vector<Polynomial64> out(in.size(), Polynomial64{0});
+    g_assert_cmpuint(parallel_inverse_batch(pool, in.data(), out.data(), in.size()), ==, 20);
+    for (size_t i = 0; i < in.size(); ++i)
+        g_assert_true(out[i].value() == (in[i].value() ? multiplicative_inverse(in[i]).value() : 0));
+}
+
+static void parallel_matrix_vector_product() {
+    ThreadPool pool{4};
+    const size_t rows = 300;
+    const size_t columns = 1000;
+    for (int n : { 3, 8 }) {
+        uint16_t ip = irreducible_polynomials[n];
+        std::vector<uint8_t> matrix = random_elements(rows * columns, n);
+        std::vector<uint8_t> x = random_elements(columns, n);
+        std::vector<uint8_t> y(rows);
+
+        parallel_matrix_vector(pool, matrix.data(), rows, columns, x.data(), y.data(), ip, n);
+        for (size_t row = 0; row < rows; ++row) {
+            Polynomial sum{0, ip, n};
+            for (size_t column = 0; column < columns; ++column)
+                sum += Polynomial{matrix[row * columns + column], ip, n} * Polynomial{x[column], ip, n};
+            g_assert_cmpuint(y[row], ==, sum.value());
+        }
+    }
+}
+
+static FieldPolynomial random_field_polynomial(size_t len, uint16_t ip, int n) {
+    return FieldPolynomial(random_elements(len, n), ip, n);
+}
+
+static void field_polynomial_arithmetic() {
+    // (x + 1)^2 = x^2 + 1, since 2 = 0.
+    FieldPolynomial x_plus_1(std::vector<uint8_t>{1, 1});
+    g_assert_true(x_plus_1 * x_plus_1 == FieldPolynomial(std::vector<uint8_t>{1, 0, 1}));
+    g_assert_true(x_plus_1 + x_plus_1 == FieldPolynomial());
+    g_assert_cmpint((x_plus_1 - x_plus_1).degree(), ==, -1);
+
+    // Trailing zeros don't count.
+    FieldPolynomial p({3, 0, 0});
+    g_assert_cmpint(p.degree(), ==, 0);
+    p.set_coefficient(4, 7);
+    g_assert_cmpint(p.degree(), ==, 4);
+    p.set_coefficient(4, 0);
+    g_assert_cmpint(p.degree(), ==, 0);
+
+    // 3 x^2 + 1 at x = 2: 3 * 4 + 1 = 0xc + 1 in the AES field.
+    g_assert_cmpuint(FieldPolynomial(std::vector<uint8_t>{1, 0, 3}).evaluate(2), ==, 0xd);
+}
+
+static void field_polynomial_multiply() {
+    // Every algorithm must agree with schoolbook, on both sides of every
+    // threshold and on lopsided operands.
+    static const size_t sizes[][2] = {
+        { 1, 1 }, { 2, 3 }, { 7, 7 }, { 64, 65 }, { 100, 100 }, { 127, 129 }, { 300, 17 }, { 513, 400 }, { 1000, 1000 },
+    };
+    for (int n : { 3, 8 }) {
+        uint16_t ip = irreducible_polynomials[n];
+        for (const auto& size : sizes) {
+            FieldPolynomial a = random_field_polynomial(size[0], ip, n);
+            FieldPolynomial b = random_field_polynomial(size[1], ip, n);
+            FieldPolynomial expected = multiply(a, b, MultiplicationAlgorithm::Schoolbook);
+
+            g_assert_true(multiply(a, b, MultiplicationAlgorithm::Karatsuba) == expected);
+            g_assert_true(multiply(a, b, MultiplicationAlgorithm::AdditiveFFT) == expected);
+            g_assert_true(multiply(b, a, MultiplicationAlgorithm::AdditiveFFT) == expected);
+            g_assert_true(a * b == expected);
+        }
+    }
+}
+
+static void field_polynomial_divmod() {
+    // Small enough for long division, and big enough for Newton iteration.
+    static const size_t sizes[][2] = {
+        { 1, 1 }, { 5, 2 }, { 5, 9 }, { 100, 30 }, { 2000, 600 }, { 3000, 1500 },
+    };
+    for (int n : { 1, 4, 8 }) {
+        uint16_t ip = irreducible_polynomials[n];
+        for (const auto& size : sizes) {
+            FieldPolynomial a = random_field_polynomial(size[0], ip, n);
+            FieldPolynomial b = random_field_polynomial(size[1], ip, n);
+            if (b.is_zero())
+                b = FieldPolynomial(std::vector<uint8_t>{1}, ip, n);
+
+            FieldPolynomial q(ip, n);
+            FieldPolynomial r(ip, n);
+            divmod(a, b, q, r);
+            g_assert_cmpint(r.degree(), <, b.degree() > 0 ? b.degree() : 0);
+            g_assert_true(q * b + r == a);
+            g_assert_true(a / b == q);
+            g_assert_true(a % b == r);
+        }
+    }
+}
+
+static void field_polynomial_gcd() {
+    uint16_t ip = Polynomial::aes_irreducible_polynomial;
+
+    // (x + 1)(x + 2) and (x + 1)(x + 3) have only x + 1 in common.
+    FieldPolynomial a = FieldPolynomial(std::vector<uint8_t>{1, 1}) * FieldPolynomial(std::vector<uint8_t>{2, 1});
+    FieldPolynomial b = FieldPolynomial(std::vector<uint8_t>{1, 1}) * FieldPolynomial(std::vector<uint8_t>{3, 1});
+    g_assert_true(gcd(a, b) == FieldPolynomial(std::vector<uint8_t>{1, 1}));
+    g_assert_true(gcd(a, FieldPolynomial()) == gcd(FieldPolynomial(), a));
+    g_assert_true(gcd(FieldPolynomial(), FieldPolynomial()).is_zero());
+
+    for (int i = 0; i < 10; ++i) {
+        FieldPolynomial common = random_field_polynomial(1 + g_test_rand_int_range(0, 50), ip, 8);
+        FieldPolynomial x = random_field_polynomial(1 + g_test_rand_int_range(0, 50), ip, 8) * common;
+        FieldPolynomial y = random_field_polynomial(1 + g_test_rand_int_range(0, 50), ip, 8) * common;
+        if (common.is_zero() || x.is_zero() || y.is_zero())
+            continue;
+
+        FieldPolynomial g = gcd(x, y);
+        g_assert_cmpuint(g.coefficients().back(), ==, 1);
+        g_assert_true((x % g).is_zero());
+        g_assert_true((y % g).is_zero());
+        g_assert_true((g % common).is_zero());
+    }
+}
+
+static void field_polynomial_evaluate() {
+    for (int n = 1; n <= 8; ++n) {
+        uint16_t ip = irreducible_polynomials[n];
+        std::vector<uint8_t> points(1u << n);
+        for (size_t i = 0; i < points.size(); ++i)
+            points[i] = static_cast<uint8_t>(i);
+
+        // Short enough for Horner, and long enough to go through the FFT.
+        for (size_t len : { 0, 1, 5, 300, 2000 }) {
+            FieldPolynomial p = random_field_polynomial(len, ip, n);
+            std::vector<uint8_t> values = evaluate(p, points);
+            for (size_t i = 0; i < points.size(); ++i)
+                g_assert_cmpuint(values[i], ==, p.evaluate(points[i]));
+        }
+    }
+}
+
+static void check_reed_solomon(size_t k, size_t m, size_t stripe_size, uint16_t ip, int n) {
+    ReedSolomon rs(k, m, ip, n);
+    std::vector<std::vector<uint8_t>> original;
+    for (size_t i = 0; i < k; ++i)
+        original.push_back(random_elements(stripe_size, n));
+    original.resize(k + m, std::vector<uint8_t>(stripe_size));
+
+    std::vector<const uint8_t*> data;
+    std::vector<uint8_t*> parity;
+    for (size_t i = 0; i < k; ++i)
+        data.push_back(original[i].data());
+    for (size_t i = k; i < k + m; ++i)
+        parity.push_back(original[i].data());
+    rs.encode(data.data(), parity.data(), stripe_size);
+
+    // Every pattern of up to m erasures, for small codes; random ones
+    // otherwise.
+    size_t total = k + m;
+    bool exhaustive = total <= 10;
+    unsigned int patterns = exhaustive ? 1u << total : 200;
+    for (unsigned int p = 0; p < patterns; ++p) {
+        std::vector<bool> present(total, true);
+        if (exhaustive) {
+            for (size_t i = 0; i < total; ++i)
+                present[i] = !(p & (1u << i));
+        } else {
+            for (size_t e = 0; e < m; ++e)
+                present[g_test_rand_int_range(0, total)] = false;
+        }
+        size_t erased = 0;
+        for (bool b : present)
+            erased += !b;
+
+        std::vector<std::vector<uint8_t>> shards = original;
+        std::vector<uint8_t*> pointers;
+        for (size_t i = 0; i < total; ++i) {
+            if (!present[i])
+                std::fill(shards[i].begin(), shards[i].end(), 0x5a);
+            pointers.push_back(shards[i].data());
+        }
+
+        std::unique_ptr<bool[]> flags(new bool[total]);
+        std::copy(present.begin(), present.end(), flags.get());
+        bool decoded = rs.decode(pointers.data(), flags.get(), stripe_size);
+        g_assert_cmpint(decoded, ==, erased <= m);
+        if (decoded) {
+            for (size_t i = 0; i < total; ++i)
+                g_assert_true(shards[i] == original[i]);
+        }
+    }
+}
+
+static void reed_solomon() {
+    uint16_t aes = Polynomial::aes_irreducible_polynomial;
+    check_reed_solomon(1, 1, 100, aes, 8);
+    check_reed_solomon(4, 2, 1000, aes, 8);
+    check_reed_solomon(6, 4, 4097, aes, 8);
+    check_reed_solomon(10, 4, 3000, 0b100011101, 8);
+    check_reed_solomon(3, 2, 333, irreducible_polynomials[3], 3);
+    // As big as GF(2^4) allows.
+    check_reed_solomon(12, 4, 100, irreducible_polynomials[4], 4);
+}
+
+static void check_shamir(size_t threshold, size_t share_count, size_t len, uint16_t ip, int n, ThreadPool* pool) {
+    ShamirSplitter splitter(threshold, share_count, ip, n);
+    std::vector<uint8_t> secret = random_elements(len, n);
+    std::vector<std::vector<uint8_t>> shares(share_count, std::vector<uint8_t>(len));
+    std::vector<uint8_t*> share_pointers;
+    for (auto& share : shares)
+        share_pointers.push_back(share.data());
+    splitter.split(secret.data(), share_pointers.data(), len, system_random, pool);
+
+    // Every subset of exactly threshold shares recovers the secret, as do
+    // all of them together.
+    for (unsigned subset = 1; subset < (1u << share_count); ++subset) {
+        size_t size = __builtin_popcount(subset);
+        if (size != threshold && size != share_count)
+            continue;
+        std::vector<uint8_t> xs;
+        std::vector<const uint8_t*> sources;
+        for (size_t i = 0; i < share_count; ++i) {
+            if (subset & (1u << i)) {
+                xs.push_back(splitter.xs()[i]);
+                sources.push_back(shares[i].data());
+            }
+        }
+        ShamirCombiner combiner(xs, ip, n);
+        std::vector<uint8_t> recovered(len);
+        combiner.combine(sources.data(), recovered.data(), len, pool);
+        g_assert_true(recovered == secret);
+    }
+}
+
+static void shamir() {
+    ThreadPool pool{4};
+    uint16_t aes = Polynomial::aes_irreducible_polynomial;
+    check_shamir(1, 1, 100, aes, 8, nullptr);
+    check_shamir(2, 3, 1000, aes, 8, nullptr);
+    check_shamir(3, 5, 40000, aes, 8, &pool);
+    check_shamir(5, 5, 333, aes, 8, nullptr);
+    check_shamir(4, 8, 5000, 0b100011101, 8, nullptr);
+    check_shamir(3, 7, 1000, irreducible_polynomials[3], 3, &pool);
+    check_shamir(2, 3, 100, irreducible_polynomials[2], 2, nullptr);
+
+    // With every random coefficient 1, share i is secret + 1 + x_i + ... +
+    // x_i^(threshold - 1), so the secret really is the constant term.
+    ShamirSplitter splitter(3, std::vector<uint8_t>{ 7, 0x53, 0x99 });
+    uint8_t secret[2] = { 0x12, 0xca };
+    uint8_t share0[2], share1[2], share2[2];
+    uint8_t* shares[] = { share0, share1, share2 };
+    splitter.split(secret, shares, 2, [](uint8_t* buffer, size_t len) { std::fill(buffer, buffer + len, 1); });
+    for (size_t b = 0; b < 2; ++b) {
+        for (size_t i = 0; i < 3; ++i) {
+            Polynomial x{splitter.xs()[i]};
+            g_assert_cmpuint(shares[i][b], ==, (Polynomial{secret[b]} + x + x * x).value());
+        }
+    }
+
+    // The Lagrange coefficients, straight from the definition.
+    std::vector<uint8_t> xs = { 1, 2, 3, 0xfe };
+    ShamirCombiner combiner(xs);
+    for (size_t i = 0; i < xs.size(); ++i) {
+        Polynomial expected{1};
+        for (size_t j = 0; j < xs.size(); ++j) {
+            if (j != i)
+                expected *= Polynomial{xs[j]} / (Polynomial{xs[j]} - Polynomial{xs[i]});
+        }
+        g_assert_cmpuint(combiner.coefficients()[i], ==, expected.value());
+    }
+}
+
+static FieldMatrix random_field_matrix(size_t rows, size_t columns, uint16_t ip, int n) {
+    return FieldMatrix(rows, columns, random_elements(rows * columns, n), ip, n);
+}
+
+// The definition, one Polynomial at a time.
+static FieldMatrix naive_multiply(const FieldMatrix& a, const FieldMatrix& b) {
+    uint16_t ip = a.irreducible_polynomial();
+    int n = a.characteristic();
+    FieldMatrix product(a.rows(), b.columns(), ip, n);
+    for (size_t i = 0; i < a.rows(); ++i) {
+        for (size_t j = 0; j < b.columns(); ++j) {
+            Polynomial sum{0, ip, n};
+            for (size_t k = 0; k < a.columns(); ++k)
+                sum += Polynomial{a.at(i, k), ip, n} * Polynomial{b.at(k, j), ip, n};
+            product.set(i, j, sum.value());
+        }
+    }
+    return product;
+}
+
+static void field_matrix_multiply() {
+    ThreadPool pool{4};
+
+    for (int n : { 3, 8 }) {
+        uint16_t ip = irreducible_polynomials[n];
+        // Big enough to need several blocks of rows and of the inner
+        // dimension, with ragged edges.
+        static const size_t shapes[][3] = { { 1, 1, 1 }, { 3, 5, 7 }, { 70, 300, 50 }, { 130, 129, 131 } };
+        for (const auto& shape : shapes) {
+            FieldMatrix a = random_field_matrix(shape[0], shape[1], ip, n);
+            FieldMatrix b = random_field_matrix(shape[1], shape[2], ip, n);
+            FieldMatrix expected = naive_multiply(a, b);
+            g_assert_true(a * b == expected);
+            g_assert_true(multiply(a, b, &pool) == expected);
+        }
+
+        FieldMatrix a = random_field_matrix(20, 20, ip, n);
+        g_assert_true(a * FieldMatrix::identity(20, ip, n) == a);
+        g_assert_true(a + a == FieldMatrix(20, 20, ip, n));
+    }
+}
+
+// Whether the matrix is in reduced row echelon form with the given rank.
+static void check_reduced_row_echelon_form(const FieldMatrix& m, size_t expected_rank) {
+    size_t next_column = 0;
+    for (size_t r = 0; r < m.rows(); ++r) {
+        size_t pivot = next_column;
+        while (pivot < m.columns() && m.at(r, pivot) == 0)
+            ++pivot;
+        if (r >= expected_rank) {
+            g_assert_cmpuint(pivot, ==, m.columns());
+            continue;
+        }
+        g_assert_cmpuint(pivot, <, m.columns());
+        g_assert_cmpuint(m.at(r, pivot), ==, 1);
+        for (size_t other = 0; other < m.rows(); ++other) {
+            if (other != r)
+                g_assert_cmpuint(m.at(other, pivot), ==, 0);
+        }
+        next_column = pivot + 1;
+    }
+}
+
+static void field_matrix_row_reduce() {
+    ThreadPool pool{4};
+
+    for (int n : { 1, 3, 8 }) {
+        uint16_t ip = irreducible_polynomials[n];
+        for (size_t size : { 1, 10, 100, 200 }) {
+            // Upper triangular rows with nonzero diagonals are independent.
+            // Mix in combinations of them and shuffle, and the rank is known.
+            size_t independent = size - size / 3;
+            size_t columns = size + 7;
+            std::vector<std::vector<uint8_t>> rows;
+            for (size_t r = 0; r < independent; ++r) {
+                std::vector<uint8_t> row = random_elements(columns, n);
+                std::fill(row.begin(), row.begin() + r, 0);
+                row[r] = 1 + g_test_rand_int_range(0, (1 << n) - 1);
+                rows.push_back(row);
+            }
+            const FieldTables& tables = *FieldTables::get(ip, n);
+            for (size_t r = independent; r < size; ++r) {
+                std::vector<uint8_t> row(columns);
+                for (size_t i = 0; i < independent; ++i) {
+                    uint8_t factor = g_test_rand_int_range(0, 1 << n);
+                    for (size_t j = 0; j < columns; ++j)
+                        row[j] ^= tables.multiply(factor, rows[i][j]);
+                }
+                rows.push_back(row);
+            }
+            for (size_t r = size; r > 1; --r)
+                std::swap(rows[r - 1], rows[g_test_rand_int_range(0, r)]);
+
+            std::vector<uint8_t> elements;
+            for (const auto& row : rows)
+                elements.insert(elements.end(), row.begin(), row.end());
+            FieldMatrix original(size, columns, elements, ip, n);
+
+            FieldMatrix m = original;
+            g_assert_cmpuint(row_reduce(m), ==, independent);
+            check_reduced_row_echelon_form(m, independent);
+
+            FieldMatrix threaded = original;
+            g_assert_cmpuint(row_reduce(threaded, &pool), ==, independent);
+            g_assert_true(threaded == m);
+
+            g_assert_cmpuint(rank(original), ==, independent);
+        }
+    }
+}
+
+static void field_matrix_invert() {
+    ThreadPool pool{4};
+
+    for (int n : { 2, 8 }) {
+        uint16_t ip = irreducible_polynomials[n];
+        for (size_t size : { 1, 2, 17, 64, 65, 150 }) {
+            FieldMatrix identity = FieldMatrix::identity(size, ip, n);
+            // A random matrix is singular now and then, especially in small
+            // fields, so keep going until there's been an invertible one.
+            bool inverted = false;
+            while (!inverted) {
+                FieldMatrix a = random_field_matrix(size, size, ip, n);
+                FieldMatrix inverse = a;
+                inverted = invert(inverse, size > 64 ? &pool : nullptr);
+                if (inverted) {
+                    g_assert_true(a * inverse == identity);
+                    g_assert_true(inverse * a == identity);
+                } else {
+                    g_assert_true(inverse == a);
+                    g_assert_cmpuint(rank(a), <, size);
+                }
+            }
+
+            if (size > 1) {
+                // Two equal rows.
+                FieldMatrix singular = random_field_matrix(size, size, ip, n);
+                for (size_t j = 0; j < size; ++j)
+                    singular.set(size - 1, j, singular.at(0, j));
+                FieldMatrix copy = singular;
+                g_assert_false(invert(copy));
+                g_assert_true(copy == singular);
+            }
+        }
+    }
+}
+
+static const FieldVectorLayout field_vector_layouts[] = { FieldVectorLayout::Bytes, FieldVectorLayout::Packed };
+
+static void field_vector_elements() {
+    for (int n = 1; n <= 8; ++n) {
+        uint16_t ip = irreducible_polynomials[n];
+        for (FieldVectorLayout layout : field_vector_layouts) {
+            for (size_t size : { 0, 1, 7, 8, 9, 63, 5000 }) {
+                std::vector<uint8_t> elements = random_elements(size, n);
+                FieldVector v(elements, ip, n, layout);
+                g_assert_cmpuint(v.size(), ==, size);
+                g_assert_cmpuint(v.data_size(), ==, layout == FieldVectorLayout::Bytes ? size : (size * n + 7) / 8);
+                g_assert_true(v.elements() == elements);
+                for (size_t i = 0; i < size; ++i)
+                    g_assert_cmpuint(v.at(i), ==, elements[i]);
+                g_assert_true(std::equal(v.begin(), v.end(), elements.begin()));
+                g_assert_cmpint(v.end() - v.begin(), ==, static_cast<std::ptrdiff_t>(size));
+
+                // Bits past the last element stay clear.
+                if (layout == FieldVectorLayout::Packed && size * n % 8)
+                    g_assert_cmpuint(v.data()[v.data_size() - 1] >> (size * n % 8), ==, 0);
+
+                // Writes through references and iterators land on the right
+                // element and nowhere else.
+                std::vector<uint8_t> replacements = random_elements(size, n);
+                for (size_t i = 0; i < size; i += 3) {
+                    v[i] = replacements[i];
+                    elements[i] = replacements[i];
+                }
+                for (FieldVector::iterator it = v.begin() + (size > 1 ? 1 : 0); it < v.end(); it += 3)
+                    *it = static_cast<uint8_t>(elements[it - v.begin()] ^ 1);
+                for (size_t i = size > 1 ? 1 : 0; i < size; i += 3)
+                    elements[i] ^= 1;
+                g_assert_true(v.elements() == elements);
+                if (size > 2) {
+                    v[2] = v[1];
+                    g_assert_cmpuint(v.at(2), ==, elements[1]);
+                    elements[2] = elements[1];
+                }
+
+                FieldVector other = v.with_layout(layout == FieldVectorLayout::Bytes ? FieldVectorLayout::Packed
+                                                                                     : FieldVectorLayout::Bytes);
+                g_assert_true(other == v);
+                g_assert_true(other.elements() == elements);
+                if (size) {
+                    other.set(size - 1, other.at(size - 1) ^ 1);
+                    g_assert_true(other != v);
+                }
+
+                // The standard algorithms work on it like on any other
+                // random-access container, swapping through references.
+                std::reverse(v.begin(), v.end());
+                std::reverse(elements.begin(), elements.end());
+                g_assert_true(v.elements() == elements);
+                std::sort(v.begin(), v.end());
+                std::sort(elements.begin(), elements.end());
+                g_assert_true(v.elements() == elements);
+                g_assert_true(1 + v.begin() == v.begin() + 1);
+            }
+        }
+    }
+}
+
+static void field_vector_bulk() {
+    for (int n : { 1, 3, 4, 8 }) {
+        uint16_t ip = irreducible_polynomials[n];
+        for (FieldVectorLayout layout : field_vector_layouts) {
+            for (FieldVectorLayout src_layout : field_vector_layouts) {
+                // Longer than one block.
+                for (size_t size : { 0, 13, 10000 }) {
+                    std::vector<uint8_t> a = random_elements(size, n);
+                    std::vector<uint8_t> b = random_elements(size, n);
+                    uint8_t constant = g_test_rand_int() & ((1u << n) - 1);
+
+                    std::vector<uint8_t> sum(size), scaled(size), scaled_sum(size), inverse(size);
+                    for (size_t i = 0; i < size; ++i) {
+                        Polynomial x{a[i], ip, n};
+                        Polynomial y{b[i], ip, n};
+                        Polynomial c{constant, ip, n};
+                        sum[i] = (x + y).value();
+                        scaled[i] = (x * c).value();
+                        scaled_sum[i] = (x + c * y).value();
+                        inverse[i] = a[i] ? multiplicative_inverse(x).value() : 0;
+                    }
+
+                    FieldVector x(a, ip, n, layout);
+                    FieldVector y(b, ip, n, src_layout);
+
+                    FieldVector v = x;
+                    v += y;
+                    g_assert_true(v.elements() == sum);
+                    g_assert_true(x + y == v);
+                    v -= y;
+                    g_assert_true(v == x);
+
+                    v.multiply(constant);
+                    g_assert_true(v.elements() == scaled);
+
+                    v = x;
+                    v.multiply_add(constant, y);
+                    g_assert_true(v.elements() == scaled_sum);
+                    v = x;
+                    v.multiply_add(1, y);
+                    g_assert_true(v.elements() == sum);
+                    v.multiply_add(0, x);
+                    g_assert_true(v.elements() == sum);
+
+                    v = x;
+                    v.invert();
+                    g_assert_true(v.elements() == inverse);
+                    g_assert_true(v.layout() == layout);
+                }
+            }
+        }
+    }
+}
+
+static void field_vector_file() {
+    char path[] = "/tmp/multinv-test-XXXXXX";
+    int fd = mkstemp(path);
+    g_assert_cmpint(fd, !=, -1);
+    close(fd);
+
+    for (int n : { 3, 8 }) {
+        uint16_t ip = irreducible_polynomials[n];
+        for (FieldVectorLayout layout : field_vector_layouts) {
+            std::vector<uint8_t> elements = random_elements(1001, n);
+            {
+                std::unique_ptr<FieldVector> created = FieldVector::create(path, elements.size(), ip, n, layout);
+                g_assert_nonnull(created);
+                g_assert_true(created->mapped());
+                g_assert_true(std::all_of(created->begin(), created->end(), [](uint8_t e) { return e == 0; }));
+                created->put(0, elements.size(), elements.data());
+            }
+
+            // Changes to a writable mapping end up in the file.
+            {
+                std::unique_ptr<FieldVector> mapped = FieldVector::open(path, true);
+                g_assert_nonnull(mapped);
+                g_assert_cmpuint(mapped->irreducible_polynomial(), ==, ip);
+                g_assert_cmpint(mapped->characteristic(), ==, n);
+                g_assert_true(mapped->layout() == layout);
+                g_assert_true(mapped->elements() == elements);
+                mapped->invert();
+            }
+            FieldVector expected(elements, ip, n, layout);
+            expected.invert();
+
+            std::unique_ptr<FieldVector> reopened = FieldVector::open(path);
+            g_assert_nonnull(reopened);
+            g_assert_false(reopened->writable());
+            g_assert_true(*reopened == expected);
+
+            // Copies of a mapped vector are independent of the file.
+            FieldVector copy = *reopened;
+            g_assert_false(copy.mapped());
+            copy.multiply(1);
+            copy.invert();
+            g_assert_true(copy.elements() == elements);
+            reopened.reset();
+
+            g_assert_true(copy.save(path));
+            reopened = FieldVector::open(path);
+            g_assert_nonnull(reopened);
+            g_assert_true(*reopened == copy);
+        }
+    }
+
+    // Files that aren't a FieldVector, or are cut short.
+    FieldVector v(random_elements(100, 8));
+    g_assert_true(v.save(path));
+    g_assert_nonnull(FieldVector::open(path));
+    g_assert_cmpint(truncate(path, 32 + 99), ==, 0);
+    g_assert_null(FieldVector::open(path));
+    g_assert_cmpint(truncate(path, 16), ==, 0);
+    g_assert_null(FieldVector::open(path));
+
+    g_assert_true(v.save(path));
+    fd = open(path, O_WRONLY);
+    g_assert_cmpint(pwrite(fd, "X", 1, 0), ==, 1);
+    close(fd);
+    g_assert_null(FieldVector::open(path));
+
+    unlink(path);
+    g_assert_null(FieldVector::open(path));
+}
+
+// The S-box straight from FIPS 197: invert, then the affine map.
+static uint8_t reference_sbox(uint8_t x) {
+    uint8_t b = 0;
+    if (x)
+        b = multiplicative_inverse(Polynomial{x}).value();
+    uint8_t s = 0x63;
+    for (int i = 0; i < 8; ++i) {
+        int bit = ((b >> i) ^ (b >> ((i + 4) % 8)) ^ (b >> ((i + 5) % 8)) ^
+                   (b >> ((i + 6) % 8)) ^ (b >> ((i + 7) % 8))) & 1;
+        s ^= static_cast<uint8_t>(bit << i);
+    }
+    return s;
+}
+
+static void aes_sbox() {
+    RegionKernel original = region_kernel();
+
+    uint8_t sbox[256];
+    uint8_t inverse[256];
+    for (unsigned int x = 0; x < 256; ++x) {
+        sbox[x] = reference_sbox(static_cast<uint8_t>(x));
+        inverse[sbox[x]] = static_cast<uint8_t>(x);
+    }
+    g_assert_cmpuint(sbox[0x00], ==, 0x63);
+    g_assert_cmpuint(sbox[0x53], ==, 0xed);
+
+    for (RegionKernel kernel : region_kernels) {
+        if (!set_region_kernel(kernel))
+            continue;
+
+        // Every input, at every offset within a block, with tails of every
+        // kind.
+        for (size_t len : { 0, 1, 63, 64, 65, 255, 256, 257, 1000 }) {
+            std::vector<uint8_t> src(len);
+            for (size_t i = 0; i < len; ++i)
+                src[i] = static_cast<uint8_t>(i * 7 + len);
+
+            std::vector<uint8_t> dst(len);
+            aes_sub_bytes(dst.data(), src.data(), len);
+            for (size_t i = 0; i < len; ++i)
+                g_assert_cmpuint(dst[i], ==, sbox[src[i]]);
+
+            std::vector<uint8_t> back(len);
+            aes_inv_sub_bytes(back.data(), dst.data(), len);
+            for (size_t i = 0; i < len; ++i)
+                g_assert_cmpuint(back[i], ==, src[i]);
+
+            // In place.
+            aes_inv_sub_bytes(src.data(), src.data(), len);
+            for (size_t i = 0; i < len; ++i)
+                g_assert_cmpuint(src[i], ==, inverse[static_cast<uint8_t>(i * 7 + len)]);
+        }
+    }
+
+    set_region_kernel(original);
+}
+
+static void factor_integers() {
+    std::vector<PrimePower> factors = factor(~uint64_t{0});
+    const uint64_t expected[] = { 3, 5, 17, 257, 641, 65537, 6700417 };
+    g_assert_cmpuint(factors.size(), ==, sizeof(expected) / sizeof(expected[0]));
+    for (size_t i = 0; i < factors.size(); ++i) {
+        g_assert_cmpuint(factors[i].prime, ==, expected[i]);
+        g_assert_cmpuint(factors[i].exponent, ==, 1);
+    }
+
+    g_assert_true(factor(1).empty());
+    g_assert_true(is_prime((uint64_t{1} << 61) - 1));
+    g_assert_false(is_prime((uint64_t{1} << 59) - 1));
+    // The smallest strong pseudoprime to bases 2 through 11.
+    g_assert_false(is_prime(2152302898747ull));
+    g_assert_true(is_prime(18446744073709551557ull));
+
+    // Products of two large primes are the hard case for Pollard's rho.
+    uint64_t n = 4294967291ull * 4294967279ull;
+    factors = factor(n);
+    g_assert_cmpuint(factors.size(), ==, 2);
+    g_assert_cmpuint(factors[0].prime, ==, 4294967279ull);
+    g_assert_cmpuint(factors[1].prime, ==, 4294967291ull);
+
+    for (int i = 0; i < 1000; ++i) {
+        uint64_t m = random_word<uint64_t>() >> (i % 64);
+        if (m == 0)
+            continue;
+        uint64_t product = 1;
+        for (const PrimePower& p : factor(m)) {
+            g_assert_true(is_prime(p.prime));
+            for (unsigned int e = 0; e < p.exponent; ++e)
+                product *= p.prime;
+        }
+        g_assert_cmpuint(product, ==, m);
+    }
+}
+
+static void irreducible_counts() {
+    // OEIS A001037 and A011260.
+    const size_t irreducible[] = { 0, 2, 1, 2, 3, 6, 9, 18, 30, 56, 99, 186, 335 };
+    const size_t primitive[] = { 0, 1, 1, 2, 2, 6, 6, 18, 16, 48, 60, 176, 144 };
+    ClmulKernel original = clmul_kernel();
+
+    for (ClmulKernel kernel : { ClmulKernel::Portable, ClmulKernel::PCLMULQDQ }) {
+        if (!set_clmul_kernel(kernel))
+            continue;
+
+        for (int n = 1; n <= 12; ++n) {
+            std::vector<uint64_t> found = enumerate_irreducible_polynomials(n, SIZE_MAX);
+            g_assert_cmpuint(found.size(), ==, irreducible[n]);
+            g_assert_cmpuint(enumerate_primitive_polynomials(n, SIZE_MAX).size(), ==, primitive[n]);
+
+            // Both tests had better agree on every candidate, not just the
+            // irreducible ones.
+            for (uint64_t p = 0; p < (uint64_t{1} << n); ++p) {
+                bool expected = std::binary_search(found.begin(), found.end(), p);
+                g_assert_cmpint(is_irreducible(p, n, IrreducibilityTest::BenOr), ==, expected);
+                g_assert_cmpint(is_irreducible(p, n, IrreducibilityTest::Rabin), ==, expected);
+                if (n <= 8) {
+                    uint16_t ip = static_cast<uint16_t>((1u << n) | p);
+                    g_assert_cmpint(FieldTables::get(ip, n) != nullptr, ==, expected);
+                }
+            }
+        }
+    }
+
+    set_clmul_kernel(original);
+
+    g_assert_false(is_irreducible(0b11, 1));
+    g_assert_false(is_irreducible(0x1b, 0));
+    g_assert_false(is_irreducible(0x1b, 65));
+}
+
+static void irreducible_search() {
+    for (int n = 1; n <= 12; ++n) {
+        // The sparsest, and then the smallest.
+        auto sparser = [](uint64_t a, uint64_t b) {
+            int a_weight = __builtin_popcountll(a);
+            int b_weight = __builtin_popcountll(b);
+            return a_weight < b_weight || (a_weight == b_weight && a < b);
+        };
+        std::vector<uint64_t> all = enumerate_irreducible_polynomials(n, SIZE_MAX);
+        g_assert_cmpuint(find_irreducible_polynomial(n), ==, *std::min_element(all.begin(), all.end(), sparser));
+        all = enumerate_primitive_polynomials(n, SIZE_MAX);
+        g_assert_cmpuint(find_primitive_polynomial(n), ==, *std::min_element(all.begin(), all.end(), sparser));
+    }
+
+    g_assert_cmpuint(find_irreducible_polynomial(8), ==, 0x1b);
+    g_assert_cmpuint(find_irreducible_polynomial(32), ==, WideField<uint32_t>::default_irreducible_polynomial);
+    g_assert_cmpuint(find_irreducible_polynomial(64), ==, WideField<uint64_t>::default_irreducible_polynomial);
+    g_assert_true(is_irreducible(WideField<uint16_t>::default_irreducible_polynomial, 16));
+    g_assert_true(is_irreducible(WideField<uint32_t>::default_irreducible_polynomial, 32));
+    g_assert_true(is_irreducible(WideField<uint64_t>::default_irreducible_polynomial, 64));
+    // AES's polynomial is irreducible, but x has order 51.
+    g_assert_true(is_irreducible(0x1b, 8));
+    g_assert_false(is_primitive(0x1b, 8));
+    g_assert_true(is_primitive(0x1d, 8));
+
+    // Parallel searches find the same thing, in the same order, including
+    // when they stop partway through a round.
+    ThreadPool pool{4};
+    for (int n : { 16, 20, 33, 64 }) {
+        for (size_t count : { 1, 10, 700 }) {
+            std::vector<uint64_t> serial = enumerate_irreducible_polynomials(n, count);
+            g_assert_cmpuint(serial.size(), ==, count);
+            g_assert_true(enumerate_irreducible_polynomials(n, count, &pool) == serial);
+            for (uint64_t p : serial)
+                g_assert_true(is_irreducible(p, n, IrreducibilityTest::Rabin));
+        }
+        g_assert_true(enumerate_primitive_polynomials(n, 50, &pool) == enumerate_primitive_polynomials(n, 50));
+        g_assert_true(is_primitive(find_primitive_polynomial(n), n));
+    }
+}
+
+static void field_descriptor() {
+    for (int n = 1; n <= 8; ++n) {
+        for (uint64_t p : enumerate_irreducible_polynomials(n, SIZE_MAX)) {
+            const FieldDescriptor* field = FieldDescriptor::get(p, n);
+            g_assert_nonnull(field);
+            g_assert_true(FieldDescriptor::get(p, n) == field);
+            g_assert_cmpuint(field->order(), ==, (1u << n) - 1);
+            g_assert_cmpint(field->primitive(), ==, is_primitive(p, n));
+
+            // Count each element's order the slow way.
+            uint16_t ip = static_cast<uint16_t>((1u << n) | p);
+            uint64_t smallest_generator = 0;
+            for (unsigned int a = 1; a < (1u << n); ++a) {
+                uint64_t order = 1;
+                for (uint8_t power = static_cast<uint8_t>(a); power != 1; ++order)
+                    power = multiply_bitwise(power, static_cast<uint8_t>(a), ip, n);
+                g_assert_cmpuint(field->element_order(a), ==, order);
+                g_assert_cmpint(field->is_generator(a), ==, order == field->order());
+                if (order == field->order() && smallest_generator == 0)
+                    smallest_generator = a;
+
+                for (unsigned int b = 0; b < (1u << n); ++b)
+                    g_assert_cmpuint(field->multiply(a, b), ==, multiply_bitwise(a, b, ip, n));
+            }
+            g_assert_cmpuint(field->generator(), ==, smallest_generator);
+        }
+    }
+
+    g_assert_null(FieldDescriptor::get(0b01, 2));
+    g_assert_null(FieldDescriptor::get(0b01, 2));
+    g_assert_null(FieldDescriptor::get(0x100, 8));
+
+    // And the wide fields agree with WidePolynomial.
+    const FieldDescriptor* field = FieldDescriptor::get(WideField<uint64_t>::default_irreducible_polynomial, 64);
+    g_assert_nonnull(field);
+    g_assert_cmpuint(field->order(), ==, ~uint64_t{0});
+    g_assert_cmpuint(field->order_factors().size(), ==, 7);
+    g_assert_true(field->is_generator(field->generator()));
+    g_assert_cmpuint(field->power(field->generator(), field->order()), ==, 1);
+    for (int i = 0; i < 1000; ++i) {
+        uint64_t a = random_word<uint64_t>() | 1;
+        uint64_t b = random_word<uint64_t>();
+        g_assert_cmpuint(field->multiply(a, b), ==, (Polynomial64{a} * Polynomial64{b}).value());
+        uint64_t order = field->element_order(a);
+        g_assert_cmpuint(field->power(a, order), ==, 1);
+        g_assert_cmpuint(field->order() % order, ==, 0);
+    }
+}
+
+static void discrete_log() {
+    // Every element against every base, by brute force, in small fields.
+    for (int n = 1; n <= 8; ++n) {
+        for (uint64_t p : enumerate_irreducible_polynomials(n, n <= 6 ? SIZE_MAX : 2)) {
+            const FieldDescriptor* field = FieldDescriptor::get(p, n);
+            uint16_t ip = static_cast<uint16_t>((1u << n) | p);
+
+            for (unsigned int base = 1; base < (1u << n); ++base) {
+                // logs[a] is the first k with base^k == a, or -1.
+                std::vector<int> logs(1u << n, -1);
+                uint8_t power = 1;
+                unsigned int order = 0;
+                do {
+                    logs[power] = order++;
+                    power = multiply_bitwise(power, static_cast<uint8_t>(base), ip, n);
+                } while (power != 1);
+
+                Polynomial b{static_cast<uint8_t>(base), ip, n};
+                g_assert_cmpuint(element_order(b), ==, order);
+                g_assert_cmpint(is_generator(b), ==, order == field->order());
+
+                for (unsigned int a = 1; a < (1u << n); ++a) {
+                    unsigned int log = 0;
+                    g_assert_cmpint(discrete_log(Polynomial{static_cast<uint8_t>(a), ip, n}, b, log), ==, logs[a] >= 0);
+                    uint64_t wide_log = 0;
+                    g_assert_cmpint(field->discrete_log(a, base, wide_log), ==, logs[a] >= 0);
+                    if (logs[a] >= 0) {
+                        g_assert_cmpuint(log, ==, logs[a]);
+                        g_assert_cmpuint(wide_log, ==, logs[a]);
+                    }
+                }
+            }
+        }
+    }
+
+    // And in big ones, where all we can do is check the answers. 2^49 - 1 has
+    // a prime factor too big to tabulate all the baby steps for, which makes
+    // it slow, so it only gets a couple.
+    for (int n : { 12, 16, 24, 31, 32, 40, 48, 49, 63, 64 }) {
+        const FieldDescriptor* field = FieldDescriptor::get(find_irreducible_polynomial(n), n);
+        uint64_t mask = field->order();
+        for (int i = 0; i < (n == 49 ? 2 : 10); ++i) {
+            uint64_t a = (random_word<uint64_t>() & mask) | 1;
+            uint64_t log = field->discrete_log(a);
+            g_assert_cmpuint(log, <, field->order());
+            g_assert_cmpuint(field->power(field->generator(), log), ==, a);
+        }
+
+        uint64_t base = (random_word<uint64_t>() & mask) | 2;
+        uint64_t a = field->power(base, random_word<uint64_t>());
+        uint64_t log = 0;
+        g_assert_true(field->discrete_log(a, base, log));
+        g_assert_cmpuint(log, <, field->element_order(base));
+        g_assert_cmpuint(field->power(base, log), ==, a);
+
+        // Nothing in a proper subgroup generates the whole group.
+        uint64_t small = field->power(field->generator(), field->order_factors()[0].prime);
+        g_assert_false(field->discrete_log(field->generator(), small, log));
+    }
+}
+
+static const FieldStats* find_field_stats(const std::vector<FieldStats>& stats, uint16_t ip, int characteristic) {
+    for (const FieldStats& field : stats) {
+        if (field.irreducible_polynomial == ip && field.characteristic == characteristic)
+            return &field;
+    }
+    return nullptr;
+}
+
+static void instrumentation_counts() {
+    reset_instrumentation_stats();
+    if (!instrumentation_enabled()) {
+        // Nothing counted, and nothing to see.
+        Polynomial p{3};
+        p *= p;
+        g_assert_true(instrumentation_stats().empty());
+        return;
+    }
+
+    const uint16_t ip = irreducible_polynomials[5];
+    const auto multiply = static_cast<size_t>(InstrumentedOperation::Multiply);
+    const auto inverse = static_cast<size_t>(InstrumentedOperation::Inverse);
+    const auto mul_region = static_cast<size_t>(InstrumentedOperation::MulRegion);
+    const auto batch = static_cast<size_t>(InstrumentedOperation::InverseBatch);
+    const auto zero = static_cast<size_t>(InstrumentedOperation::InverseOfZero);
+
+    // Enough multiplications that some get timed, on this thread and on
+    // another that exits before we look.
+    Polynomial p{3, ip, 5};
+    for (int i = 0; i < 1000; ++i)
+        p *= Polynomial{7, ip, 5};
+    std::thread([ip] {
+        Polynomial q{3, ip, 5};
+        for (int i = 0; i < 500; ++i)
+            q *= Polynomial{7, ip, 5};
+    }).join();
+    for (int i = 1; i < 32; ++i)
+        multiplicative_inverse(Polynomial{static_cast<uint8_t>(i), ip, 5}, InverseStrategy::Table);
+    multiplicative_inverse(Polynomial{0, ip, 5}, InverseStrategy::ConstantTime);
+
+    std::vector<uint8_t> bytes(100);
+    for (size_t i = 0; i < bytes.size(); ++i)
+        bytes[i] = static_cast<uint8_t>(i % 31 + 1);
+    bytes[7] = 0;
+    bytes[8] = 0;
+    gf_mul_region(bytes.data(), bytes.data(), 3, bytes.size(), ip, 5);
+    multiplicative_inverse_batch(bytes.data(), bytes.data(), bytes.size(), ip, 5);
+
+    std::vector<FieldStats> stats = instrumentation_stats();
+    const FieldStats* field = find_field_stats(stats, ip, 5);
+    g_assert_nonnull(field);
+    g_assert_cmpuint(field->operations[multiply].calls, ==, 1500);
+    g_assert_cmpuint(field->operations[inverse].calls, ==, 32);
+    g_assert_cmpuint(field->operations[mul_region].calls, ==, 1);
+    g_assert_cmpuint(field->operations[mul_region].elements, ==, 100);
+    g_assert_cmpuint(field->operations[batch].elements, ==, 100);
+#ifdef MULTINV_CONSTANT_TIME
+    // Only the zeros in the batch; the single inverse can't look.
+    g_assert_cmpuint(field->operations[zero].calls, ==, 1);
+    g_assert_cmpuint(field->operations[zero].elements, ==, 2);
+#else
+    g_assert_cmpuint(field->operations[zero].calls, ==, 2);
+    g_assert_cmpuint(field->operations[zero].elements, ==, 3);
+#endif
+
+    uint64_t samples = 0;
+    for (uint64_t count : field->operations[multiply].latency)
+        samples += count;
+    g_assert_cmpuint(samples, >, 0);
+
+    // Resetting starts over, without forgetting the fields.
+    reset_instrumentation_stats();
+    p *= p;
+    stats = instrumentation_stats();
+    g_assert_cmpuint(stats.size(), ==, 1);
+    g_assert_cmpuint(stats[0].operations[multiply].calls, ==, 1);
+}
+
 int main(int argc, char *argv[]) {
     setlocale(LC_ALL, "");
 
@@ -200,6 +1883,49 @@ int main(int argc, char *argv[]) {
     g_test_add_func("/Polynomial/multiply4", multiply4);
     g_test_add_func("/Polynomial/multiply5", multiply5);
     g_test_add_func("/Polynomial/multiplication-table", multiplication_table);
+    g_test_add_func("/Polynomial/inverse1", inverse1);
+    g_test_add_func("/Polynomial/inverse2", inverse2);
+    g_test_add_func("/Polynomial/inverse-strategies", inverse_strategies);
+    g_test_add_func("/Polynomial/divide", divide);
+    g_test_add_func("/Polynomial/pow-square-sqrt", pow_square_sqrt);
+    g_test_add_func("/Polynomial/constant-time/multiply", multiply_constant_time_matches_bitwise);
+    g_test_add_func("/Polynomial/constant-time/inverse-zero", inverse_constant_time_zero);
+    g_test_add_func("/Polynomial/unreduced", unreduced_products);
+    g_test_add_func("/FieldTables/cached", field_tables_cached);
+    g_test_add_func("/FieldTables/not-a-field", field_tables_not_a_field);
+    g_test_add_func("/FieldTables/arithmetic", field_tables_arithmetic);
+    g_test_add_func("/GF/matches-polynomial", gf_matches_polynomial);
+    g_test_add_func("/region/kernels-match-polynomial", region_kernels_match_polynomial);
+    g_test_add_func("/region/matrix-matches-polynomial", region_matrix_matches_polynomial);
+    g_test_add_func("/WidePolynomial/arithmetic", wide_polynomial);
+    g_test_add_func("/WidePolynomial/inverse16", wide_polynomial_inverse16);
+    g_test_add_func("/Crc/check-values", crc_check_values);
+    g_test_add_func("/Crc/kernels", crc_kernels_agree);
+    g_test_add_func("/batch-inverse/polynomial", batch_inverse);
+    g_test_add_func("/batch-inverse/wide-polynomial", wide_batch_inverse);
+    g_test_add_func("/ThreadPool/parallel-for", thread_pool_parallel_for);
+    g_test_add_func("/parallel/bulk-operations", parallel_bulk_operations);
+    g_test_add_func("/parallel/matrix-vector", parallel_matrix_vector_product);
+    g_test_add_func("/FieldPolynomial/arithmetic", field_polynomial_arithmetic);
+    g_test_add_func("/FieldPolynomial/multiply", field_polynomial_multiply);
+    g_test_add_func("/FieldPolynomial/divmod", field_polynomial_divmod);
+    g_test_add_func("/FieldPolynomial/gcd", field_polynomial_gcd);
+    g_test_add_func("/FieldPolynomial/evaluate", field_polynomial_evaluate);
+    g_test_add_func("/FieldMatrix/multiply", field_matrix_multiply);
+    g_test_add_func("/FieldMatrix/row-reduce", field_matrix_row_reduce);
+    g_test_add_func("/FieldMatrix/invert", field_matrix_invert);
+    g_test_add_func("/FieldVector/elements", field_vector_elements);
+    g_test_add_func("/FieldVector/bulk", field_vector_bulk);
+    g_test_add_func("/FieldVector/file", field_vector_file);
+    g_test_add_func("/ReedSolomon/encode-decode", reed_solomon);
+    g_test_add_func("/Shamir/split-combine", shamir);
+    g_test_add_func("/AES/sbox", aes_sbox);
+    g_test_add_func("/factor/integers", factor_integers);
+    g_test_add_func("/irreducible/counts", irreducible_counts);
+    g_test_add_func("/irreducible/search", irreducible_search);
+    g_test_add_func("/FieldDescriptor/orders", field_descriptor);
+    g_test_add_func("/FieldDescriptor/discrete-log", discrete_log);
+    g_test_add_func("/instrumentation/counts", instrumentation_counts);
 
     return g_test_run();
 }